@@ -0,0 +1,276 @@
+/******************************************************************************/
+/* ファイル名 : checksum_bench.c                                              */
+/* 機能概要   : チェックサム計算 試験/性能測定プログラム                      */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+
+#include "m46eapp_util.h"
+
+//! 試験/測定する加算処理
+static const char* bench_kernels[] = { "scalar64", "sse2", "avx2" };
+//! 測定するデータ長(IPv4ヘッダ、最小フレーム、IPv4最小MTU、Ethernet MTU、ジャンボフレーム)
+static const int   bench_lengths[] = { 20, 64, 576, 1500, 9000 };
+//! ランダム試験の回数
+#define BENCH_RANDOM_COUNT   200000
+//! ランダム試験の最大ブロック数
+#define BENCH_RANDOM_IOV_MAX 8
+//! ランダム試験の最大ブロック長
+#define BENCH_RANDOM_LEN_MAX 2048
+//! 試験用バッファのサイズ(SIMD処理の部分和の畳み込みを越える長さを含む)
+#define BENCH_BUF_SIZE       (4 * 1024 * 1024)
+//! 性能測定の合計データ量(byte)
+#define BENCH_TOTAL_BYTES    (256 * 1024 * 1024)
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 現在時刻取得関数
+//!
+//! @return 単調増加時刻(ns)
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 参照用チェックサム加算関数
+//!
+//! SIMD化以前の16bit単位の加算処理。
+//! (非アラインのアドレスでも動作するようにmemcpyで読み込む)
+//!
+//! @param [in]  buf  加算するデータの先頭アドレス
+//! @param [in]  size 加算するデータのサイズ
+//!
+//! @return 加算結果
+///////////////////////////////////////////////////////////////////////////////
+static unsigned long bench_ref_add(const unsigned char* buf, int size)
+{
+    unsigned long  sum = 0;
+    unsigned short val;
+
+    while (size > 1) {
+        memcpy(&val, buf, sizeof(val));
+        sum  += val;
+        buf  += 2;
+        size -= 2;
+    }
+    if (size){
+        sum += *(u_int8_t *)buf;
+    }
+
+    return sum;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 参照用チェックサム計算関数(複数ブロック対応)
+//!
+//! SIMD化以前のm46e_util_checksumv()と同じ計算をおこなう。
+//!
+//! @param [in]  vec      チェックサムを計算するコード配列の先頭アドレス
+//! @param [in]  vec_size チェックサムを計算するコード配列の要素数
+//!
+//! @return 計算したチェックサム値
+///////////////////////////////////////////////////////////////////////////////
+static unsigned short bench_ref_checksumv(struct iovec* vec, int vec_size)
+{
+    unsigned long sum = 0;
+
+    for(int i = 0; i < vec_size; i++){
+        sum += bench_ref_add(vec[i].iov_base, vec[i].iov_len);
+    }
+
+    sum  = (sum & 0xffff) + (sum >> 16);	/* add overflow counts */
+    sum  = (sum & 0xffff) + (sum >> 16);	/* once again */
+
+    return ~sum;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 一様乱数取得関数
+//!
+//! @param [in]  max  上限値(この値を含む)
+//!
+//! @return 0以上max以下の乱数
+///////////////////////////////////////////////////////////////////////////////
+static int bench_rand(const int max)
+{
+    return (int)(((uint64_t)rand() * (max + 1)) / ((uint64_t)RAND_MAX + 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 加算処理ごとの正当性試験関数
+//!
+//! 参照実装と以下の結果を比較する。
+//! - ランダムな長さ/奇数オフセット/奇数長の末尾を持つ複数ブロック
+//! - 単一ブロック(m46e_util_checksum)
+//! - SIMD処理の部分和の畳み込みを越える長さの0xffデータ
+//!
+//! @param [in]  kernel  加算処理の名前
+//! @param [in]  buf     ランダムデータを格納した試験用バッファ
+//! @param [in]  ones    0xffを格納した試験用バッファ
+//!
+//! @return 不一致の件数
+///////////////////////////////////////////////////////////////////////////////
+static int bench_verify(const char* kernel, unsigned char* buf, unsigned char* ones)
+{
+    // ローカル変数宣言
+    struct iovec vec[BENCH_RANDOM_IOV_MAX];
+    int          error = 0;
+
+    for(int i = 0; i < BENCH_RANDOM_COUNT; i++){
+        int vec_size = 1 + bench_rand(BENCH_RANDOM_IOV_MAX - 1);
+
+        for(int j = 0; j < vec_size; j++){
+            int len    = bench_rand(BENCH_RANDOM_LEN_MAX);
+            int offset = bench_rand(BENCH_BUF_SIZE - BENCH_RANDOM_LEN_MAX - 1);
+            vec[j].iov_base = buf + offset;
+            vec[j].iov_len  = len;
+        }
+
+        unsigned short expect = bench_ref_checksumv(vec, vec_size);
+        unsigned short result = m46e_util_checksumv(vec, vec_size);
+        if(result != expect){
+            if(error < 10){
+                printf("%s: checksumv mismatch (iov=%d, first offset=%td, len=%zu): 0x%04x != 0x%04x\n",
+                    kernel, vec_size, (unsigned char*)vec[0].iov_base - buf, vec[0].iov_len, result, expect);
+            }
+            error++;
+        }
+
+        expect = bench_ref_checksumv(vec, 1);
+        result = m46e_util_checksum(vec[0].iov_base, vec[0].iov_len);
+        if(result != expect){
+            if(error < 10){
+                printf("%s: checksum mismatch (offset=%td, len=%zu): 0x%04x != 0x%04x\n",
+                    kernel, (unsigned char*)vec[0].iov_base - buf, vec[0].iov_len, result, expect);
+            }
+            error++;
+        }
+    }
+
+    // 32bitレーンの部分和があふれる長さを奇数オフセット/奇数長で試験する
+    for(int i = 0; i < 4; i++){
+        vec[0].iov_base = ones + i;
+        vec[0].iov_len  = BENCH_BUF_SIZE - 8 + i;
+
+        unsigned short expect = bench_ref_checksumv(vec, 1);
+        unsigned short result = m46e_util_checksumv(vec, 1);
+        if(result != expect){
+            printf("%s: large block mismatch (offset=%d, len=%zu): 0x%04x != 0x%04x\n",
+                kernel, i, vec[0].iov_len, result, expect);
+            error++;
+        }
+    }
+
+    return error;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief データ長ごとの性能測定関数
+//!
+//! @param [in]  kernel  加算処理の名前(NULLの場合は参照実装)
+//! @param [in]  buf     測定用バッファ
+//! @param [in]  len     データ長
+//!
+//! @return 1回あたりの処理時間(ns)
+///////////////////////////////////////////////////////////////////////////////
+static double bench_measure(const char* kernel, unsigned char* buf, const int len)
+{
+    // ローカル変数宣言
+    struct iovec      vec   = { .iov_base = buf, .iov_len = len };
+    int               count = BENCH_TOTAL_BYTES / len;
+    volatile unsigned sink  = 0;
+    uint64_t          start;
+
+    start = bench_now();
+    for(int i = 0; i < count; i++){
+        if(kernel == NULL){
+            sink += bench_ref_checksumv(&vec, 1);
+        }
+        else{
+            sink += m46e_util_checksumv(&vec, 1);
+        }
+    }
+
+    return (double)(bench_now() - start) / count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム試験/性能測定 メイン関数
+//!
+//! CPUが対応する加算処理を順に強制選択し、参照実装との一致を試験した後、
+//! データ長ごとの処理時間を測定する。
+//!
+//! @retval 0       正常終了
+//! @retval 0以外   不一致あり
+///////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+    // ローカル変数宣言
+    unsigned char* buf;
+    unsigned char* ones;
+    int            error = 0;
+    const int      kernel_num = sizeof(bench_kernels) / sizeof(bench_kernels[0]);
+    const int      length_num = sizeof(bench_lengths) / sizeof(bench_lengths[0]);
+
+    buf  = malloc(BENCH_BUF_SIZE);
+    ones = malloc(BENCH_BUF_SIZE);
+    if((buf == NULL) || (ones == NULL)){
+        printf("memory allocation failed\n");
+        return 1;
+    }
+
+    srand(1);
+    for(int i = 0; i < BENCH_BUF_SIZE; i++){
+        buf[i] = rand() & 0xff;
+    }
+    memset(ones, 0xff, BENCH_BUF_SIZE);
+
+    // 正当性試験
+    for(int i = 0; i < kernel_num; i++){
+        if(!m46e_util_checksum_select(bench_kernels[i])){
+            printf("%-8s: not supported, skipped\n", bench_kernels[i]);
+            continue;
+        }
+        int kernel_error = bench_verify(bench_kernels[i], buf, ones);
+        printf("%-8s: %s (%d mismatches)\n", bench_kernels[i], (kernel_error == 0) ? "OK" : "NG", kernel_error);
+        error += kernel_error;
+    }
+
+    // 性能測定(奇数オフセットで測定する)
+    printf("\n%-8s", "ns/call");
+    for(int j = 0; j < length_num; j++){
+        printf(" %9d", bench_lengths[j]);
+    }
+    printf("\n%-8s", "ref16");
+    for(int j = 0; j < length_num; j++){
+        printf(" %9.1f", bench_measure(NULL, buf + 1, bench_lengths[j]));
+    }
+    printf("\n");
+    for(int i = 0; i < kernel_num; i++){
+        if(!m46e_util_checksum_select(bench_kernels[i])){
+            continue;
+        }
+        printf("%-8s", bench_kernels[i]);
+        for(int j = 0; j < length_num; j++){
+            printf(" %9.1f", bench_measure(bench_kernels[i], buf + 1, bench_lengths[j]));
+        }
+        printf("\n");
+    }
+
+    free(ones);
+    free(buf);
+
+    return (error == 0) ? 0 : 1;
+}
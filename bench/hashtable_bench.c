@@ -0,0 +1,257 @@
+/******************************************************************************/
+/* ファイル名 : hashtable_bench.c                                             */
+/* 機能概要   : ハッシュテーブル 性能測定プログラム                           */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "m46eapp_hashtable.h"
+
+//! 測定する要素数
+static const uint32_t bench_entry_nums[] = { 1000, 100000, 1000000 };
+//! 検索の測定回数(要素数がこれより小さい場合は要素数の倍数分繰り返す)
+#define BENCH_LOOKUP_OPS     2000000
+//! テーブルの初期サイズ(PMTU管理テーブルと同じ値)
+#define BENCH_TABLE_SIZE     128
+
+////////////////////////////////////////////////////////////////////////////////
+//! 測定用バリュー(PMTU管理データ相当のサイズ)
+////////////////////////////////////////////////////////////////////////////////
+struct bench_value
+{
+    int        mtu;
+    uint64_t   timerid;
+    int        probe_mtu;
+    uint64_t   probe_time;
+    uint64_t   probe_timerid;
+};
+typedef struct bench_value bench_value;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 測定用キー(PMTUのキーと同じくIPv6アドレスの文字列)
+////////////////////////////////////////////////////////////////////////////////
+struct bench_key
+{
+    char       str[INET6_ADDRSTRLEN];
+    size_t     len;
+};
+typedef struct bench_key bench_key;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 現在時刻取得関数
+//!
+//! @return 単調増加時刻(ns)
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 測定用キー生成関数
+//!
+//! 2001:db8::/32配下のアドレスを番号から生成し、文字列化する。
+//!
+//! @param [in]     num     キー番号
+//! @param [in]     miss    trueの場合は登録キーと重ならない番号空間で生成する
+//! @param [out]    key     生成したキー
+///////////////////////////////////////////////////////////////////////////////
+static void bench_make_key(const uint32_t num, const bool miss, bench_key* key)
+{
+    struct in6_addr addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.s6_addr[0]  = 0x20;
+    addr.s6_addr[1]  = 0x01;
+    addr.s6_addr[2]  = 0x0d;
+    addr.s6_addr[3]  = 0xb8;
+    addr.s6_addr[4]  = miss ? 0xff : 0x00;
+    addr.s6_addr[12] = (num >> 24) & 0xff;
+    addr.s6_addr[13] = (num >> 16) & 0xff;
+    addr.s6_addr[14] = (num >>  8) & 0xff;
+    addr.s6_addr[15] = num & 0xff;
+
+    inet_ntop(AF_INET6, &addr, key->str, sizeof(key->str));
+    key->len = strlen(key->str) + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 配列シャッフル関数
+//!
+//! @param [in,out] order   シャッフルする番号配列
+//! @param [in]     num     配列の要素数
+///////////////////////////////////////////////////////////////////////////////
+static void bench_shuffle(uint32_t* order, const uint32_t num)
+{
+    for(uint32_t i = num - 1; i > 0; i--){
+        uint32_t j   = (uint32_t)(((uint64_t)rand() * (i + 1)) / ((uint64_t)RAND_MAX + 1));
+        uint32_t tmp = order[i];
+        order[i]     = order[j];
+        order[j]     = tmp;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素数ごとの測定関数
+//!
+//! 挿入、検索(ヒット/ミス)、削除、再挿入の1操作あたりの平均時間を表示する。<br/>
+//! 挿入はテーブルの拡張とページの初回アクセスを含み、再挿入は含まない。
+//!
+//! @param [in]     num     測定する要素数
+//!
+//! @retval 0       正常終了
+//! @retval 0以外   異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int bench_run(const uint32_t num)
+{
+    // ローカル変数宣言
+    m46e_hashtable_t* table;
+    bench_key*        keys;
+    bench_key*        miss_keys;
+    uint32_t*         order;
+    bench_value       value;
+    uint64_t          start;
+    uint64_t          insert_ns;
+    uint64_t          hit_ns;
+    uint64_t          miss_ns;
+    uint64_t          remove_ns;
+    uint64_t          reinsert_ns;
+    uint32_t          rounds;
+    uint32_t          found = 0;
+    int               ret   = -1;
+
+    keys      = malloc(sizeof(bench_key) * num);
+    miss_keys = malloc(sizeof(bench_key) * num);
+    order     = malloc(sizeof(uint32_t) * num);
+    table     = m46e_hashtable_create(BENCH_TABLE_SIZE);
+    if((keys == NULL) || (miss_keys == NULL) || (order == NULL) || (table == NULL)){
+        printf("%u entries: memory allocation failed\n", num);
+        goto end;
+    }
+
+    for(uint32_t i = 0; i < num; i++){
+        bench_make_key(i, false, &keys[i]);
+        bench_make_key(i, true,  &miss_keys[i]);
+        order[i] = i;
+    }
+    bench_shuffle(order, num);
+    memset(&value, 0, sizeof(value));
+
+    // 挿入
+    start = bench_now();
+    for(uint32_t i = 0; i < num; i++){
+        value.mtu = i;
+        if(!m46e_hashtable_add(table, keys[i].str, keys[i].len, &value, sizeof(value), false, NULL, NULL)){
+            printf("%u entries: add failed at %u\n", num, i);
+            goto end;
+        }
+    }
+    insert_ns = bench_now() - start;
+
+    // 検索(ヒット)
+    rounds = (num < BENCH_LOOKUP_OPS) ? (BENCH_LOOKUP_OPS / num) : 1;
+    start = bench_now();
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t i = 0; i < num; i++){
+            bench_key*   key  = &keys[order[i]];
+            bench_value* data = m46e_hashtable_get(table, key->str, key->len);
+            found += (data != NULL) && (data->mtu == (int)order[i]);
+        }
+    }
+    hit_ns = bench_now() - start;
+    if(found != rounds * num){
+        printf("%u entries: lookup mismatch (%u/%u)\n", num, found, rounds * num);
+        goto end;
+    }
+
+    // 検索(ミス)
+    found = 0;
+    start = bench_now();
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t i = 0; i < num; i++){
+            bench_key* key = &miss_keys[order[i]];
+            found += (m46e_hashtable_get(table, key->str, key->len) != NULL);
+        }
+    }
+    miss_ns = bench_now() - start;
+    if(found != 0){
+        printf("%u entries: unexpected hit (%u)\n", num, found);
+        goto end;
+    }
+
+    // 削除
+    start = bench_now();
+    for(uint32_t i = 0; i < num; i++){
+        bench_key* key = &keys[order[i]];
+        if(!m46e_hashtable_remove(table, key->str, key->len, NULL)){
+            printf("%u entries: remove failed at %u\n", num, i);
+            goto end;
+        }
+    }
+    remove_ns = bench_now() - start;
+
+    // 再挿入(テーブルは縮小しないので、拡張済みのテーブルへの定常状態の挿入となる)
+    start = bench_now();
+    for(uint32_t i = 0; i < num; i++){
+        bench_key* key = &keys[order[i]];
+        value.mtu = order[i];
+        if(!m46e_hashtable_add(table, key->str, key->len, &value, sizeof(value), false, NULL, NULL)){
+            printf("%u entries: re-add failed at %u\n", num, i);
+            goto end;
+        }
+    }
+    reinsert_ns = bench_now() - start;
+
+    printf("%8u entries: insert %7.1f ns/op, lookup(hit) %7.1f ns/op, lookup(miss) %7.1f ns/op, remove %7.1f ns/op, reinsert %7.1f ns/op\n",
+        num,
+        (double)insert_ns   / num,
+        (double)hit_ns      / ((double)rounds * num),
+        (double)miss_ns     / ((double)rounds * num),
+        (double)remove_ns   / num,
+        (double)reinsert_ns / num
+    );
+    ret = 0;
+
+end:
+    if(table != NULL){
+        m46e_hashtable_delete(table);
+    }
+    free(order);
+    free(miss_keys);
+    free(keys);
+
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ハッシュテーブル性能測定 メイン関数
+//!
+//! IPv6アドレス文字列をキーとしてPMTU管理データ相当のバリューを格納し、
+//! 要素数ごとに挿入/検索/削除の性能を測定する。
+//!
+//! @retval 0       正常終了
+//! @retval 0以外   異常終了
+///////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+    srand(1);
+
+    for(size_t i = 0; i < sizeof(bench_entry_nums) / sizeof(bench_entry_nums[0]); i++){
+        if(bench_run(bench_entry_nums[i]) != 0){
+            return 1;
+        }
+    }
+
+    return 0;
+}
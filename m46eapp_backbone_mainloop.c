@@ -9,6 +9,9 @@
 /*              2013.12.02 Y.Shibata 経路同期機能追加                         */
 /*              2014.01.21 M.Iwatsubo M46E-PR外部連携機能追加                 */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -238,7 +241,18 @@ static bool command_handler(int fd, struct m46e_handler_t* handler)
         if(ret < 0){
             m46e_logging(LOG_WARNING, "fail to send response to external command : %s\n", strerror(-ret));
         }
-        if(command.res.result == 0){
+        if((command.res.result == 0) && (command.req.show_stat.interval > 0)){
+            // 差分通知の場合は通知用スレッドに複製したソケットを渡す
+            int watch_sock = fcntl(sock, F_DUPFD_CLOEXEC, 0);
+            if(watch_sock < 0){
+                m46e_logging(LOG_WARNING, "fail to duplicate socket : %s\n", strerror(errno));
+            }
+            else if(!m46e_statistics_start_watch(handler->stat_info, watch_sock,
+                        command.req.show_stat.interval, command.req.show_stat.json)){
+                close(watch_sock);
+            }
+        }
+        else if(command.res.result == 0){
             switch(handler->conf->general->tunnel_mode){
             case M46E_TUNNEL_MODE_NORMAL:
                 m46e_printf_statistics_info_normal(handler->stat_info, sock);
@@ -256,6 +270,38 @@ static bool command_handler(int fd, struct m46e_handler_t* handler)
         }
         break;
 
+    case M46E_SHOW_PROFILE:
+        if(ret > 0){
+            command.res.result = 0;
+        }
+        else{
+            command.res.result = -ret;
+        }
+        ret = m46e_socket_send(sock, command.code, &command.res, sizeof(command.res), -1);
+        if(ret < 0){
+            m46e_logging(LOG_WARNING, "fail to send response to external command : %s\n", strerror(-ret));
+        }
+        if(command.res.result == 0){
+            m46e_printf_statistics_profile(handler->stat_info, sock);
+        }
+        break;
+
+    case M46E_SHOW_DROPS:
+        if(ret > 0){
+            command.res.result = 0;
+        }
+        else{
+            command.res.result = -ret;
+        }
+        ret = m46e_socket_send(sock, command.code, &command.res, sizeof(command.res), -1);
+        if(ret < 0){
+            m46e_logging(LOG_WARNING, "fail to send response to external command : %s\n", strerror(-ret));
+        }
+        if(command.res.result == 0){
+            m46e_printf_statistics_drops(handler->stat_info, sock);
+        }
+        break;
+
     case M46E_SHOW_CONF:
         if(ret > 0){
             command.res.result = 0;
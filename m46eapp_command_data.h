@@ -11,6 +11,9 @@
 /*              2013.12.02 Y.Shibata 経路同期機能追加                         */
 /*              2014.01.21 M.Iwatsubo M46E-PR外部連携機能追加                 */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -79,9 +82,21 @@ enum m46e_command_code
     M46E_THREAD_INIT_END,      ///< v4経路同期スレッド初期化完了
     M46E_SYNC_ROUTE,           ///< 経路同期要求
     M46E_SHOW_ROUTE,           ///< 経路情報表示
+    M46E_SHOW_PROFILE,         ///< ステージ別サイクル計測結果表示
+    M46E_SHOW_DROPS,           ///< 破棄パケット記録表示
     M46E_COMMAND_MAX
 };
 
+//! 統計情報差分通知1回分の最大長
+#define M46E_STAT_WATCH_RECORD_MAX 4096
+
+//! 統計情報表示要求データ
+struct m46e_show_stat_data
+{
+    int  interval; ///< 差分の通知間隔(秒)。0の場合は一度だけ表示する
+    bool json;     ///< 差分をJSON形式で通知するかどうか
+};
+
 //! 経路同期テーブル表示要求データ
 struct m46e_show_route_data
 {
@@ -264,6 +279,7 @@ struct m46e_command_request_data
         struct m46e_exec_cmd_inet_data      inetcmd;      ///< StubNetwork実行コマンドデータ
         struct m46e_route_sync_request_t   info_route;    ///< 経路同期要求データ
         struct m46e_show_route_data        show_route;    ///< 経路同期テーブル 表示データ
+        struct m46e_show_stat_data         show_stat;     ///< 統計情報 表示データ
     };
 };
 
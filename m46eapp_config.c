@@ -8,6 +8,14 @@
 /*              2013.09.13  K.Nakamura M46E-PR拡張機能 追加                   */
 /*              2013.12.02  Y.Shibata 経路同期機能追加                        */
 /*              2016.04.15  H.Koganemaru 名称変更に伴う修正                   */
+/*              2026.10.18 agent プレフィックス毎PMTU保持追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
+/*              2026.10.18 agent 遅延ヒストグラム追加                         */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent OpenMetrics出力追加                          */
+/*              2026.10.18 agent 外側IPv6フラグメント追加                     */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
+/*              2026.10.18 agent Fragment Neededの注入追加                    */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -40,14 +48,21 @@
 #define CONFIG_TUNNEL_MODE_AS     1
 #define CONFIG_TUNNEL_MODE_PR     2
 
+#define CONFIG_FRAGMENT_MODE_INNER 0
+#define CONFIG_FRAGMENT_MODE_OUTER 1
+
 #define CONFIG_PMTUD_TYPE_NONE   0
 #define CONFIG_PMTUD_TYPE_TUNNEL 1
 #define CONFIG_PMTUD_TYPE_HOST   2
+#define CONFIG_PMTUD_TYPE_PREFIX 3
 
 // 設定ファイルの数値関連の最小値と最大値
 #define CONFIG_TUNNEL_MODE_MIN CONFIG_TUNNEL_MODE_NORMAL
 #define CONFIG_TUNNEL_MODE_MAX CONFIG_TUNNEL_MODE_PR
 
+#define CONFIG_FRAGMENT_MODE_MIN CONFIG_FRAGMENT_MODE_INNER
+#define CONFIG_FRAGMENT_MODE_MAX CONFIG_FRAGMENT_MODE_OUTER
+
 #define CONFIG_IPV4_NETMASK_MIN 1
 #define CONFIG_IPV4_NETMASK_MAX 32
 #define CONFIG_IPV4_NETMASK_PR_MIN 0
@@ -66,7 +81,15 @@
 #define CONFIG_PMTUD_EXPIRE_TIME_DEFAULT 600
 
 #define CONFIG_PMTUD_TYPE_MIN CONFIG_PMTUD_TYPE_NONE
-#define CONFIG_PMTUD_TYPE_MAX CONFIG_PMTUD_TYPE_HOST
+#define CONFIG_PMTUD_TYPE_MAX CONFIG_PMTUD_TYPE_PREFIX
+
+#define CONFIG_PMTUD_PREFIX_LEN_MIN     CONFIG_IPV6_PREFIX_MIN
+#define CONFIG_PMTUD_PREFIX_LEN_MAX     CONFIG_IPV6_PREFIX_MAX
+#define CONFIG_PMTUD_PREFIX_LEN_DEFAULT 120
+
+#define CONFIG_PMTUD_PROBE_INTERVAL_MIN     0
+#define CONFIG_PMTUD_PROBE_INTERVAL_MAX     65535
+#define CONFIG_PMTUD_PROBE_INTERVAL_DEFAULT 0
 
 #define CONFIG_TUNNEL_MTU_MIN 1280
 #define CONFIG_TUNNEL_MTU_MAX 65521
@@ -81,6 +104,29 @@
 #define CONFIG_ROUTE_ENTRY_MIN   1
 #define CONFIG_ROUTE_ENTRY_MAX   65535
 
+#define CONFIG_LATENCY_SAMPLE_RATE_MIN     0
+#define CONFIG_LATENCY_SAMPLE_RATE_MAX     65535
+#define CONFIG_LATENCY_SAMPLE_RATE_DEFAULT 1024
+
+#define CONFIG_DROP_SAMPLE_RATE_MIN     0
+#define CONFIG_DROP_SAMPLE_RATE_MAX     65535
+#define CONFIG_DROP_SAMPLE_RATE_DEFAULT 1
+
+#define CONFIG_METRICS_PORT_MIN 0
+#define CONFIG_METRICS_PORT_MAX 65535
+
+#define CONFIG_REASM_ENTRY_MIN      0
+#define CONFIG_REASM_ENTRY_MAX      65535
+#define CONFIG_REASM_ENTRY_DEFAULT  256
+
+#define CONFIG_REASM_SOURCE_MIN     1
+#define CONFIG_REASM_SOURCE_MAX     65535
+#define CONFIG_REASM_SOURCE_DEFAULT 16
+
+#define CONFIG_REASM_TIMEOUT_MIN     1
+#define CONFIG_REASM_TIMEOUT_MAX     60
+#define CONFIG_REASM_TIMEOUT_DEFAULT 60
+
 // 設定ファイルのセクション名とキー名
 #define SECTION_GENERAL                   "general"
 #define SECTION_GENERAL_PLANE_NAME        "plane_name"
@@ -93,8 +139,17 @@
 #define SECTION_GENERAL_DAEMON            "daemon"
 #define SECTION_GENERAL_STARTUP_SCRIPT    "startup_script"
 #define SECTION_GENERAL_FORCE_FRAGMENT    "force_fragment"
+#define SECTION_GENERAL_FRAGMENT_MODE     "fragment_mode"
+#define SECTION_GENERAL_ICMP_INJECT       "icmp_inject"
 #define SECTION_ROUTING_SYNC              "route_sync"
 #define SECTION_GENERAL_ROUTE_ENTRY_MAX   "route_entry_max"
+#define SECTION_GENERAL_LATENCY_SAMPLE_RATE "latency_sample_rate"
+#define SECTION_GENERAL_DROP_SAMPLE_RATE  "drop_sample_rate"
+#define SECTION_GENERAL_METRICS_SOCKET    "metrics_socket"
+#define SECTION_GENERAL_METRICS_PORT      "metrics_port"
+#define SECTION_GENERAL_REASM_ENTRY_MAX   "reassemble_entry_max"
+#define SECTION_GENERAL_REASM_SOURCE_MAX  "reassemble_source_max"
+#define SECTION_GENERAL_REASM_TIMEOUT     "reassemble_timeout"
 
 
 #define SECTION_M46E_AS                 "m46e-as"
@@ -105,6 +160,8 @@
 #define SECTION_PMTUD                    "pmtud"
 #define SECTION_PMTUD_TYPE               "type"
 #define SECTION_PMTUD_EXPIRE_TIME        "expire_time"
+#define SECTION_PMTUD_PREFIX_LEN         "prefix_len"
+#define SECTION_PMTUD_PROBE_INTERVAL     "probe_interval"
 
 #define SECTION_TUNNEL                   "tunnel"
 #define SECTION_TUNNEL_NAME              "tunnel_name"
@@ -488,8 +545,17 @@ void m46e_config_dump(const m46e_config_t* config, int fd)
         dprintf(fd, "%s = %s\n", SECTION_GENERAL_DAEMON, strbool[config->general->daemon]);
         dprintf(fd, "%s = %s\n", SECTION_GENERAL_STARTUP_SCRIPT, config->general->startup_script);
         dprintf(fd, "%s = %s\n", SECTION_GENERAL_FORCE_FRAGMENT, strbool[config->general->force_fragment]);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_FRAGMENT_MODE, config->general->fragment_mode);
+        dprintf(fd, "%s = %s\n", SECTION_GENERAL_ICMP_INJECT, strbool[config->general->icmp_inject]);
         dprintf(fd, "%s = %s\n", SECTION_ROUTING_SYNC, strbool[config->general->route_sync]);
         dprintf(fd, "%s = %d\n", SECTION_GENERAL_ROUTE_ENTRY_MAX, config->general->route_entry_max);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_LATENCY_SAMPLE_RATE, config->general->latency_sample_rate);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_DROP_SAMPLE_RATE, config->general->drop_sample_rate);
+        dprintf(fd, "%s = %s\n", SECTION_GENERAL_METRICS_SOCKET, config->general->metrics_socket);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_METRICS_PORT, config->general->metrics_port);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_REASM_ENTRY_MAX, config->general->reasm_entry_max);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_REASM_SOURCE_MAX, config->general->reasm_source_max);
+        dprintf(fd, "%s = %d\n", SECTION_GENERAL_REASM_TIMEOUT, config->general->reasm_timeout);
         dprintf(fd, "\n");
     }
 
@@ -510,6 +576,8 @@ void m46e_config_dump(const m46e_config_t* config, int fd)
         dprintf(fd, "[%s]\n", SECTION_PMTUD);
         dprintf(fd, "%s = %d\n", SECTION_PMTUD_TYPE, config->pmtud->type);
         dprintf(fd, "%s = %d\n", SECTION_PMTUD_EXPIRE_TIME, config->pmtud->expire_time);
+        dprintf(fd, "%s = %d\n", SECTION_PMTUD_PREFIX_LEN, config->pmtud->prefix_len);
+        dprintf(fd, "%s = %d\n", SECTION_PMTUD_PROBE_INTERVAL, config->pmtud->probe_interval);
         dprintf(fd, "\n");
     }
 
@@ -742,8 +810,17 @@ bool config_init_general(m46e_config_t* config)
     config->general->daemon              = true;
     config->general->startup_script      = NULL;
     config->general->force_fragment      = false;
+    config->general->fragment_mode       = M46E_FRAGMENT_MODE_INNER;
+    config->general->icmp_inject         = false;
     config->general->route_sync        = false;
     config->general->route_entry_max     = 256;
+    config->general->latency_sample_rate = CONFIG_LATENCY_SAMPLE_RATE_DEFAULT;
+    config->general->drop_sample_rate    = CONFIG_DROP_SAMPLE_RATE_DEFAULT;
+    config->general->metrics_socket      = NULL;
+    config->general->metrics_port        = 0;
+    config->general->reasm_entry_max     = CONFIG_REASM_ENTRY_DEFAULT;
+    config->general->reasm_source_max    = CONFIG_REASM_SOURCE_DEFAULT;
+    config->general->reasm_timeout       = CONFIG_REASM_TIMEOUT_DEFAULT;
 
     return true;
 }
@@ -770,6 +847,7 @@ static void config_destruct_general(m46e_config_general_t* general)
     free(general->src_addr_unicast_prefix);
     free(general->multicast_prefix);
     free(general->startup_script);
+    free(general->metrics_socket);
 
     return;
 }
@@ -930,6 +1008,28 @@ static bool config_parse_general(
       DEBUG_LOG("Match %s.\n", SECTION_GENERAL_FORCE_FRAGMENT);
       result = parse_bool(kv->value, &config->general->force_fragment);
     }
+    else if(!strcasecmp(SECTION_GENERAL_FRAGMENT_MODE, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_FRAGMENT_MODE);
+        int  tmp;
+        result = parse_int(kv->value, &tmp, CONFIG_FRAGMENT_MODE_MIN, CONFIG_FRAGMENT_MODE_MAX);
+        if(result){
+            switch(tmp){
+            case CONFIG_FRAGMENT_MODE_INNER:
+                config->general->fragment_mode = M46E_FRAGMENT_MODE_INNER;
+                break;
+            case CONFIG_FRAGMENT_MODE_OUTER:
+                config->general->fragment_mode = M46E_FRAGMENT_MODE_OUTER;
+                break;
+            default:
+                result = false;
+                break;
+            }
+        }
+    }
+    else if(!strcasecmp(SECTION_GENERAL_ICMP_INJECT, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_ICMP_INJECT);
+        result = parse_bool(kv->value, &config->general->icmp_inject);
+    }
     else if(!strcasecmp(SECTION_ROUTING_SYNC, kv->key)){
         DEBUG_LOG("Match %s.\n", SECTION_ROUTING_SYNC);
         result = parse_bool(kv->value, &config->general->route_sync);
@@ -938,6 +1038,39 @@ static bool config_parse_general(
         DEBUG_LOG("Match %s.\n", SECTION_GENERAL_ROUTE_ENTRY_MAX);
         result = parse_int(kv->value, &config->general->route_entry_max, CONFIG_ROUTE_ENTRY_MIN, CONFIG_ROUTE_ENTRY_MAX);
     }
+    else if(!strcasecmp(SECTION_GENERAL_LATENCY_SAMPLE_RATE, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_LATENCY_SAMPLE_RATE);
+        result = parse_int(kv->value, &config->general->latency_sample_rate, CONFIG_LATENCY_SAMPLE_RATE_MIN, CONFIG_LATENCY_SAMPLE_RATE_MAX);
+    }
+    else if(!strcasecmp(SECTION_GENERAL_DROP_SAMPLE_RATE, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_DROP_SAMPLE_RATE);
+        result = parse_int(kv->value, &config->general->drop_sample_rate, CONFIG_DROP_SAMPLE_RATE_MIN, CONFIG_DROP_SAMPLE_RATE_MAX);
+    }
+    else if(!strcasecmp(SECTION_GENERAL_METRICS_SOCKET, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_METRICS_SOCKET);
+        if(config->general->metrics_socket == NULL){
+            config->general->metrics_socket = strdup(kv->value);
+        }
+        else{
+            result = false;
+        }
+    }
+    else if(!strcasecmp(SECTION_GENERAL_METRICS_PORT, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_METRICS_PORT);
+        result = parse_int(kv->value, &config->general->metrics_port, CONFIG_METRICS_PORT_MIN, CONFIG_METRICS_PORT_MAX);
+    }
+    else if(!strcasecmp(SECTION_GENERAL_REASM_ENTRY_MAX, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_REASM_ENTRY_MAX);
+        result = parse_int(kv->value, &config->general->reasm_entry_max, CONFIG_REASM_ENTRY_MIN, CONFIG_REASM_ENTRY_MAX);
+    }
+    else if(!strcasecmp(SECTION_GENERAL_REASM_SOURCE_MAX, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_REASM_SOURCE_MAX);
+        result = parse_int(kv->value, &config->general->reasm_source_max, CONFIG_REASM_SOURCE_MIN, CONFIG_REASM_SOURCE_MAX);
+    }
+    else if(!strcasecmp(SECTION_GENERAL_REASM_TIMEOUT, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_GENERAL_REASM_TIMEOUT);
+        result = parse_int(kv->value, &config->general->reasm_timeout, CONFIG_REASM_TIMEOUT_MIN, CONFIG_REASM_TIMEOUT_MAX);
+    }
     else{
         // 不明なキーなのでスキップ
         m46e_logging(LOG_WARNING, "Ignore unknown key : %s\n", kv->key);
@@ -1324,6 +1457,8 @@ static bool config_init_pmtud(m46e_config_t* config)
     // 共通設定
     config->pmtud->type        = CONFIG_PMTUD_TYPE_NONE;
     config->pmtud->expire_time = CONFIG_PMTUD_EXPIRE_TIME_DEFAULT;
+    config->pmtud->prefix_len  = CONFIG_PMTUD_PREFIX_LEN_DEFAULT;
+    config->pmtud->probe_interval = CONFIG_PMTUD_PROBE_INTERVAL_DEFAULT;
 
     return true;
 }
@@ -1371,6 +1506,9 @@ static bool config_parse_pmtud(
             case CONFIG_PMTUD_TYPE_HOST:
                 config->pmtud->type = M46E_PMTUD_TYPE_HOST;
                 break;
+            case CONFIG_PMTUD_TYPE_PREFIX:
+                config->pmtud->type = M46E_PMTUD_TYPE_PREFIX;
+                break;
             default:
                 result = false;
                 break;
@@ -1384,6 +1522,14 @@ static bool config_parse_pmtud(
         DEBUG_LOG("Match %s.\n", SECTION_PMTUD_EXPIRE_TIME);
         result = parse_int(kv->value, &config->pmtud->expire_time, CONFIG_PMTUD_EXPIRE_TIME_MIN, CONFIG_PMTUD_EXPIRE_TIME_MAX);
     }
+    else if(!strcmp(SECTION_PMTUD_PREFIX_LEN, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_PMTUD_PREFIX_LEN);
+        result = parse_int(kv->value, &config->pmtud->prefix_len, CONFIG_PMTUD_PREFIX_LEN_MIN, CONFIG_PMTUD_PREFIX_LEN_MAX);
+    }
+    else if(!strcmp(SECTION_PMTUD_PROBE_INTERVAL, kv->key)){
+        DEBUG_LOG("Match %s.\n", SECTION_PMTUD_PROBE_INTERVAL);
+        result = parse_int(kv->value, &config->pmtud->probe_interval, CONFIG_PMTUD_PROBE_INTERVAL_MIN, CONFIG_PMTUD_PROBE_INTERVAL_MAX);
+    }
     else{
         // 不明なキーなのでスキップ
         m46e_logging(LOG_WARNING, "Ignore unknown key : %s\n", kv->key);
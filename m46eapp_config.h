@@ -8,6 +8,14 @@
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2013.12.02 Y.Shibata 経路同期機能追加                         */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent プレフィックス毎PMTU保持追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
+/*              2026.10.18 agent 遅延ヒストグラム追加                         */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent OpenMetrics出力追加                          */
+/*              2026.10.18 agent 外側IPv6フラグメント追加                     */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
+/*              2026.10.18 agent Fragment Neededの注入追加                    */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -32,6 +40,16 @@ enum m46e_tunnel_mode
 };
 typedef enum m46e_tunnel_mode m46e_tunnel_mode;
 
+///////////////////////////////////////////////////////////////////////////////
+//! PMTU超過時のフラグメント方式
+///////////////////////////////////////////////////////////////////////////////
+enum m46e_fragment_mode
+{
+    M46E_FRAGMENT_MODE_INNER = 0,  ///< 内側IPv4パケットをフラグメント
+    M46E_FRAGMENT_MODE_OUTER = 1,  ///< 外側IPv6パケットをフラグメント(RFC2473)
+};
+typedef enum m46e_fragment_mode m46e_fragment_mode;
+
 ///////////////////////////////////////////////////////////////////////////////
 //! 共通設定
 ///////////////////////////////////////////////////////////////////////////////
@@ -50,8 +68,17 @@ struct m46e_config_general_t
     bool                 daemon;              ///< デーモン化するかどうか
     char*                startup_script;      ///< スタートアップスクリプト
     bool                 force_fragment;      ///< 強制フラグメント機能を有効にするかどうか
+    m46e_fragment_mode  fragment_mode;       ///< PMTU超過時のフラグメント方式
+    bool                 icmp_inject;         ///< Fragment NeededをIPv4トンネルデバイスに直接書き込むかどうか
     bool                 route_sync;          ///< 経路同期をおこなうかどうか
     int                  route_entry_max;     ///< 経路表に登録できるエントリの最大数
+    int                  latency_sample_rate; ///< 処理時間を計測するパケット間隔(0は計測なし)
+    int                  drop_sample_rate;    ///< 破棄パケットを記録する間隔(0は記録なし)
+    char*                metrics_socket;      ///< OpenMetrics出力用unixドメインソケットのパス
+    int                  metrics_port;        ///< OpenMetrics出力用TCPポート(0は待ち受けなし)
+    int                  reasm_entry_max;     ///< 同時に再構築するIPv6フラグメントの最大数(0は再構築なし)
+    int                  reasm_source_max;    ///< 送信元毎に同時に再構築するIPv6フラグメントの最大数
+    int                  reasm_timeout;       ///< IPv6フラグメント再構築のタイムアウト時間(秒)
 };
 typedef struct m46e_config_general_t m46e_config_general_t;
 
@@ -73,7 +100,8 @@ enum m46e_pmtud_type
 {
     M46E_PMTUD_TYPE_NONE,    ///< PMTU Discovery処理なし
     M46E_PMTUD_TYPE_TUNNEL,  ///< トンネル毎
-    M46E_PMTUD_TYPE_HOST     ///< ホスト毎
+    M46E_PMTUD_TYPE_HOST,    ///< ホスト毎
+    M46E_PMTUD_TYPE_PREFIX   ///< プレフィックス毎
 };
 typedef enum m46e_pmtud_type m46e_pmtud_type;
 
@@ -84,6 +112,8 @@ struct m46e_config_pmtud_t
 {
     m46e_pmtud_type  type;            ///< PMTU情報保持タイプ
     int               expire_time;     ///< PMTU長保持期限(秒)
+    int               prefix_len;      ///< プレフィックス毎保持時のプレフィックス長
+    int               probe_interval;  ///< PMTU拡大プローブ間隔(秒)(0はプローブなし)
 };
 typedef struct m46e_config_pmtud_t m46e_config_pmtud_t;
 
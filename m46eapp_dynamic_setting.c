@@ -5,6 +5,7 @@
 /*              2013.09.04 H.Koganemaru 動的定義変更機能追加                  */
 /*              2013.11.15 H.Koganemaru mkstempワーニング対処                 */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent プレフィックス毎PMTU保持追加                 */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2013-2016                */
 /******************************************************************************/
@@ -1206,7 +1207,7 @@ bool m46eapp_set_pmtud_type_stub(struct m46e_handler_t* handler, struct m46e_com
     switch(config->pmtud->type){
 
     case 0:
-        if(data->type == 1 || data->type == 2){
+        if(data->type == 1 || data->type == 2 || data->type == 3){
             handler->pmtud_handler = m46e_restart_pmtud(
                                         handler->pmtud_handler,
                                         config->tunnel->ipv6.mtu,
@@ -1219,7 +1220,7 @@ bool m46eapp_set_pmtud_type_stub(struct m46e_handler_t* handler, struct m46e_com
     break;
 
     case 1:
-        if(data->type == 0 || data->type == 2){ 
+        if(data->type == 0 || data->type == 2 || data->type == 3){
             handler->pmtud_handler = m46e_restart_pmtud(
                                         handler->pmtud_handler,
                                         config->tunnel->ipv6.mtu,
@@ -1232,7 +1233,7 @@ bool m46eapp_set_pmtud_type_stub(struct m46e_handler_t* handler, struct m46e_com
     break;
 
     case 2:
-        if(data->type == 0 || data->type == 1){
+        if(data->type == 0 || data->type == 1 || data->type == 3){
             handler->pmtud_handler = m46e_restart_pmtud(
                                         handler->pmtud_handler,
                                         config->tunnel->ipv6.mtu,
@@ -1244,6 +1245,19 @@ bool m46eapp_set_pmtud_type_stub(struct m46e_handler_t* handler, struct m46e_com
 
     break;
 
+    case 3:
+        if(data->type == 0 || data->type == 1 || data->type == 2){
+            handler->pmtud_handler = m46e_restart_pmtud(
+                                        handler->pmtud_handler,
+                                        config->tunnel->ipv6.mtu,
+                                        data->type);
+        }
+        else{
+        //他の値（data->type == 3）の場合は何もしない
+        }
+
+    break;
+
     default:
     //処理なし
     break;
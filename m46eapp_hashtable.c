@@ -3,6 +3,8 @@
 /* 機能概要   : ハッシュテーブルクラス ソースファイル                         */
 /* 修正履歴   : 2012.02.20 T.Maeda 新規作成                                   */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent ハッシュテーブルのオープンアドレス化         */
+/*              2026.10.18 agent ハッシュテーブルの段階的拡張                 */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -13,16 +15,42 @@
 #include "m46eapp_hashtable.h"
 #include "m46eapp_log.h"
 
+//! 要素内に直接格納するキーの最大長(byte)
+#define HASHTABLE_INLINE_KEY_SIZE     56
+//! 要素内に直接格納するバリューの最大長(byte)
+#define HASHTABLE_INLINE_VALUE_SIZE   48
+//! テーブルの最小サイズ
+#define HASHTABLE_MIN_SIZE            8
+//! テーブルの最大サイズ
+#define HASHTABLE_MAX_SIZE            0x80000000U
+//! テーブル拡張の閾値(使用率 = 分子/分母)
+#define HASHTABLE_LOAD_NUM            3
+#define HASHTABLE_LOAD_DEN            4
+//! 追加/削除1回あたりに移行する旧テーブルの要素数
+//! (移行中に使用率が閾値に達する前に移行が完了するよう2以上とする)
+#define HASHTABLE_REHASH_STEP         8
+
 ////////////////////////////////////////////////////////////////////////////////
 //! ハッシュテーブルの要素構造体
+//! (オープンアドレス法で配列に直接格納する。
+//!  小さなキーとバリューは要素内に格納し、大きなものだけ別領域に確保する)
 ////////////////////////////////////////////////////////////////////////////////
 struct _m46e_hash_cell_t
 {
-    char*                   key;         ///< キー
-    void*                   value;       ///< データ
-    m46e_hash_delete_func  delete_func; ///< データ削除用関数
-    m46e_hash_cell_t*      prev;        ///< 前のセルへのチェイン
-    m46e_hash_cell_t*      next;        ///< 次のセルへのチェイン
+    uint32_t                dist;        ///< 本来の格納位置からの距離+1 (0は未使用)
+    uint32_t                hash;        ///< キーのハッシュ値
+    uint32_t                key_len;     ///< キー長
+    bool                    value_inline;///< バリューを要素内に格納しているかどうか
+    bool                    moved;       ///< 移行済み/削除済み(旧テーブルでのみ使用)
+    m46e_hash_delete_func   delete_func; ///< データ削除用関数
+    union {
+        uint8_t             buf[HASHTABLE_INLINE_KEY_SIZE]; ///< キー(要素内格納)
+        uint8_t*            ptr;                            ///< キー(別領域格納)
+    } key;
+    union {
+        uint64_t            buf[HASHTABLE_INLINE_VALUE_SIZE / sizeof(uint64_t)]; ///< データ(要素内格納)
+        void*               ptr;                                                 ///< データ(別領域格納)
+    } value;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -30,25 +58,45 @@ struct _m46e_hash_cell_t
 ////////////////////////////////////////////////////////////////////////////////
 struct _m46e_hashtable_t
 {
-    m46e_hash_cell_t** cells;       ///! 各要素の配列
-    uint32_t            count;       ///! 格納されている要素数
-    uint32_t            table_size;  ///! テーブルのサイズ
+    m46e_hash_cell_t*   cells;       ///! 各要素の配列
+    uint32_t            count;       ///! 格納されている要素数(旧テーブル分を含む)
+    uint32_t            table_size;  ///! テーブルのサイズ(2のべき乗)
+    m46e_hash_cell_t*   old_cells;   ///! 移行中の旧テーブルの要素の配列(移行中以外はNULL)
+    uint32_t            old_size;    ///! 旧テーブルのサイズ
+    uint32_t            migrate_pos; ///! 旧テーブルの次に移行する位置
 };
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
-static uint32_t hashtable_calc_hash(m46e_hashtable_t* table, const char* key);
+static uint32_t          hashtable_calc_hash(const void* key, const size_t key_len);
+static m46e_hash_cell_t* hashtable_find(m46e_hashtable_t* table, const void* key, const size_t key_len, const uint32_t hash);
+static m46e_hash_cell_t* hashtable_find_cells(m46e_hash_cell_t* cells, const uint32_t table_size, const void* key, const size_t key_len, const uint32_t hash);
+static void              hashtable_place(m46e_hashtable_t* table, m46e_hash_cell_t* cell);
+static bool              hashtable_resize(m46e_hashtable_t* table, const uint32_t table_size);
+static void              hashtable_migrate(m46e_hashtable_t* table, const uint32_t step);
+static void              hashtable_release_cells(m46e_hash_cell_t* cells, const uint32_t table_size);
+static void              hashtable_free_value(m46e_hash_cell_t* cell);
+
+//! 要素のキー格納先アドレス
+#define HASHTABLE_CELL_KEY(cell) \
+        (((cell)->key_len <= HASHTABLE_INLINE_KEY_SIZE) ? (cell)->key.buf : (cell)->key.ptr)
+//! 要素のバリュー格納先アドレス
+#define HASHTABLE_CELL_VALUE(cell) \
+        ((cell)->value_inline ? (void*)(cell)->value.buf : (cell)->value.ptr)
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ハッシュテーブル 生成関数
 //!
 //! ハッシュテーブルのコンストラクタ。
-//! 引数のテーブルサイズで指定されたサイズでハッシュテーブルを生成する。<br/>
-//! テーブルの解放には必ずm46e_hashtable_create関数を使用すること。
+//! 引数のテーブルサイズを初期サイズとしてハッシュテーブルを生成する。<br/>
+//! テーブルサイズは2のべき乗に切り上げ、要素数の増加に応じて自動で拡張する。<br/>
+//! 拡張時の要素の移行は一括でおこなわず、以降の追加/削除の度に
+//! HASHTABLE_REHASH_STEP要素ずつおこなう。<br/>
+//! テーブルの解放には必ずm46e_hashtable_delete関数を使用すること。
 //!
-//! @param [in]     table_size   生成するハッシュテーブルのサイズ
+//! @param [in]     table_size   生成するハッシュテーブルの初期サイズ
 //!
 //! @return 生成したハッシュテーブルへのポインタ
 ///////////////////////////////////////////////////////////////////////////////
@@ -56,22 +104,32 @@ m46e_hashtable_t* m46e_hashtable_create(const uint32_t table_size)
 {
     // ローカル変数宣言
     m46e_hashtable_t* result;
+    uint32_t          size;
 
     // 引数チェック
-    if(table_size == 0){
+    if((table_size == 0) || (table_size > HASHTABLE_MAX_SIZE)){
         return NULL;
     }
 
+    // テーブルサイズを2のべき乗に切り上げ
+    size = HASHTABLE_MIN_SIZE;
+    while(size < table_size){
+        size <<= 1;
+    }
+
     result = (m46e_hashtable_t*)malloc(sizeof(m46e_hashtable_t));
     if(result != NULL){
-        result->cells = (m46e_hash_cell_t**)calloc(table_size, sizeof(m46e_hash_cell_t*));
+        result->cells = (m46e_hash_cell_t*)calloc(size, sizeof(m46e_hash_cell_t));
         if(result->cells == NULL){
             free(result);
             result = NULL;
         }
         else{
-            result->count      = 0;
-            result->table_size = table_size;
+            result->count       = 0;
+            result->table_size  = size;
+            result->old_cells   = NULL;
+            result->old_size    = 0;
+            result->migrate_pos = 0;
         }
     }
     return result;
@@ -101,14 +159,16 @@ void m46e_hashtable_delete(m46e_hashtable_t* table)
 //! @brief 要素追加関数
 //!
 //! 指定されたキーとバリューをハッシュテーブルに追加する。<br/>
+//! キーは任意のバイナリデータで、key_len分をコピーして格納する。<br/>
 //! copy_funcが指定されている場合、ハッシュテーブルにはcopy_funcの戻り値を格納する。
-//! copy_funcが指定されていない場合、ハッシュテーブルにはvalue_size分allocした
-//! 領域にvalueをmemcpyしたものを格納する。
+//! copy_funcが指定されていない場合、ハッシュテーブルにはvalueをvalue_size分
+//! コピーしたものを格納する。(小さなvalueは要素内に直接格納する)
 //! delete_funcは要素の削除時にvalueのデストラクタとして使用する。
 //! delete_funcがNULLの場合、valueはfree関数で解放する。
 //!
 //! @param [in]  table         ハッシュテーブル
 //! @param [in]  key           追加する要素のキー
+//! @param [in]  key_len       keyのサイズ(byte)
 //! @param [in]  value         追加する要素のバリュー
 //! @param [in]  value_size    valueのサイズ(byte)
 //! @param [in]  overwrite     同じキーを持つデータが既に格納されている場合に
@@ -122,87 +182,110 @@ void m46e_hashtable_delete(m46e_hashtable_t* table)
 ///////////////////////////////////////////////////////////////////////////////
 bool m46e_hashtable_add(
     m46e_hashtable_t*      table,
-    const char*             key,
-    const void*             value,
-    const size_t            value_size,
-    const bool              overwrite,
+    const void*            key,
+    const size_t           key_len,
+    const void*            value,
+    const size_t           value_size,
+    const bool             overwrite,
     m46e_hash_copy_func    copy_func,
     m46e_hash_delete_func  delete_func
 )
 {
     // ローカル変数宣言
     m46e_hash_cell_t* cell_p;
-    uint32_t           bucket;
+    m46e_hash_cell_t  cell;
+    uint32_t          hash;
 
     // 引数チェック
     if(table == NULL){
         return false;
     }
-    if((key == NULL) || strlen(key) == 0){
+    if((key == NULL) || (key_len == 0) || (key_len > UINT32_MAX)){
         return false;
     }
     if((value == NULL) || value_size == 0){
         return false;
     }
 
-    /* 同じキーを持つデータがないか確認する */
-    if(m46e_hashtable_get(table, key) != NULL){
-        if(overwrite){
-            m46e_hashtable_remove(table, key, NULL);
-        }
-        else{
-            /* 同じキーが使われているので、追加できない */
-            return false;
-        }
-    }
+    // ローカル変数初期化
+    hash = hashtable_calc_hash(key, key_len);
 
-    /* チェインのための領域を確保する */
-    cell_p = (m46e_hash_cell_t*)malloc(sizeof(m46e_hash_cell_t));
-    if(cell_p == NULL){
-        return false;
-    }
+    // 移行中の場合は旧テーブルの要素を一定数だけ移行する
+    hashtable_migrate(table, HASHTABLE_REHASH_STEP);
 
-    // キーの文字列を複製して格納
-    cell_p->key = strdup(key);
-    if(cell_p->key == NULL){
-        free(cell_p);
+    /* 同じキーを持つデータがないか確認する */
+    cell_p = hashtable_find(table, key, key_len, hash);
+    if((cell_p != NULL) && !overwrite){
+        /* 同じキーが使われているので、追加できない */
         return false;
     }
 
+    // 格納する要素を作成
+    memset(&cell, 0, sizeof(cell));
+    cell.hash         = hash;
+    cell.key_len      = key_len;
+    cell.delete_func  = delete_func;
+    cell.value_inline = false;
+
     // バリューを複製して格納
     if(copy_func != NULL){
         // コピー関数が指定されている場合はそれを呼び出す。
-        cell_p->value = copy_func(value, value_size);
-        if(cell_p->value == NULL){
-            free(cell_p->key);
-            free(cell_p);
+        cell.value.ptr = copy_func(value, value_size);
+        if(cell.value.ptr == NULL){
             return false;
         }
     }
+    else if((delete_func == NULL) && (value_size <= HASHTABLE_INLINE_VALUE_SIZE)){
+        // 要素内に格納できるサイズの場合はそのままコピーする。
+        memcpy(cell.value.buf, value, value_size);
+        cell.value_inline = true;
+    }
     else{
-        // コピー関数が指定されていない場合は、size分allocしてmemcpyする。
-        cell_p->value = malloc(value_size);
-        if(cell_p->value != NULL){
-            memcpy(cell_p->value, value, value_size);
-        }
-        else{
-            free(cell_p->key);
-            free(cell_p);
+        // それ以外の場合は、size分allocしてmemcpyする。
+        cell.value.ptr = malloc(value_size);
+        if(cell.value.ptr == NULL){
             return false;
         }
+        memcpy(cell.value.ptr, value, value_size);
     }
 
-    // 格納先のバケット(配列の添字)を計算
-    bucket = hashtable_calc_hash(table, key);
+    if(cell_p != NULL){
+        // 上書きの場合は既存要素のバリューだけを入れ替える
+        hashtable_free_value(cell_p);
+        cell_p->delete_func  = cell.delete_func;
+        cell_p->value_inline = cell.value_inline;
+        cell_p->value        = cell.value;
+        return true;
+    }
 
-    // その他のメンバの設定
-    cell_p->delete_func        = delete_func;
-    cell_p->prev               = NULL;
-    cell_p->next               = table->cells[bucket];
-    if(table->cells[bucket] != NULL){
-        table->cells[bucket]->prev = cell_p;
+    // キーを複製して格納
+    if(key_len <= HASHTABLE_INLINE_KEY_SIZE){
+        memcpy(cell.key.buf, key, key_len);
+    }
+    else{
+        cell.key.ptr = malloc(key_len);
+        if(cell.key.ptr == NULL){
+            hashtable_free_value(&cell);
+            return false;
+        }
+        memcpy(cell.key.ptr, key, key_len);
     }
-    table->cells[bucket]       = cell_p;
+
+    // 使用率が閾値を超える場合はテーブルを拡張する
+    // (旧テーブルの要素は移行後に格納されるので、移行中の要素も含めて判定する)
+    if(((uint64_t)(table->count + 1) * HASHTABLE_LOAD_DEN) > ((uint64_t)table->table_size * HASHTABLE_LOAD_NUM)){
+        if((table->table_size >= HASHTABLE_MAX_SIZE) || !hashtable_resize(table, table->table_size << 1)){
+            m46e_logging(LOG_WARNING, "hashtable resize failed. size = %u\n", table->table_size);
+            if(key_len > HASHTABLE_INLINE_KEY_SIZE){
+                free(cell.key.ptr);
+            }
+            hashtable_free_value(&cell);
+            return false;
+        }
+    }
+
+    // 要素を格納
+    hashtable_place(table, &cell);
 
     // 要素数をインクリメント
     table->count++;
@@ -215,11 +298,12 @@ bool m46e_hashtable_add(
 //!
 //! 指定されたキーに該当する要素をハッシュテーブルから削除する。<br/>
 //! removed_valueにNULL以外の値が指定されている場合、削除した要素のvalueを
-//! そのまま格納する。(この場合、value自体の解放は呼出元の責任でおこなうこと)
+//! 格納する。(この場合、value自体の解放は呼出元の責任でおこなうこと)
 //! removed_valueがNULLの場合、valueの解放は本関数内でおこなわれる。
 //!
 //! @param [in]  table         ハッシュテーブル
 //! @param [in]  key           削除する要素のキー
+//! @param [in]  key_len       keyのサイズ(byte)
 //! @param [out] removed_value 削除した要素のバリューを格納する器
 //!
 //! @retval true   要素を削除した。
@@ -227,116 +311,138 @@ bool m46e_hashtable_add(
 ///////////////////////////////////////////////////////////////////////////////
 bool m46e_hashtable_remove(
     m46e_hashtable_t* table,
-    const char*        key,
-          void**       removed_value
+    const void*       key,
+    const size_t      key_len,
+          void**      removed_value
 )
 {
     // ローカル変数宣言
-    bool               result;
     m46e_hash_cell_t* cell_p;
-    uint32_t           bucket;
+    uint32_t          mask;
+    uint32_t          index;
+    uint32_t          next;
 
     // 引数チェック
     if(table == NULL){
         return false;
     }
-    if((key == NULL) || strlen(key) == 0){
+    if((key == NULL) || (key_len == 0)){
         return false;
     }
 
-    // ローカル変数初期化
-    result = false;
-    bucket = hashtable_calc_hash(table, key);
-
-    // 連結リストを辿る
-    for(cell_p=table->cells[bucket]; cell_p!=NULL; cell_p=cell_p->next){
-        if(!strcmp(key, cell_p->key)){
-            // 連結リストのポインタを再設定
-            if(cell_p->prev != NULL){
-                cell_p->prev->next = cell_p->next;
-            }
-            if(cell_p->next != NULL){
-                cell_p->next->prev = cell_p->prev;
-            }
+    // 移行中の場合は旧テーブルの要素を一定数だけ移行する
+    hashtable_migrate(table, HASHTABLE_REHASH_STEP);
 
-            // 削除する要素のキーを解放
-            free(cell_p->key);
+    cell_p = hashtable_find(table, key, key_len, hashtable_calc_hash(key, key_len));
+    if(cell_p == NULL){
+        return false;
+    }
 
-            // 削除する要素のバリューを解放
-            if(removed_value != NULL){
-                // 削除した要素のバリュー格納ポインタが指定されている場合は
-                // バリューを解放せず、ポインタをそのまま設定する。
-                *removed_value = cell_p->value;
-            }
-            else{
-                // 削除した要素のバリュー格納ポインタが指定されていない場合は
-                // バリューを解放する。
-                if(cell_p->delete_func != NULL){
-                    // 削除用関数が指定されている場合は、それを呼び出す。
-                    cell_p->delete_func(cell_p->value);
-                }
-                else{
-                    // 削除用関数が指定されていない場合は、そのままfreeする。
-                    free(cell_p->value);
-                }
-            }
-            // 連結リストの先頭であれば、リスト先頭アドレスを再設定
-            if(cell_p == table->cells[bucket]){
-                table->cells[bucket] = cell_p->next;
+    // 削除する要素のバリューを解放
+    if(removed_value != NULL){
+        // 削除した要素のバリュー格納ポインタが指定されている場合は
+        // バリューを解放せず、ポインタを設定する。
+        if(cell_p->value_inline){
+            // 要素内に格納している場合は別領域に複製して渡す
+            *removed_value = malloc(HASHTABLE_INLINE_VALUE_SIZE);
+            if(*removed_value != NULL){
+                memcpy(*removed_value, cell_p->value.buf, HASHTABLE_INLINE_VALUE_SIZE);
             }
-            // 要素自体を解放
-            free(cell_p);
-            // 要素数をデクリメント
-            table->count--;
-            // 処理結果をtrueに設定
-            result = true;
-            break;
+        }
+        else{
+            *removed_value = cell_p->value.ptr;
         }
     }
-    return result;
+    else{
+        // 削除した要素のバリュー格納ポインタが指定されていない場合は
+        // バリューを解放する。
+        hashtable_free_value(cell_p);
+    }
+
+    // 削除する要素のキーを解放
+    if(cell_p->key_len > HASHTABLE_INLINE_KEY_SIZE){
+        free(cell_p->key.ptr);
+    }
+
+    if((table->old_cells != NULL) &&
+       (cell_p >= table->old_cells) && (cell_p < table->old_cells + table->old_size)){
+        // 旧テーブルの要素は位置を変えずに削除済みとする
+        // (旧テーブル内の他の要素の探索距離を保つため)
+        cell_p->moved = true;
+        table->count--;
+        return true;
+    }
+
+    // 後続の要素を前に詰める(backward shift deletion)
+    mask  = table->table_size - 1;
+    index = cell_p - table->cells;
+    next  = (index + 1) & mask;
+    while(table->cells[next].dist > 1){
+        table->cells[index] = table->cells[next];
+        table->cells[index].dist--;
+        index = next;
+        next  = (next + 1) & mask;
+    }
+    memset(&table->cells[index], 0, sizeof(m46e_hash_cell_t));
+
+    // 要素数をデクリメント
+    table->count--;
+
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 要素検索関数
 //!
 //! 指定されたキーに該当する要素をハッシュテーブルから検索する。<br/>
+//! 返却したアドレスは、次にテーブルへの追加/削除をおこなうまで有効。
 //!
 //! @param [in]  table         ハッシュテーブル
 //! @param [in]  key           検索する要素のキー
+//! @param [in]  key_len       keyのサイズ(byte)
 //!
 //! @return keyに該当する要素のvalue。要素が存在しない場合はNULL。
 ///////////////////////////////////////////////////////////////////////////////
 void* m46e_hashtable_get(
     m46e_hashtable_t* table,
-    const char*        key
+    const void*       key,
+    const size_t      key_len
 )
 {
     // ローカル変数宣言
-    void*              result;
     m46e_hash_cell_t* cell_p;
-    uint32_t           bucket;
 
     // 引数チェック
     if(table == NULL){
         return NULL;
     }
-    if((key == NULL) || strlen(key) == 0){
+    if((key == NULL) || (key_len == 0)){
         return NULL;
     }
 
-    // ローカル変数初期化
-    result = NULL;
-    bucket = hashtable_calc_hash(table, key);
-    
-    /* 連結リストを辿る */
-    for(cell_p=table->cells[bucket]; cell_p!=NULL; cell_p=cell_p->next){
-        if(!strcmp(key, cell_p->key)){
-            result = cell_p->value;
-            break;
-        }
+    cell_p = hashtable_find(table, key, key_len, hashtable_calc_hash(key, key_len));
+    if(cell_p == NULL){
+        return NULL;
     }
 
-    return result;
+    return HASHTABLE_CELL_VALUE(cell_p);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素数取得関数
+//!
+//! @param [in]  table         ハッシュテーブル
+//!
+//! @return 格納されている要素数
+///////////////////////////////////////////////////////////////////////////////
+uint32_t m46e_hashtable_count(m46e_hashtable_t* table)
+{
+    // 引数チェック
+    if(table == NULL){
+        return 0;
+    }
+
+    return table->count;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -350,74 +456,324 @@ void* m46e_hashtable_get(
 ///////////////////////////////////////////////////////////////////////////////
 void m46e_hashtable_clear(m46e_hashtable_t* table)
 {
-    // ローカル変数宣言
-    m46e_hash_cell_t* cell_p;
-    m46e_hash_cell_t* next_p;
-
     // 引数チェック
     if(table == NULL){
         return;
     }
 
     /* malloc関数で領域が確保されていたら、解放する */
-    for(int i=0; i<table->table_size; ++i){
-        cell_p = table->cells[i];
-
-        /* next を辿ってから、領域を解放しなければならない */
-        while(cell_p != NULL){
-            next_p = cell_p->next;
-            m46e_hashtable_remove(table, cell_p->key, NULL);
-            cell_p = next_p;
-        }
-        table->cells[i] = NULL;
+    hashtable_release_cells(table->cells, table->table_size);
+    memset(table->cells, 0, sizeof(m46e_hash_cell_t) * table->table_size);
+
+    if(table->old_cells != NULL){
+        hashtable_release_cells(table->old_cells, table->old_size);
+        free(table->old_cells);
+        table->old_cells   = NULL;
+        table->old_size    = 0;
+        table->migrate_pos = 0;
     }
+    table->count = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ハッシュ値計算関数
 //!
 //! keyからハッシュ値を計算する。<br/>
-//! ハッシュ値はJavaのString#hashCode()と同じロジックで計算した結果を
-//! テーブルサイズで割ったもの。<br/>
-//! [参考] JavaのString#hashCodeアルゴリズム<br/>
-//! @code
-//!    s[0]*31^(n-1) + s[1]*31^(n-2) + ... + s[n-1]
-//! @endcode
+//! ハッシュ値はFNV-1aで計算した結果に、下位ビットへの偏りを
+//! なくすための攪拌(MurmurHash3のfinalizer)をおこなったもの。
 //!
-//! @param [in]  table     ハッシュテーブル
 //! @param [in]  key       ハッシュ値を求めるキー
+//! @param [in]  key_len   keyのサイズ(byte)
 //!
-//! @return なし。
+//! @return ハッシュ値
+///////////////////////////////////////////////////////////////////////////////
+static uint32_t hashtable_calc_hash(
+    const void*  key,
+    const size_t key_len
+)
+{
+    // ローカル変数宣言
+    const uint8_t* p;
+    uint32_t       hash;
+
+    // ローカル変数初期化
+    p    = (const uint8_t*)key;
+    hash = 2166136261U;
+
+    for(size_t i = 0; i < key_len; i++){
+        hash ^= p[i];
+        hash *= 16777619U;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素探索関数
+//!
+//! keyに一致する要素をテーブルから探索する。<br/>
+//! 移行中の場合は新テーブルで見つからなければ旧テーブルを探索する。
+//!
+//! @param [in]  table     ハッシュテーブル
+//! @param [in]  key       探索するキー
+//! @param [in]  key_len   keyのサイズ(byte)
+//! @param [in]  hash      keyのハッシュ値
+//!
+//! @return keyに一致する要素。存在しない場合はNULL。
 ///////////////////////////////////////////////////////////////////////////////
-uint32_t hashtable_calc_hash(
+static m46e_hash_cell_t* hashtable_find(
     m46e_hashtable_t* table,
-    const char*        key
+    const void*       key,
+    const size_t      key_len,
+    const uint32_t    hash
 )
 {
     // ローカル変数宣言
-    uint32_t hash;
-    int      len;
+    m46e_hash_cell_t* cell_p;
 
-    // 引数チェック
-    if((table == NULL) || (key == NULL)){
-        return 0;
+    cell_p = hashtable_find_cells(table->cells, table->table_size, key, key_len, hash);
+    if((cell_p == NULL) && (table->old_cells != NULL)){
+        cell_p = hashtable_find_cells(table->old_cells, table->old_size, key, key_len, hash);
+    }
+
+    return cell_p;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素配列探索関数
+//!
+//! keyに一致する要素を要素配列から探索する。<br/>
+//! Robin Hood hashingでは格納位置からの距離が探索中の距離より短い要素が
+//! 見つかった時点で、それ以降に一致する要素が存在しないことが確定する。<br/>
+//! 移行済み/削除済みの要素は探索距離の判定にのみ使用する。
+//!
+//! @param [in]  cells      要素配列
+//! @param [in]  table_size 要素配列のサイズ(2のべき乗)
+//! @param [in]  key        探索するキー
+//! @param [in]  key_len    keyのサイズ(byte)
+//! @param [in]  hash       keyのハッシュ値
+//!
+//! @return keyに一致する要素。存在しない場合はNULL。
+///////////////////////////////////////////////////////////////////////////////
+static m46e_hash_cell_t* hashtable_find_cells(
+    m46e_hash_cell_t* cells,
+    const uint32_t    table_size,
+    const void*       key,
+    const size_t      key_len,
+    const uint32_t    hash
+)
+{
+    // ローカル変数宣言
+    m46e_hash_cell_t* cell_p;
+    uint32_t          mask;
+    uint32_t          index;
+    uint32_t          dist;
+
+    // ローカル変数初期化
+    mask  = table_size - 1;
+    index = hash & mask;
+    dist  = 1;
+
+    for(;;){
+        cell_p = &cells[index];
+        if(cell_p->dist < dist){
+            // 空き要素、または自分より近い要素に到達したので該当なし
+            return NULL;
+        }
+        if(!cell_p->moved && (cell_p->hash == hash) && (cell_p->key_len == key_len) &&
+           !memcmp(HASHTABLE_CELL_KEY(cell_p), key, key_len)){
+            return cell_p;
+        }
+        index = (index + 1) & mask;
+        dist++;
     }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素格納関数
+//!
+//! 要素をRobin Hood hashingでテーブルに格納する。<br/>
+//! 格納位置からの距離が自分より短い要素があれば入れ替え、
+//! 追い出した要素の格納を続ける。<br/>
+//! 本関数は重複チェックと空き容量の確保が済んでいる状態で呼び出すこと。
+//!
+//! @param [in]  table     ハッシュテーブル
+//! @param [in]  cell      格納する要素
+//!
+//! @return なし。
+///////////////////////////////////////////////////////////////////////////////
+static void hashtable_place(m46e_hashtable_t* table, m46e_hash_cell_t* cell)
+{
+    // ローカル変数宣言
+    m46e_hash_cell_t  work;
+    m46e_hash_cell_t  tmp;
+    uint32_t          mask;
+    uint32_t          index;
 
     // ローカル変数初期化
-    hash = 0;
-    len  = strlen(key);
+    work      = *cell;
+    work.dist = 1;
+    mask      = table->table_size - 1;
+    index     = work.hash & mask;
+
+    for(;;){
+        if(table->cells[index].dist == 0){
+            table->cells[index] = work;
+            return;
+        }
+        if(table->cells[index].dist < work.dist){
+            tmp                 = table->cells[index];
+            table->cells[index] = work;
+            work                = tmp;
+        }
+        index = (index + 1) & mask;
+        work.dist++;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブル拡張関数
+//!
+//! 指定サイズの新テーブルを確保し、現在のテーブルを旧テーブルとして
+//! 移行を開始する。<br/>
+//! 要素の移行はhashtable_migrate関数で少しずつおこなう。
+//! 前回の移行が完了していない場合は、残りを移行してから拡張する。
+//!
+//! @param [in]  table       ハッシュテーブル
+//! @param [in]  table_size  拡張後のテーブルサイズ(2のべき乗)
+//!
+//! @retval true   拡張成功
+//! @retval false  拡張失敗(メモリ確保失敗)
+///////////////////////////////////////////////////////////////////////////////
+static bool hashtable_resize(m46e_hashtable_t* table, const uint32_t table_size)
+{
+    // ローカル変数宣言
+    m46e_hash_cell_t* new_cells;
+
+    new_cells = (m46e_hash_cell_t*)calloc(table_size, sizeof(m46e_hash_cell_t));
+    if(new_cells == NULL){
+        return false;
+    }
 
-    for (int i = 0; i < len; i++){
-        hash = 31 * hash + key[i];
+    if(table->old_cells != NULL){
+        // 移行中の場合は残りを全て移行する
+        m46e_logging(LOG_WARNING, "hashtable rehash is not completed. size = %u\n", table->old_size);
+        hashtable_migrate(table, table->old_size);
     }
 
-    return hash % table->table_size;
+    DEBUG_LOG("hashtable resize. %u -> %u\n", table->table_size, table_size);
+
+    table->old_cells   = table->cells;
+    table->old_size    = table->table_size;
+    table->migrate_pos = 0;
+    table->cells       = new_cells;
+    table->table_size  = table_size;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブル移行関数
+//!
+//! 旧テーブルの要素を先頭から指定数だけ新テーブルに移行する。<br/>
+//! 移行した要素は旧テーブル内で位置を変えずに移行済みとし、
+//! 全要素の移行が完了した時点で旧テーブルを解放する。
+//! 要素内のキーとバリューは要素ごと移動するので再確保は不要。
+//!
+//! @param [in]  table       ハッシュテーブル
+//! @param [in]  step        移行する要素数(空き要素を含む)
+//!
+//! @return なし。
+///////////////////////////////////////////////////////////////////////////////
+static void hashtable_migrate(m46e_hashtable_t* table, const uint32_t step)
+{
+    // ローカル変数宣言
+    m46e_hash_cell_t* cell_p;
+
+    if(table->old_cells == NULL){
+        return;
+    }
+
+    for(uint32_t i = 0; (i < step) && (table->migrate_pos < table->old_size); i++){
+        cell_p = &table->old_cells[table->migrate_pos];
+        if((cell_p->dist != 0) && !cell_p->moved){
+            hashtable_place(table, cell_p);
+            cell_p->moved = true;
+        }
+        table->migrate_pos++;
+    }
+
+    if(table->migrate_pos >= table->old_size){
+        // 移行完了
+        free(table->old_cells);
+        table->old_cells   = NULL;
+        table->old_size    = 0;
+        table->migrate_pos = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素配列解放関数
+//!
+//! 要素配列内の全要素のキーとバリューを解放する。(配列自体は解放しない)
+//!
+//! @param [in]  cells       要素配列
+//! @param [in]  table_size  要素配列のサイズ
+//!
+//! @return なし。
+///////////////////////////////////////////////////////////////////////////////
+static void hashtable_release_cells(m46e_hash_cell_t* cells, const uint32_t table_size)
+{
+    // ローカル変数宣言
+    m46e_hash_cell_t* cell_p;
+
+    for(uint32_t i = 0; i < table_size; i++){
+        cell_p = &cells[i];
+        if((cell_p->dist == 0) || cell_p->moved){
+            continue;
+        }
+        hashtable_free_value(cell_p);
+        if(cell_p->key_len > HASHTABLE_INLINE_KEY_SIZE){
+            free(cell_p->key.ptr);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要素バリュー解放関数
+//!
+//! 要素のバリューを解放する。(要素内に格納している場合は何もしない)
+//!
+//! @param [in]  cell      要素
+//!
+//! @return なし。
+///////////////////////////////////////////////////////////////////////////////
+static void hashtable_free_value(m46e_hash_cell_t* cell)
+{
+    if(cell->value_inline){
+        return;
+    }
+    if(cell->delete_func != NULL){
+        // 削除用関数が指定されている場合は、それを呼び出す。
+        cell->delete_func(cell->value.ptr);
+    }
+    else{
+        // 削除用関数が指定されていない場合は、そのままfreeする。
+        free(cell->value.ptr);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ハッシュテーブル全要素巡回関数
 //!
 //! テーブルの全要素に対してコールバック関数を呼び出す。<br/>
+//! コールバック関数内でテーブルへの追加/削除をおこなってはならない。
 //!
 //! @param [in]  table       ハッシュテーブル
 //! @param [in]  callback    コールバック関数
@@ -435,11 +791,18 @@ void m46e_hashtable_foreach(m46e_hashtable_t* table, m46e_hash_foreach_cb callba
         return;
     }
 
-    for(int i=0; i<table->table_size; i++){
-        cell_p = table->cells[i];
-        while(cell_p != NULL){
-            callback(cell_p->key, cell_p->value, userdata);
-            cell_p = cell_p->next;
+    for(uint32_t i=0; i<table->table_size; i++){
+        cell_p = &table->cells[i];
+        if(cell_p->dist != 0){
+            callback(HASHTABLE_CELL_KEY(cell_p), cell_p->key_len, HASHTABLE_CELL_VALUE(cell_p), userdata);
+        }
+    }
+
+    // 移行中の場合は旧テーブルの未移行の要素も対象とする
+    for(uint32_t i=0; (table->old_cells != NULL) && (i<table->old_size); i++){
+        cell_p = &table->old_cells[i];
+        if((cell_p->dist != 0) && !cell_p->moved){
+            callback(HASHTABLE_CELL_KEY(cell_p), cell_p->key_len, HASHTABLE_CELL_VALUE(cell_p), userdata);
         }
     }
 }
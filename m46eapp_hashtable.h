@@ -3,6 +3,7 @@
 /* 機能概要   : ハッシュテーブルクラス ヘッダファイル                         */
 /* 修正履歴   : 2012.02.20 T.Maeda 新規作成                                   */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent ハッシュテーブルのオープンアドレス化         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -23,16 +24,17 @@ typedef void* (*m46e_hash_copy_func)(const void* src, const size_t size);
 //! ユーザ指定ハッシュ要素削除関数
 typedef void  (*m46e_hash_delete_func)(void* obj);
 //! ユーザ指定ハッシュ要素出力関数
-typedef void  (*m46e_hash_foreach_cb)(const char* key, const void* value, void* userdata);
+typedef void  (*m46e_hash_foreach_cb)(const void* key, const size_t key_len, const void* value, void* userdata);
 
 ////////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
 m46e_hashtable_t* m46e_hashtable_create(const uint32_t table_size);
 void  m46e_hashtable_delete(m46e_hashtable_t* table);
-bool  m46e_hashtable_add(m46e_hashtable_t* table, const char* key, const void* value, const size_t value_size, const bool overwrite, m46e_hash_copy_func copy_func, m46e_hash_delete_func delete_func);
-bool  m46e_hashtable_remove(m46e_hashtable_t* table, const char* key, void** value);
-void* m46e_hashtable_get(m46e_hashtable_t* table, const char* key);
+bool  m46e_hashtable_add(m46e_hashtable_t* table, const void* key, const size_t key_len, const void* value, const size_t value_size, const bool overwrite, m46e_hash_copy_func copy_func, m46e_hash_delete_func delete_func);
+bool  m46e_hashtable_remove(m46e_hashtable_t* table, const void* key, const size_t key_len, void** value);
+void* m46e_hashtable_get(m46e_hashtable_t* table, const void* key, const size_t key_len);
+uint32_t m46e_hashtable_count(m46e_hashtable_t* table);
 void  m46e_hashtable_clear(m46e_hashtable_t* table);
 void  m46e_hashtable_foreach(m46e_hashtable_t* table, m46e_hash_foreach_cb callback, void* userdata);
 
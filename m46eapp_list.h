@@ -4,6 +4,7 @@
 /* 修正履歴   : 2012.07.12 T.Maeda 新規作成                                   */
 /*              2013.09.13 K.Nakamura コメント修正                            */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent オブジェクトプール追加                       */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -11,6 +12,7 @@
 #define ___M46EAPP_LIST_H__
 
 #include <stdio.h>
+#include <stddef.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 //! 双方向循環リスト構造体
@@ -31,6 +33,14 @@ typedef struct m46e_list m46e_list;
          __iterator != __list;                  \
          __iterator = __iterator->next)
 
+///////////////////////////////////////////////////////////////////////////////
+//! リスト要素を埋め込んだ構造体の取得マクロ
+//! (構造体のメンバとしてリスト要素を埋め込む場合、dataは使用せずに
+//!  本マクロでリスト要素から構造体の先頭アドレスを求める)
+///////////////////////////////////////////////////////////////////////////////
+#define m46e_list_entry(__node, __type, __member) \
+    ((__type*)((char*)(__node) - offsetof(__type, __member)))
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief リスト初期化関数
 //!
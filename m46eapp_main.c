@@ -6,6 +6,12 @@
 /*              2013.07.11 Y.Shibata 動的定義変更機能追加                     */
 /*              2013.12.02 Y.Shibata 経路同期機能追加                         */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent 統計情報のバイト数/レート追加                */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent OpenMetrics出力追加                          */
+/*              2026.10.18 agent 統計情報領域のseqlock化                      */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
+/*              2026.10.18 agent チェックサム計算のSIMD化                     */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -32,7 +38,9 @@
 #include "m46eapp_command.h"
 #include "m46eapp_setup.h"
 #include "m46eapp_statistics.h"
+#include "m46eapp_metrics.h"
 #include "m46eapp_dynamic_setting.h"
+#include "m46eapp_util.h"
 #include "m46eapp_mng_v6_route.h"
 #include "m46eapp_mng_v4_route.h"
 #include "m46eapp_sync_v6_route.h"
@@ -86,6 +94,8 @@ int main(int argc, char *argv[])
     int                    option_index;
     pthread_t              tunnel_tid;
     pthread_t              v6_sync_route_tid;
+    pthread_t              stat_rate_tid;
+    pthread_t              metrics_tid;
 
 
     ret          = 0;
@@ -93,6 +103,8 @@ int main(int argc, char *argv[])
     option_index = 0;
     tunnel_tid   = -1;
     v6_sync_route_tid = -1;
+    stat_rate_tid     = -1;
+    metrics_tid       = -1;
 
 
     // 引数チェック
@@ -168,13 +180,17 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // チェックサム計算処理の選択
+    m46e_logging(LOG_INFO, "checksum kernel : %s\n", m46e_util_checksum_init());
+
     // 統計情報用の共有メモリ取得＆初期化
-    handler.stat_info = m46e_initial_statistics(handler.conf->filename);
+    handler.stat_info = m46e_initial_statistics(handler.conf->general->plane_name);
     if(handler.stat_info == NULL){
         m46e_logging(LOG_ERR, "fail to initialize statistic info.\n");
         m46e_config_destruct(handler.conf);
         return -1;
     }
+    handler.stat_info->drop_sample_rate = handler.conf->general->drop_sample_rate;
 
     // M46E prefix アドレスの格納
     if(m46e_setup_plane_prefix(&handler) != 0){
@@ -394,6 +410,22 @@ int main(int argc, char *argv[])
         kill(handler.stub_nw_pid, SIGTERM);
     }
 
+    // 転送レート算出スレッド起動
+    if(pthread_create(&stat_rate_tid, NULL, m46e_statistics_rate_thread, handler.stat_info) != 0){
+        // レートが表示されないだけなので、運用は継続する
+        m46e_logging(LOG_WARNING, "fail to create statistics rate thread : %s\n", strerror(errno));
+        stat_rate_tid = -1;
+    }
+
+    // OpenMetrics出力スレッド起動
+    if((handler.conf->general->metrics_socket != NULL) || (handler.conf->general->metrics_port != 0)){
+        if(pthread_create(&metrics_tid, NULL, m46e_metrics_thread, &handler) != 0){
+            // 統計情報が外部から取得できないだけなので、運用は継続する
+            m46e_logging(LOG_WARNING, "fail to create metrics thread : %s\n", strerror(errno));
+            metrics_tid = -1;
+        }
+    }
+
     // mainloop
     ret = m46e_backbone_mainloop(&handler);
 
@@ -424,6 +456,29 @@ proc_end:
         DEBUG_LOG("IPv6 tunnel thread done.");
     }
 
+    if(stat_rate_tid != -1){
+        // スレッドの取り消し
+        pthread_cancel(stat_rate_tid);
+        // スレッドのjoin
+        DEBUG_LOG("waiting for statistics rate thread end.");
+        pthread_join(stat_rate_tid, NULL);
+        DEBUG_LOG("statistics rate thread done.");
+    }
+
+    if(metrics_tid != -1){
+        // スレッドの取り消し
+        pthread_cancel(metrics_tid);
+        // スレッドのjoin
+        DEBUG_LOG("waiting for metrics thread end.");
+        pthread_join(metrics_tid, NULL);
+        DEBUG_LOG("metrics thread done.");
+    }
+
+    // 差分通知スレッドの停止(統計情報領域の解放前に全て終了させる)
+    DEBUG_LOG("waiting for statistics watch threads end.");
+    m46e_statistics_stop_watch();
+    DEBUG_LOG("statistics watch threads done.");
+
     // 後処理
     m46e_delete_network_device(&handler);
     m46e_finish_statistics(handler.stat_info);
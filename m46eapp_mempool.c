@@ -0,0 +1,237 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_mempool.c                                             */
+/* 機能概要   : 固定長オブジェクトプールクラス ソースファイル                 */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "m46eapp_mempool.h"
+#include "m46eapp_log.h"
+
+//! オブジェクトのアライメント
+#define MEMPOOL_ALIGN        sizeof(uint64_t)
+
+////////////////////////////////////////////////////////////////////////////////
+//! スラブ構造体
+//! (オブジェクトslab_num個分の領域をまとめて確保する単位)
+////////////////////////////////////////////////////////////////////////////////
+struct mempool_slab
+{
+    struct mempool_slab* next;     ///< 次のスラブ
+    uint64_t             objs[];   ///< オブジェクト領域
+};
+typedef struct mempool_slab mempool_slab;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 未使用オブジェクト構造体
+//! (未使用のオブジェクト領域の先頭を次の未使用オブジェクトへのリンクに使う)
+////////////////////////////////////////////////////////////////////////////////
+struct mempool_free_obj
+{
+    struct mempool_free_obj* next; ///< 次の未使用オブジェクト
+};
+typedef struct mempool_free_obj mempool_free_obj;
+
+////////////////////////////////////////////////////////////////////////////////
+//! オブジェクトプール構造体
+////////////////////////////////////////////////////////////////////////////////
+struct _m46e_mempool_t
+{
+    pthread_mutex_t     mutex;       ///< 排他用mutex
+    size_t              obj_size;    ///< オブジェクトサイズ(アライメント調整後)
+    uint32_t            slab_num;    ///< スラブあたりのオブジェクト数
+    uint32_t            used;        ///< 使用中のオブジェクト数
+    mempool_slab*       slab_list;   ///< 確保済みスラブのリスト
+    mempool_free_obj*   free_list;   ///< 未使用オブジェクトのリスト
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+static bool mempool_add_slab(m46e_mempool_t* pool);
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief オブジェクトプール 生成関数
+//!
+//! 固定長オブジェクトのプールを生成する。<br/>
+//! オブジェクトの領域はslab_num個単位でまとめて確保し、解放された
+//! オブジェクトはプール内で再利用する。(スラブ自体はプールの解放まで保持する)
+//!
+//! @param [in]     obj_size   オブジェクトのサイズ(byte)
+//! @param [in]     slab_num   スラブあたりのオブジェクト数
+//!
+//! @return 生成したオブジェクトプールへのポインタ
+///////////////////////////////////////////////////////////////////////////////
+m46e_mempool_t* m46e_mempool_create(const size_t obj_size, const uint32_t slab_num)
+{
+    // ローカル変数宣言
+    m46e_mempool_t* pool;
+
+    // 引数チェック
+    if((obj_size == 0) || (slab_num == 0)){
+        return NULL;
+    }
+
+    pool = (m46e_mempool_t*)malloc(sizeof(m46e_mempool_t));
+    if(pool == NULL){
+        return NULL;
+    }
+
+    // 未使用時のリンクを格納できるサイズに切り上げ、アライメントを調整
+    pool->obj_size  = (obj_size < sizeof(mempool_free_obj)) ? sizeof(mempool_free_obj) : obj_size;
+    pool->obj_size  = (pool->obj_size + MEMPOOL_ALIGN - 1) & ~(MEMPOOL_ALIGN - 1);
+    pool->slab_num  = slab_num;
+    pool->used      = 0;
+    pool->slab_list = NULL;
+    pool->free_list = NULL;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+
+    return pool;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief オブジェクトプール 解放関数
+//!
+//! オブジェクトプールと確保済みの全スラブを解放する。<br/>
+//! 使用中のオブジェクトも解放されるので、呼出元で使用を終えてから呼び出すこと。
+//!
+//! @param [in]  pool   解放するオブジェクトプール
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_mempool_destroy(m46e_mempool_t* pool)
+{
+    // ローカル変数宣言
+    mempool_slab* slab;
+    mempool_slab* next;
+
+    // 引数チェック
+    if(pool == NULL){
+        return;
+    }
+
+    if(pool->used != 0){
+        m46e_logging(LOG_WARNING, "mempool destroy with %u objects in use\n", pool->used);
+    }
+
+    for(slab = pool->slab_list; slab != NULL; slab = next){
+        next = slab->next;
+        free(slab);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief オブジェクト確保関数
+//!
+//! プールからオブジェクトを1個確保する。<br/>
+//! 未使用オブジェクトが無い場合はスラブを追加する。
+//! 確保したオブジェクトの内容は不定。
+//!
+//! @param [in]  pool   オブジェクトプール
+//!
+//! @return 確保したオブジェクト。確保失敗時はNULL。
+///////////////////////////////////////////////////////////////////////////////
+void* m46e_mempool_alloc(m46e_mempool_t* pool)
+{
+    // ローカル変数宣言
+    mempool_free_obj* obj;
+
+    // 引数チェック
+    if(pool == NULL){
+        return NULL;
+    }
+
+    // 排他開始
+    pthread_mutex_lock(&pool->mutex);
+
+    if((pool->free_list == NULL) && !mempool_add_slab(pool)){
+        pthread_mutex_unlock(&pool->mutex);
+        return NULL;
+    }
+
+    obj             = pool->free_list;
+    pool->free_list = obj->next;
+    pool->used++;
+
+    // 排他解除
+    pthread_mutex_unlock(&pool->mutex);
+
+    return obj;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief オブジェクト解放関数
+//!
+//! m46e_mempool_allocで確保したオブジェクトをプールへ返却する。
+//!
+//! @param [in]  pool   オブジェクトプール
+//! @param [in]  obj    返却するオブジェクト(NULLの場合は何もしない)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_mempool_free(m46e_mempool_t* pool, void* obj)
+{
+    // 引数チェック
+    if((pool == NULL) || (obj == NULL)){
+        return;
+    }
+
+    // 排他開始
+    pthread_mutex_lock(&pool->mutex);
+
+    ((mempool_free_obj*)obj)->next = pool->free_list;
+    pool->free_list = (mempool_free_obj*)obj;
+    pool->used--;
+
+    // 排他解除
+    pthread_mutex_unlock(&pool->mutex);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief スラブ追加関数
+//!
+//! スラブを1個確保し、全オブジェクトを未使用リストへ追加する。<br/>
+//! 本関数はプールの排他を獲得した状態で呼び出すこと。
+//!
+//! @param [in]  pool   オブジェクトプール
+//!
+//! @retval true   追加成功
+//! @retval false  追加失敗(メモリ確保失敗)
+///////////////////////////////////////////////////////////////////////////////
+static bool mempool_add_slab(m46e_mempool_t* pool)
+{
+    // ローカル変数宣言
+    mempool_slab*     slab;
+    mempool_free_obj* obj;
+
+    slab = (mempool_slab*)malloc(sizeof(mempool_slab) + pool->obj_size * pool->slab_num);
+    if(slab == NULL){
+        m46e_logging(LOG_WARNING, "fail to allocate mempool slab\n");
+        return false;
+    }
+    slab->next      = pool->slab_list;
+    pool->slab_list = slab;
+
+    // 先頭のオブジェクトから順に確保されるよう、末尾から未使用リストへ追加
+    for(uint32_t i = pool->slab_num; i > 0; i--){
+        obj             = (mempool_free_obj*)((char*)slab->objs + pool->obj_size * (i - 1));
+        obj->next       = pool->free_list;
+        pool->free_list = obj;
+    }
+
+    return true;
+}
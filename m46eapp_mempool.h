@@ -0,0 +1,25 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_mempool.h                                             */
+/* 機能概要   : 固定長オブジェクトプールクラス ヘッダファイル                 */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#ifndef __M46EAPP_MEMPOOL_H__
+#define __M46EAPP_MEMPOOL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! オブジェクトプール構造体
+typedef struct _m46e_mempool_t m46e_mempool_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+m46e_mempool_t* m46e_mempool_create(const size_t obj_size, const uint32_t slab_num);
+void  m46e_mempool_destroy(m46e_mempool_t* pool);
+void* m46e_mempool_alloc(m46e_mempool_t* pool);
+void  m46e_mempool_free(m46e_mempool_t* pool, void* obj);
+
+#endif // __M46EAPP_MEMPOOL_H__
@@ -0,0 +1,448 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_metrics.c                                             */
+/* 機能概要   : OpenMetrics形式統計情報出力 ソースファイル                    */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "m46eapp.h"
+#include "m46eapp_metrics.h"
+#include "m46eapp_log.h"
+#include "m46eapp_util.h"
+
+//! 接続待ちキューの長さ
+#define METRICS_LISTEN_BACKLOG      16
+//! リクエスト受信のタイムアウト(秒)
+#define METRICS_RECV_TIMEOUT_SEC    1
+//! リクエスト受信バッファサイズ
+#define METRICS_REQUEST_BUF_SIZE    2048
+//! 待ち受けソケット数(unixドメイン、TCP)
+#define METRICS_LISTEN_NUM          2
+
+//! カウンタ名から除くサフィックス
+#define METRICS_COUNTER_SUFFIX      "_count"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+static int  metrics_open_unix(const char* path);
+static int  metrics_open_tcp(const int port);
+static void metrics_serve(struct m46e_handler_t* handler, int sock);
+static bool metrics_write_all(int fd, const char* buf, size_t len);
+static void metrics_cleanup(void* arg);
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief OpenMetrics出力スレッド
+//!
+//! 設定されたunixドメインソケット(metrics_socket)とループバックの
+//! TCPポート(metrics_port)で接続を待ち受け、HTTPで統計情報を
+//! OpenMetrics形式で返す。(リクエストの内容は問わない)
+//!
+//! @param [in] arg M46Eハンドラ
+//!
+//! @return NULL固定
+///////////////////////////////////////////////////////////////////////////////
+void* m46e_metrics_thread(void* arg)
+{
+    // ローカル変数宣言
+    struct m46e_handler_t* handler;
+    int                    listen_fd[METRICS_LISTEN_NUM];
+    int                    max_fd;
+    int                    sock;
+    int                    state;
+    fd_set                 fds;
+
+    // 引数チェック
+    if(arg == NULL){
+        pthread_exit(NULL);
+    }
+
+    handler      = (struct m46e_handler_t*)arg;
+    listen_fd[0] = -1;
+    listen_fd[1] = -1;
+
+    if(handler->conf->general->metrics_socket != NULL){
+        listen_fd[0] = metrics_open_unix(handler->conf->general->metrics_socket);
+    }
+    if(handler->conf->general->metrics_port != 0){
+        listen_fd[1] = metrics_open_tcp(handler->conf->general->metrics_port);
+    }
+
+    if((listen_fd[0] == -1) && (listen_fd[1] == -1)){
+        m46e_logging(LOG_WARNING, "metrics exporter is not started\n");
+        pthread_exit(NULL);
+    }
+
+    // 後始末ハンドラ登録
+    pthread_cleanup_push(metrics_cleanup, (void*)handler);
+
+    // selector用のファイディスクリプタ設定
+    // (待ち受けるディスクリプタの最大値+1)
+    max_fd = -1;
+    max_fd = max(max_fd, listen_fd[0]);
+    max_fd = max(max_fd, listen_fd[1]);
+    max_fd++;
+
+    m46e_logging(LOG_INFO, "metrics exporter start\n");
+
+    while(1){
+        FD_ZERO(&fds);
+        for(int i = 0; i < METRICS_LISTEN_NUM; i++){
+            if(listen_fd[i] != -1){
+                FD_SET(listen_fd[i], &fds);
+            }
+        }
+
+        // 接続待ち
+        if(select(max_fd, &fds, NULL, NULL, NULL) < 0){
+            if(errno == EINTR){
+                // シグナル割込みの場合は処理継続
+                continue;
+            }
+            m46e_logging(LOG_ERR, "metrics exporter select error : %s\n", strerror(errno));
+            break;
+        }
+
+        for(int i = 0; i < METRICS_LISTEN_NUM; i++){
+            if((listen_fd[i] == -1) || !FD_ISSET(listen_fd[i], &fds)){
+                continue;
+            }
+
+            sock = accept(listen_fd[i], NULL, NULL);
+            if(sock < 0){
+                continue;
+            }
+
+            // 応答中はスレッドの取り消しを保留する
+            pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+            metrics_serve(handler, sock);
+            close(sock);
+            pthread_setcancelstate(state, NULL);
+        }
+    }
+
+    m46e_logging(LOG_INFO, "metrics exporter end\n");
+
+    // 後始末
+    pthread_cleanup_pop(0);
+    for(int i = 0; i < METRICS_LISTEN_NUM; i++){
+        if(listen_fd[i] != -1){
+            close(listen_fd[i]);
+        }
+    }
+    metrics_cleanup(handler);
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief OpenMetrics出力関数
+//!
+//! 統計情報、転送レート、処理時間、各テーブルのエントリ数を
+//! OpenMetrics形式で出力する。全メトリクスにplaneラベルを付与する。
+//!
+//! @param [in] handler M46Eハンドラ
+//! @param [in] fp      出力先
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_metrics_write(struct m46e_handler_t* handler, FILE* fp)
+{
+    // ローカル変数宣言
+    m46e_statistics_t*               statistics = handler->stat_info;
+    m46e_statistics_counter_t        total;
+    const m46e_statistics_latency_t* latency;
+    const m46e_statistics_sample_t*  current;
+    const char*                      plane;
+    const char*                      name;
+    int                              name_len;
+    const char*  direction[M46E_STATISTICS_RATE_DIR_NUM] = { "v4_recv", "v4_send", "v6_recv", "v6_send" };
+    const int    worker[]   = { M46E_STATISTICS_WORKER_ENCAP, M46E_STATISTICS_WORKER_DECAP };
+    const char*  wname[]    = { "encap", "decap" };
+    const double quantile[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    plane = (handler->conf->general->plane_name != NULL) ? handler->conf->general->plane_name : "";
+
+    // カウンタ(統計情報領域のカウンタ名テーブルから、末尾の"_count"を除いて出力)
+    // (整合の取れたスナップショットを取得できない場合はカウンタを出力しない)
+    int counter_num = m46e_statistics_sum(statistics, &total) ? statistics->header.counter_num : 0;
+    for(int i = 0; i < counter_num; i++){
+        name     = statistics->header.name[i].name;
+        name_len = strlen(name);
+        if((name_len > strlen(METRICS_COUNTER_SUFFIX)) &&
+           !strcmp(&name[name_len - strlen(METRICS_COUNTER_SUFFIX)], METRICS_COUNTER_SUFFIX)){
+            name_len -= strlen(METRICS_COUNTER_SUFFIX);
+        }
+        fprintf(fp, "# TYPE m46e_%.*s counter\n", name_len, name);
+        fprintf(fp, "m46e_%.*s_total{plane=\"%s\"} %" PRIu64 "\n", name_len, name, plane,
+            *(uint64_t*)((char*)&total + statistics->header.name[i].offset));
+    }
+
+    // 転送レート(直近1秒)
+    current = NULL;
+    if(statistics->rate.num > 0){
+        current = &statistics->rate.sample[(statistics->rate.head + M46E_STATISTICS_RATE_RING - 1) % M46E_STATISTICS_RATE_RING];
+    }
+    fprintf(fp, "# TYPE m46e_rate_packets_per_second gauge\n");
+    for(int i = 0; i < M46E_STATISTICS_RATE_DIR_NUM; i++){
+        fprintf(fp, "m46e_rate_packets_per_second{plane=\"%s\",direction=\"%s\"} %" PRIu64 "\n",
+            plane, direction[i], (current != NULL) ? current->pps[i] : 0);
+    }
+    fprintf(fp, "# TYPE m46e_rate_bits_per_second gauge\n");
+    for(int i = 0; i < M46E_STATISTICS_RATE_DIR_NUM; i++){
+        fprintf(fp, "m46e_rate_bits_per_second{plane=\"%s\",direction=\"%s\"} %" PRIu64 "\n",
+            plane, direction[i], (current != NULL) ? current->bps[i] : 0);
+    }
+
+    // 処理時間
+    fprintf(fp, "# TYPE m46e_latency_seconds summary\n");
+    for(int i = 0; i < sizeof(worker) / sizeof(worker[0]); i++){
+        latency = &statistics->latency[worker[i]];
+        for(int j = 0; j < sizeof(quantile) / sizeof(quantile[0]); j++){
+            fprintf(fp, "m46e_latency_seconds{plane=\"%s\",worker=\"%s\",quantile=\"%g\"} %.9f\n",
+                plane, wname[i], quantile[j],
+                (double)m46e_statistics_latency_percentile(latency, quantile[j] * 100.0) / 1000000000.0);
+        }
+        fprintf(fp, "m46e_latency_seconds_sum{plane=\"%s\",worker=\"%s\"} %.9f\n",
+            plane, wname[i], (double)latency->sum / 1000000000.0);
+        fprintf(fp, "m46e_latency_seconds_count{plane=\"%s\",worker=\"%s\"} %" PRIu64 "\n",
+            plane, wname[i], latency->count);
+    }
+
+    // テーブルのエントリ数
+    fprintf(fp, "# TYPE m46e_pr_entries gauge\n");
+    fprintf(fp, "m46e_pr_entries{plane=\"%s\"} %u\n", plane, statistics->pr_entry_num);
+    fprintf(fp, "# TYPE m46e_pmtu_entries gauge\n");
+    fprintf(fp, "m46e_pmtu_entries{plane=\"%s\"} %u\n", plane, statistics->pmtu_entry_num);
+    fprintf(fp, "# TYPE m46e_route_entries gauge\n");
+    if(handler->v4_route_info != NULL){
+        fprintf(fp, "m46e_route_entries{plane=\"%s\",family=\"ipv4\"} %d\n", plane, handler->v4_route_info->num);
+    }
+    if(handler->v6_route_info != NULL){
+        fprintf(fp, "m46e_route_entries{plane=\"%s\",family=\"ipv6\"} %d\n", plane, handler->v6_route_info->num);
+    }
+    fprintf(fp, "# TYPE m46e_route_entries_max gauge\n");
+    if(handler->v4_route_info != NULL){
+        fprintf(fp, "m46e_route_entries_max{plane=\"%s\",family=\"ipv4\"} %d\n", plane, handler->v4_route_info->max);
+    }
+    if(handler->v6_route_info != NULL){
+        fprintf(fp, "m46e_route_entries_max{plane=\"%s\",family=\"ipv6\"} %d\n", plane, handler->v6_route_info->max);
+    }
+
+    fprintf(fp, "# EOF\n");
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief unixドメイン待ち受けソケット作成関数
+//!
+//! 既存のソケットファイルは削除してから作成する。
+//!
+//! @param [in] path ソケットファイルのパス
+//!
+//! @return 待ち受けソケットのディスクリプタ。失敗時は-1。
+///////////////////////////////////////////////////////////////////////////////
+static int metrics_open_unix(const char* path)
+{
+    // ローカル変数宣言
+    struct sockaddr_un addr;
+    int                fd;
+
+    if(strlen(path) >= sizeof(addr.sun_path)){
+        m46e_logging(LOG_ERR, "metrics socket path is too long : %s\n", path);
+        return -1;
+    }
+
+    fd = socket(PF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        m46e_logging(LOG_ERR, "fail to create metrics socket : %s\n", strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    unlink(path);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, METRICS_LISTEN_BACKLOG)){
+        m46e_logging(LOG_ERR, "fail to listen metrics socket(%s) : %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief TCP待ち受けソケット作成関数
+//!
+//! ループバックアドレス(127.0.0.1)でのみ待ち受ける。
+//!
+//! @param [in] port ポート番号
+//!
+//! @return 待ち受けソケットのディスクリプタ。失敗時は-1。
+///////////////////////////////////////////////////////////////////////////////
+static int metrics_open_tcp(const int port)
+{
+    // ローカル変数宣言
+    struct sockaddr_in addr;
+    int                fd;
+    int                opt = 1;
+
+    fd = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        m46e_logging(LOG_ERR, "fail to create metrics socket : %s\n", strerror(errno));
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, METRICS_LISTEN_BACKLOG)){
+        m46e_logging(LOG_ERR, "fail to listen metrics port(%d) : %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief OpenMetrics応答関数
+//!
+//! HTTPリクエストヘッダを読み捨て、OpenMetrics形式の統計情報を返す。
+//!
+//! @param [in] handler M46Eハンドラ
+//! @param [in] sock    接続済みソケット
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void metrics_serve(struct m46e_handler_t* handler, int sock)
+{
+    // ローカル変数宣言
+    char           request[METRICS_REQUEST_BUF_SIZE];
+    size_t         request_len;
+    ssize_t        ret;
+    struct timeval timeout;
+    char*          body;
+    size_t         body_len;
+    FILE*          fp;
+    char           header[256];
+    int            header_len;
+
+    // 応答の無いクライアントで待ち続けないようにタイムアウトを設定
+    timeout.tv_sec  = METRICS_RECV_TIMEOUT_SEC;
+    timeout.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // リクエストヘッダの終端まで読み捨てる
+    request_len = 0;
+    while(request_len < sizeof(request) - 1){
+        ret = recv(sock, &request[request_len], sizeof(request) - 1 - request_len, 0);
+        if(ret <= 0){
+            break;
+        }
+        request_len += ret;
+        request[request_len] = '\0';
+        if(strstr(request, "\r\n\r\n") != NULL){
+            break;
+        }
+    }
+
+    body = NULL;
+    fp   = open_memstream(&body, &body_len);
+    if(fp == NULL){
+        m46e_logging(LOG_ERR, "fail to open metrics buffer : %s\n", strerror(errno));
+        return;
+    }
+    m46e_metrics_write(handler, fp);
+    fclose(fp);
+
+    header_len = snprintf(header, sizeof(header),
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n"
+        "\r\n", body_len);
+
+    if(metrics_write_all(sock, header, header_len)){
+        metrics_write_all(sock, body, body_len);
+    }
+
+    free(body);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 全データ送信関数
+//!
+//! @param [in] fd      送信先ディスクリプタ
+//! @param [in] buf     送信データ
+//! @param [in] len     送信データ長
+//!
+//! @retval true   送信成功
+//! @retval false  送信失敗
+///////////////////////////////////////////////////////////////////////////////
+static bool metrics_write_all(int fd, const char* buf, size_t len)
+{
+    // ローカル変数宣言
+    ssize_t ret;
+
+    while(len > 0){
+        ret = send(fd, buf, len, MSG_NOSIGNAL);
+        if(ret < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            DEBUG_LOG("fail to send metrics : %s\n", strerror(errno));
+            return false;
+        }
+        buf += ret;
+        len -= ret;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief OpenMetrics出力スレッド後始末関数
+//!
+//! unixドメインソケットのファイルを削除する。
+//! (待ち受けソケットはプロセス終了時に閉じられる)
+//!
+//! @param [in] arg M46Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void metrics_cleanup(void* arg)
+{
+    // ローカル変数宣言
+    struct m46e_handler_t* handler = (struct m46e_handler_t*)arg;
+
+    if(handler->conf->general->metrics_socket != NULL){
+        unlink(handler->conf->general->metrics_socket);
+    }
+
+    return;
+}
@@ -0,0 +1,21 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_metrics.h                                             */
+/* 機能概要   : OpenMetrics形式統計情報出力 ヘッダファイル                    */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#ifndef __M46EAPP_METRICS_H__
+#define __M46EAPP_METRICS_H__
+
+#include <stdio.h>
+
+struct m46e_handler_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void* m46e_metrics_thread(void* arg);
+void  m46e_metrics_write(struct m46e_handler_t* handler, FILE* fp);
+
+#endif // __M46EAPP_METRICS_H__
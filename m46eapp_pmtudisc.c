@@ -5,11 +5,17 @@
 /*              2012.08.08 T.Maeda Phase4向けに全面改版                       */
 /*              2013.08.30 H.Koganemaru 動的定義変更機能追加                  */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent プレフィックス毎PMTU保持追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
+/*              2026.10.18 agent ハッシュテーブルのオープンアドレス化         */
+/*              2026.10.18 agent オブジェクトプール追加                       */
+/*              2026.10.18 agent OpenMetrics出力追加                          */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
 
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,6 +26,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <time.h>
 #include <linux/rtnetlink.h>
 
 #include "m46eapp.h"
@@ -29,6 +36,9 @@
 #include "m46eapp_log.h"
 #include "m46eapp_timer.h"
 #include "m46eapp_hashtable.h"
+#include "m46eapp_mempool.h"
+#include "m46eapp_pr.h"
+#include "m46eapp_statistics.h"
 
 // デバッグ用マクロ
 #ifdef DEBUG
@@ -40,14 +50,33 @@
 //! デフォルトのPMTUテーブルのキー
 #define PATH_MTU_DEFAULT_KEY   "default"
 
+//! PMTUテーブルのキー長("アドレス/プレフィックス長"形式を格納可能なサイズ)
+#define PATH_MTU_KEY_LEN       (INET6_ADDRSTRLEN + 4)
+
+//! PMTUテーブルに格納するキーのサイズ(終端文字を含めて格納する)
+#define PATH_MTU_KEY_SIZE(key) (strlen(key) + 1)
+
+//! タイマコールバックデータのプールのスラブあたりの個数
+#define PATH_MTU_CB_DATA_SLAB_NUM  64
+
+//! PMTU拡大プローブ送信後、成功と判定するまでの最小待ち時間(秒)
+#define PATH_MTU_PROBE_WAIT    3
+
+//! PMTU拡大プローブ時の候補MTU長(RFC1981のプラトー値を参考)
+static const int path_mtu_plateau[] = { 1280, 1400, 1420, 1440, 1460, 1480, 1492, 1500, 2002, 4352, 8166, 9000 };
+
 ////////////////////////////////////////////////////////////////////////////////
 // Path MTU管理用 内部構造体
 ////////////////////////////////////////////////////////////////////////////////
 //! PMTUテーブルに登録するデータ構造体
 struct path_mtu_data
 {
-    int        mtu;       ///< MTUサイズ
-    timer_t    timerid;   ///< 対応するタイマID
+    int        mtu;            ///< MTUサイズ
+    timer_t    timerid;        ///< 対応するタイマID
+    int        probe_mtu;      ///< プローブ中の候補MTUサイズ(0はプローブ候補なし)
+    bool       probe_sent;     ///< 候補MTUサイズのプローブ送信済みフラグ
+    time_t     probe_time;     ///< プローブ送信時刻
+    timer_t    probe_timerid;  ///< プローブ用タイマID
 };
 typedef struct path_mtu_data path_mtu_data;
 
@@ -59,13 +88,16 @@ struct m46e_pmtud_t
     pthread_mutex_t        mutex;            ///< PMTU用mutex
     m46e_hashtable_t*     table;            ///< PMTU管理テーブル
     m46e_timer_t*         timer_handler;    ///< PMTU管理用タイマハンドラ
+    m46e_mempool_t*       cb_data_pool;     ///< タイマコールバックデータのプール
+    m46e_pr_table_t*      pr_handler;       ///< M46E-PRテーブル(PRモード時のみ)
+    m46e_statistics_t*    stat_info;        ///< 統計情報
 };
 
 //! PMTUタイマT.Oコールバックデータ
 struct pmtu_timer_cb_data_t
 {
     m46e_pmtud_t* handler;                    ///< PMTU管理
-    char           dst_addr[INET6_ADDRSTRLEN]; ///< T.Oしたデータの送信先アドレス
+    char           dst_addr[PATH_MTU_KEY_LEN]; ///< T.Oしたデータの送信先アドレス
 };
 typedef struct pmtu_timer_cb_data_t pmtu_timer_cb_data_t;
 
@@ -81,7 +113,17 @@ typedef struct pmtu_print_data pmtu_print_data;
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
 static void pmtud_timeout_cb(const timer_t timerid, void* data);
-static void pmtu_print_table_line(const char* key, const void* value, void* userdata);
+static void pmtu_print_table_line(const void* key, const size_t key_len, const void* value, void* userdata);
+static void pmtu_make_key(m46e_pmtud_t* pmtud_handler, const struct in6_addr* dst, char* key);
+static void pmtud_probe_cb(const timer_t timerid, void* data);
+static void pmtu_probe_start(m46e_pmtud_t* pmtud_handler, const char* key, path_mtu_data* pmtu_data, const long interval);
+static void pmtu_probe_stop(m46e_pmtud_t* pmtud_handler, path_mtu_data* pmtu_data);
+static time_t pmtu_get_monotonic_sec(void);
+static void pmtu_update_entry_num(m46e_pmtud_t* pmtud_handler);
+static pmtu_timer_cb_data_t* pmtu_cb_data_alloc(m46e_pmtud_t* pmtud_handler, const char* key);
+static void pmtu_cb_data_free(pmtu_timer_cb_data_t* cb_data);
+static void pmtu_timer_cancel(m46e_pmtud_t* pmtud_handler, const timer_t timerid);
+static void pmtu_timer_cancel_entry(const void* key, const size_t key_len, const void* value, void* userdata);
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief Path MTU Discovery初期化関数
@@ -90,10 +132,11 @@ static void pmtu_print_table_line(const char* key, const void* value, void* user
 //!
 //! @param [in]  config       config情報
 //! @param [in]  default_mtu  MTUサイズのデフォルト値
+//! @param [in]  stat_info    統計情報
 //!
 //! @return 生成したPMTU管理クラスへのポインタ
 ///////////////////////////////////////////////////////////////////////////////
-m46e_pmtud_t*  m46e_init_pmtud(m46e_config_pmtud_t* config, int default_mtu)
+m46e_pmtud_t*  m46e_init_pmtud(m46e_config_pmtud_t* config, int default_mtu, m46e_statistics_t* stat_info)
 {
     DEBUG_LOG("pmtud init\n");
 
@@ -111,17 +154,26 @@ m46e_pmtud_t*  m46e_init_pmtud(m46e_config_pmtud_t* config, int default_mtu)
     }
 
     // デフォルトMTUをテーブルに格納
-    path_mtu_data data = { .mtu = default_mtu, .timerid = NULL };
-    bool res = m46e_hashtable_add(handler->table, PATH_MTU_DEFAULT_KEY, &data, sizeof(data), false, NULL, NULL);
+    path_mtu_data data = { .mtu = default_mtu, .timerid = NULL, .probe_mtu = 0, .probe_sent = false, .probe_timerid = NULL };
+    bool res = m46e_hashtable_add(handler->table, PATH_MTU_DEFAULT_KEY, PATH_MTU_KEY_SIZE(PATH_MTU_DEFAULT_KEY), &data, sizeof(data), false, NULL, NULL);
     if(!res){
         m46e_hashtable_delete(handler->table);
         free(handler);
         return NULL;
     }
 
+    // タイマコールバックデータのプール作成
+    handler->cb_data_pool = m46e_mempool_create(sizeof(pmtu_timer_cb_data_t), PATH_MTU_CB_DATA_SLAB_NUM);
+    if(handler->cb_data_pool == NULL){
+        m46e_hashtable_delete(handler->table);
+        free(handler);
+        return NULL;
+    }
+
     // timer作成
     handler->timer_handler = m46e_init_timer();
     if(handler->timer_handler == NULL){
+        m46e_mempool_destroy(handler->cb_data_pool);
         m46e_hashtable_delete(handler->table);
         free(handler);
         return NULL;
@@ -130,6 +182,9 @@ m46e_pmtud_t*  m46e_init_pmtud(m46e_config_pmtud_t* config, int default_mtu)
     // config情報保持
     handler->conf        = config;
     handler->default_mtu = default_mtu;
+    handler->pr_handler  = NULL;
+    handler->stat_info   = stat_info;
+    pmtu_update_entry_num(handler);
 
     // 排他制御初期化
     pthread_mutexattr_t attr;
@@ -156,6 +211,10 @@ void m46e_end_pmtud(m46e_pmtud_t* pmtud_handler){
     // 排他開始
     pthread_mutex_lock(&pmtud_handler->mutex);
 
+    // 起動中のタイマを停止してコールバックデータをプールへ返却
+    // (m46e_end_timerは残ったデータをfreeで解放するため、先に停止する)
+    m46e_hashtable_foreach(pmtud_handler->table, pmtu_timer_cancel_entry, pmtud_handler);
+
     // timer解除
     m46e_end_timer(pmtud_handler->timer_handler);
 
@@ -168,6 +227,7 @@ void m46e_end_pmtud(m46e_pmtud_t* pmtud_handler){
     // 排他制御終了
     pthread_mutex_destroy(&pmtud_handler->mutex); 
 
+    m46e_mempool_destroy(pmtud_handler->cb_data_pool);
     free(pmtud_handler);
 
     return;
@@ -190,6 +250,9 @@ m46e_pmtud_t*  m46e_restart_pmtud(m46e_pmtud_t* pmtud_handler,
     // 排他開始
     pthread_mutex_lock(&pmtud_handler->mutex);
 
+    // 起動中のタイマを停止してコールバックデータをプールへ返却
+    m46e_hashtable_foreach(pmtud_handler->table, pmtu_timer_cancel_entry, pmtud_handler);
+
     // timer解除
     m46e_end_timer(pmtud_handler->timer_handler);
 
@@ -206,8 +269,8 @@ m46e_pmtud_t*  m46e_restart_pmtud(m46e_pmtud_t* pmtud_handler,
     }
 
     // デフォルトMTUをテーブルに格納
-    path_mtu_data data = { .mtu = default_mtu, .timerid = NULL };
-    bool res = m46e_hashtable_add(pmtud_handler->table, PATH_MTU_DEFAULT_KEY, &data, sizeof(data), false, NULL, NULL);
+    path_mtu_data data = { .mtu = default_mtu, .timerid = NULL, .probe_mtu = 0, .probe_sent = false, .probe_timerid = NULL };
+    bool res = m46e_hashtable_add(pmtud_handler->table, PATH_MTU_DEFAULT_KEY, PATH_MTU_KEY_SIZE(PATH_MTU_DEFAULT_KEY), &data, sizeof(data), false, NULL, NULL);
     if(!res){
         m46e_hashtable_delete(pmtud_handler->table);
         m46e_logging(LOG_ERR, "pmtud_mtu set failed.\n");
@@ -228,6 +291,7 @@ m46e_pmtud_t*  m46e_restart_pmtud(m46e_pmtud_t* pmtud_handler,
 
     // handler情報を更新
     pmtud_handler->conf->type = type;
+    pmtu_update_entry_num(pmtud_handler);
 
     // 排他解除
     pthread_mutex_unlock(&pmtud_handler->mutex);
@@ -236,6 +300,35 @@ m46e_pmtud_t*  m46e_restart_pmtud(m46e_pmtud_t* pmtud_handler,
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PRテーブル設定関数
+//!
+//! プレフィックス毎の保持時に参照するM46E-PRテーブルを設定する。
+//! M46E-PRモード以外ではNULLを設定する。
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//! @param [in]     pr_handler    M46E-PRテーブル
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_pmtud_set_pr_table(m46e_pmtud_t* pmtud_handler, m46e_pr_table_t* pr_handler)
+{
+    // 引数チェック
+    if(pmtud_handler == NULL){
+        return;
+    }
+
+    // 排他開始
+    pthread_mutex_lock(&pmtud_handler->mutex);
+
+    pmtud_handler->pr_handler = pr_handler;
+
+    // 排他解除
+    pthread_mutex_unlock(&pmtud_handler->mutex);
+
+    return;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief Path MTU 設定関数
 //!
@@ -253,7 +346,7 @@ void m46e_path_mtu_set(
     int                pmtu
 )
 {
-    char dst_addr[INET6_ADDRSTRLEN];
+    char dst_addr[PATH_MTU_KEY_LEN];
     int  result;
 
     DEBUG_LOG("pmtu discovery. pmtu = %d\n",pmtu);
@@ -266,20 +359,14 @@ void m46e_path_mtu_set(
     // 排他開始
     pthread_mutex_lock(&pmtud_handler->mutex);
 
-    if(pmtud_handler->conf->type == M46E_PMTUD_TYPE_HOST){
-        // ホスト毎の保持の場合、IPv6アドレスを文字列変換
-        inet_ntop(AF_INET6, dst, dst_addr, sizeof(dst_addr));
-    }
-    else{
-        // それ以外(トンネル毎)の場合はデフォルトキーで検索
-        strcpy(dst_addr, PATH_MTU_DEFAULT_KEY);
-    }
+    // 保持タイプに応じたキーを生成
+    pmtu_make_key(pmtud_handler, dst, dst_addr);
 
     // pmtuサイズチェック
     pmtu = max(pmtu, IPV6_MIN_MTU);
     
     // pmtu保持テーブルから対象の情報を取得
-    path_mtu_data* pmtu_data = m46e_hashtable_get(pmtud_handler->table, dst_addr);
+    path_mtu_data* pmtu_data = m46e_hashtable_get(pmtud_handler->table, dst_addr, PATH_MTU_KEY_SIZE(dst_addr));
 
     if(pmtu_data != NULL){
         // 一致する情報がある場合
@@ -300,11 +387,8 @@ void m46e_path_mtu_set(
             }
             else{
                 // タイマが起動中で無い場合はタイマ起動
-                pmtu_timer_cb_data_t* cb_data = malloc(sizeof(pmtu_timer_cb_data_t));
+                pmtu_timer_cb_data_t* cb_data = pmtu_cb_data_alloc(pmtud_handler, dst_addr);
                 if(cb_data != NULL){
-                    cb_data->handler = pmtud_handler;
-                    strcpy(cb_data->dst_addr, dst_addr);
-
                     result = m46e_timer_register(
                         pmtud_handler->timer_handler,
                         pmtud_handler->conf->expire_time,
@@ -312,6 +396,9 @@ void m46e_path_mtu_set(
                         cb_data,
                         &pmtu_data->timerid
                     );
+                    if(result != 0){
+                        pmtu_cb_data_free(cb_data);
+                    }
                 }
                 else{
                     m46e_logging(LOG_WARNING, "fail to allocate timer callback data\n");
@@ -323,6 +410,19 @@ void m46e_path_mtu_set(
                 // タイマを停止に設定
                 pmtu_data->timerid = NULL;
             }
+
+            // プローブ中の場合は失敗として候補をクリアし、PMTU拡大プローブを開始
+            pmtu_data->probe_mtu  = 0;
+            pmtu_data->probe_sent = false;
+            pmtu_probe_start(pmtud_handler, dst_addr, pmtu_data, pmtud_handler->conf->probe_interval);
+        }
+        else if((pmtu_data->probe_mtu > 0) && (pmtu < pmtu_data->probe_mtu)){
+            // プローブ中に候補より小さいMTU値を受信したのでプローブ失敗
+            // (Packet Too BigでPMTUを拡大してはならないので(RFC8201 4章)、
+            //  現在値以上のMTU値であっても現在値は更新しない)
+            DEBUG_LOG("pmtu probe failed. dst(%s) probe(%d) pmtu(%d)\n", dst_addr, pmtu_data->probe_mtu, pmtu);
+            pmtu_data->probe_mtu  = 0;
+            pmtu_data->probe_sent = false;
         }
         else{
             // MTU値が現在値よりも大きいので無視。
@@ -333,14 +433,11 @@ void m46e_path_mtu_set(
         // 一致する情報がない場合
 
         // 新規追加データ設定
-        path_mtu_data data = { .mtu = pmtu, .timerid = NULL };
+        path_mtu_data data = { .mtu = pmtu, .timerid = NULL, .probe_mtu = 0, .probe_sent = false, .probe_timerid = NULL };
 
-        // タイマアウト時に通知される情報のメモリ確保
-        pmtu_timer_cb_data_t* cb_data = malloc(sizeof(pmtu_timer_cb_data_t));
+        // タイマアウト時に通知される情報をプールから確保
+        pmtu_timer_cb_data_t* cb_data = pmtu_cb_data_alloc(pmtud_handler, dst_addr);
         if(cb_data != NULL){
-            cb_data->handler = pmtud_handler;
-            strcpy(cb_data->dst_addr, dst_addr);
-
             // PMTU保持タイマ登録
             result = m46e_timer_register(
                 pmtud_handler->timer_handler,
@@ -357,9 +454,18 @@ void m46e_path_mtu_set(
 
         if(result == 0){
             // データ追加処理
-            if(m46e_hashtable_add(pmtud_handler->table, dst_addr, &data, sizeof(data), false, NULL, NULL)){
+            if(m46e_hashtable_add(pmtud_handler->table, dst_addr, PATH_MTU_KEY_SIZE(dst_addr), &data, sizeof(data), false, NULL, NULL)){
                 DEBUG_LOG("pmtu_info add. dst(%s) pmtu(%d) timer(%p)\n", dst_addr, data.mtu, data.timerid);
                 result = 0;
+                pmtu_update_entry_num(pmtud_handler);
+
+                // PMTU拡大プローブを開始
+                pmtu_probe_start(
+                    pmtud_handler,
+                    dst_addr,
+                    m46e_hashtable_get(pmtud_handler->table, dst_addr, PATH_MTU_KEY_SIZE(dst_addr)),
+                    pmtud_handler->conf->probe_interval
+                );
             }
             else{
                 m46e_logging(LOG_WARNING, "pmtud_data add failed.\n");
@@ -372,7 +478,7 @@ void m46e_path_mtu_set(
         if(result != 0){
             m46e_logging(LOG_INFO, "pmtud_timer set failed.\n");
             // コールバックデータ解放
-            free(cb_data);
+            pmtu_cb_data_free(cb_data);
         }
     }
 
@@ -397,7 +503,7 @@ int m46e_path_mtu_get(
     const struct in6_addr* v6daddr
 )
 {
-    char            dst_addr[INET6_ADDRSTRLEN];
+    char            dst_addr[PATH_MTU_KEY_LEN];
     path_mtu_data*  data;
     int             result;
 
@@ -417,12 +523,13 @@ int m46e_path_mtu_get(
     //_D_(m46e_pmtu_print_table(pmtud_handler, STDOUT_FILENO);)
 
     switch(pmtud_handler->conf->type){
-    case M46E_PMTUD_TYPE_HOST: // ホスト毎の場合
-        // IPv6アドレス文字列変換
-        inet_ntop(AF_INET6, v6daddr, dst_addr, sizeof(dst_addr));
+    case M46E_PMTUD_TYPE_HOST:   // ホスト毎の場合
+    case M46E_PMTUD_TYPE_PREFIX: // プレフィックス毎の場合
+        // 保持タイプに応じたキーを生成
+        pmtu_make_key(pmtud_handler, v6daddr, dst_addr);
         
         // v6アドレスをkeyにデータ検索
-        data = m46e_hashtable_get(pmtud_handler->table, dst_addr);
+        data = m46e_hashtable_get(pmtud_handler->table, dst_addr, PATH_MTU_KEY_SIZE(dst_addr));
         if(data != NULL){
             result = data->mtu;
             DEBUG_LOG("pmtu_info get. dst(%s)--->pmtu %d\n", dst_addr, result);
@@ -433,7 +540,7 @@ int m46e_path_mtu_get(
  
     default:
         // デフォルトキーでデータ検索
-        data = m46e_hashtable_get(pmtud_handler->table, PATH_MTU_DEFAULT_KEY);
+        data = m46e_hashtable_get(pmtud_handler->table, PATH_MTU_DEFAULT_KEY, PATH_MTU_KEY_SIZE(PATH_MTU_DEFAULT_KEY));
         if(data != NULL){
             result = data->mtu;
             DEBUG_LOG("pmtu_info get. dst(%s)--->pmtu %d\n", PATH_MTU_DEFAULT_KEY, result);
@@ -455,6 +562,144 @@ int m46e_path_mtu_get(
     return result;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTU拡大プローブ判定関数
+//!
+//! PMTUを超えるパケットを、PMTU拡大プローブとしてフラグメントせずに
+//! 送信するかどうかを判定する。
+//! 宛先のPMTU情報にプローブ候補のMTU長があり、未送信で、
+//! パケット長が候補のMTU長以下の場合にプローブとする。
+//!
+//! @param [in]     pmtud_handler    PMTU管理
+//! @param [in]     v6daddr          宛先アドレス
+//! @param [in]     size             送信するIPv6パケット長
+//!
+//! @retval true   プローブとしてフラグメントせずに送信する
+//! @retval false  プローブではない
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_path_mtu_probe(
+    m46e_pmtud_t*         pmtud_handler,
+    const struct in6_addr* v6daddr,
+    const int              size
+)
+{
+    char            dst_addr[PATH_MTU_KEY_LEN];
+    path_mtu_data*  data;
+    bool            result;
+
+    // パラメタチェック
+    if((pmtud_handler == NULL) || (v6daddr == NULL)){
+        return false;
+    }
+
+    if(pmtud_handler->conf->probe_interval == 0){
+        // プローブ無しの場合は何もせずにリターン
+        return false;
+    }
+
+    // 排他開始
+    pthread_mutex_lock(&pmtud_handler->mutex);
+
+    data = NULL;
+    if((pmtud_handler->conf->type == M46E_PMTUD_TYPE_HOST) ||
+       (pmtud_handler->conf->type == M46E_PMTUD_TYPE_PREFIX)){
+        // 保持タイプに応じたキーでデータ検索
+        pmtu_make_key(pmtud_handler, v6daddr, dst_addr);
+        data = m46e_hashtable_get(pmtud_handler->table, dst_addr, PATH_MTU_KEY_SIZE(dst_addr));
+    }
+    if(data == NULL){
+        // 見つからなかった場合はデフォルトキーでデータ検索
+        data = m46e_hashtable_get(pmtud_handler->table, PATH_MTU_DEFAULT_KEY, PATH_MTU_KEY_SIZE(PATH_MTU_DEFAULT_KEY));
+    }
+
+    result = false;
+    if((data != NULL) && (data->probe_mtu > 0) && !data->probe_sent &&
+       (data->mtu < size) && (size <= data->probe_mtu)){
+        DEBUG_LOG("pmtu probe send. size(%d) probe(%d)\n", size, data->probe_mtu);
+        data->probe_sent = true;
+        data->probe_time = pmtu_get_monotonic_sec();
+        if(pmtud_handler->stat_info != NULL){
+            m46e_inc_pmtu_probe_send(pmtud_handler->stat_info);
+        }
+        result = true;
+    }
+
+    // 排他解除
+    pthread_mutex_unlock(&pmtud_handler->mutex);
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTUテーブルキー生成関数
+//!
+//! 保持タイプに応じてPMTUテーブルのキー文字列を生成する。
+//! ・ホスト毎     ：宛先IPv6アドレス
+//! ・プレフィックス毎：M46E-PRモードでは一致したM46E-PR prefix、
+//!                   それ以外は設定されたプレフィックス長でマスクしたアドレス
+//! ・トンネル毎   ：デフォルトキー
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//! @param [in]     dst           宛先アドレス
+//! @param [out]    key           キー格納先(PATH_MTU_KEY_LEN以上の領域)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_make_key(m46e_pmtud_t* pmtud_handler, const struct in6_addr* dst, char* key)
+{
+    // ローカル変数宣言
+    struct in6_addr  prefix;
+    int              prefix_len;
+    char             address[INET6_ADDRSTRLEN];
+
+    switch(pmtud_handler->conf->type){
+    case M46E_PMTUD_TYPE_HOST:
+        // ホスト毎の保持の場合、IPv6アドレスを文字列変換
+        inet_ntop(AF_INET6, dst, key, INET6_ADDRSTRLEN);
+        break;
+
+    case M46E_PMTUD_TYPE_PREFIX:
+        prefix     = *dst;
+        prefix_len = pmtud_handler->conf->prefix_len;
+
+        if(pmtud_handler->pr_handler != NULL){
+            // M46E-PRモードの場合は宛先に一致するM46E-PR prefixを使用する
+            struct in_addr v4daddr = { .s_addr = dst->s6_addr32[3] };
+            m46e_pr_entry_t* entry = m46e_pr_entry_search_stub(pmtud_handler->pr_handler, &v4daddr);
+            if((entry != NULL) && IS_EQUAL_M46E_PR_PREFIX(dst, &entry->pr_prefix_planeid)){
+                prefix                 = entry->pr_prefix_planeid;
+                prefix.s6_addr32[3]    = entry->v4addr.s_addr;
+                prefix_len             = 96 + entry->v4cidr;
+                snprintf(key, PATH_MTU_KEY_LEN, "%s/%d",
+                    inet_ntop(AF_INET6, &prefix, address, sizeof(address)), prefix_len);
+                break;
+            }
+        }
+
+        // プレフィックス長でマスク
+        for(int i = 0; i < 16; i++){
+            if(prefix_len >= CHAR_BIT){
+                prefix_len -= CHAR_BIT;
+            }
+            else{
+                prefix.s6_addr[i] &= (uint8_t)(0xff << (CHAR_BIT - prefix_len));
+                prefix_len = 0;
+            }
+        }
+        snprintf(key, PATH_MTU_KEY_LEN, "%s/%d",
+            inet_ntop(AF_INET6, &prefix, address, sizeof(address)),
+            pmtud_handler->conf->prefix_len);
+        break;
+
+    default:
+        // それ以外(トンネル毎)の場合はデフォルトキー
+        strcpy(key, PATH_MTU_DEFAULT_KEY);
+        break;
+    }
+
+    return;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief PMTU保持タイムアウトコールバック関数
 //!
@@ -477,9 +722,12 @@ static void pmtud_timeout_cb(const timer_t timerid, void* data)
     // 排他開始
     pthread_mutex_lock(&cb_data->handler->mutex);
 
-    path_mtu_data* pmtu_data = m46e_hashtable_get(cb_data->handler->table, cb_data->dst_addr);
+    path_mtu_data* pmtu_data = m46e_hashtable_get(cb_data->handler->table, cb_data->dst_addr, PATH_MTU_KEY_SIZE(cb_data->dst_addr));
+
+    if(pmtu_data != NULL){
+        // PMTU拡大プローブを停止
+        pmtu_probe_stop(cb_data->handler, pmtu_data);
 
-    if(data != NULL){
         if(!strcmp(PATH_MTU_DEFAULT_KEY, cb_data->dst_addr)){
             // デフォルトの場合はデータを削除せずに初期値に戻す
             pmtu_data->mtu     = cb_data->handler->default_mtu;
@@ -496,7 +744,8 @@ static void pmtud_timeout_cb(const timer_t timerid, void* data)
                     timerid, pmtu_data->timerid, cb_data->dst_addr
                 );
             }
-            m46e_hashtable_remove(cb_data->handler->table, cb_data->dst_addr, NULL);
+            m46e_hashtable_remove(cb_data->handler->table, cb_data->dst_addr, PATH_MTU_KEY_SIZE(cb_data->dst_addr), NULL);
+            pmtu_update_entry_num(cb_data->handler);
         }
     }
     else{
@@ -506,11 +755,263 @@ static void pmtud_timeout_cb(const timer_t timerid, void* data)
     // 排他解除
     pthread_mutex_unlock(&cb_data->handler->mutex);
     
-    free(cb_data);
+    pmtu_cb_data_free(cb_data);
 
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTU拡大プローブタイムアウトコールバック関数
+//!
+//! プローブ送信済みで、待ち時間内にPacket Too Bigを受信していなければ
+//! プローブ成功としてPMTU値を候補のMTU長に拡大する。
+//! デフォルトのMTU長に戻るまで、次の候補でプローブを継続する。
+//!
+//! @param [in]     timerid   タイマ登録時に払い出されたタイマID
+//! @param [in]     data      タイマ登録時に設定したデータ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtud_probe_cb(const timer_t timerid, void* data)
+{
+    pmtu_timer_cb_data_t* cb_data = (pmtu_timer_cb_data_t*)data;
+
+    if(cb_data == NULL){
+        DEBUG_LOG("path mtu probe param error.\n");
+        return;
+    }
+
+    m46e_pmtud_t* handler = cb_data->handler;
+
+    // 排他開始
+    pthread_mutex_lock(&handler->mutex);
+
+    path_mtu_data* pmtu_data = m46e_hashtable_get(handler->table, cb_data->dst_addr, PATH_MTU_KEY_SIZE(cb_data->dst_addr));
+
+    if((pmtu_data == NULL) || (pmtu_data->probe_timerid != timerid)){
+        // 既にプローブが停止されている
+        DEBUG_LOG("path mtu probe is already stopped. addr = %s\n", cb_data->dst_addr);
+        pthread_mutex_unlock(&handler->mutex);
+        pmtu_cb_data_free(cb_data);
+        return;
+    }
+    pmtu_data->probe_timerid = NULL;
+
+    if((pmtu_data->probe_mtu > 0) && pmtu_data->probe_sent){
+        time_t elapsed = pmtu_get_monotonic_sec() - pmtu_data->probe_time;
+        if(elapsed < PATH_MTU_PROBE_WAIT){
+            // プローブ送信直後なので、待ち時間経過後に再判定
+            pmtu_probe_start(handler, cb_data->dst_addr, pmtu_data, PATH_MTU_PROBE_WAIT - elapsed);
+            pthread_mutex_unlock(&handler->mutex);
+            pmtu_cb_data_free(cb_data);
+            return;
+        }
+
+        // Packet Too Bigを受信していないのでプローブ成功
+        DEBUG_LOG("pmtu_info restore. dst(%s) pmtu(%d->%d)\n", cb_data->dst_addr, pmtu_data->mtu, pmtu_data->probe_mtu);
+        pmtu_data->mtu = pmtu_data->probe_mtu;
+        if(handler->stat_info != NULL){
+            m46e_inc_pmtu_probe_restore(handler->stat_info);
+        }
+    }
+
+    pmtu_data->probe_mtu  = 0;
+    pmtu_data->probe_sent = false;
+
+    if(pmtu_data->mtu < handler->default_mtu){
+        // 次の候補MTU長を決定してプローブ継続
+        pmtu_data->probe_mtu = handler->default_mtu;
+        for(int i = 0; i < sizeof(path_mtu_plateau)/sizeof(path_mtu_plateau[0]); i++){
+            if(path_mtu_plateau[i] > pmtu_data->mtu){
+                pmtu_data->probe_mtu = min(path_mtu_plateau[i], handler->default_mtu);
+                break;
+            }
+        }
+        pmtu_probe_start(handler, cb_data->dst_addr, pmtu_data, handler->conf->probe_interval);
+    }
+
+    // 排他解除
+    pthread_mutex_unlock(&handler->mutex);
+
+    pmtu_cb_data_free(cb_data);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTU拡大プローブ開始関数
+//!
+//! PMTU拡大プローブ用のタイマを起動する。
+//! プローブ無しの設定の場合、またはタイマ起動中の場合は何もしない。
+//! 本関数はPMTU管理の排他を獲得した状態で呼び出すこと。
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//! @param [in]     key           PMTUテーブルのキー
+//! @param [in,out] pmtu_data     PMTUテーブルに登録されているデータ
+//! @param [in]     interval      タイムアウト時間(秒)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_probe_start(
+    m46e_pmtud_t*  pmtud_handler,
+    const char*     key,
+    path_mtu_data*  pmtu_data,
+    const long      interval
+)
+{
+    if((pmtu_data == NULL) || (interval <= 0) || (pmtu_data->probe_timerid != NULL)){
+        return;
+    }
+
+    pmtu_timer_cb_data_t* cb_data = pmtu_cb_data_alloc(pmtud_handler, key);
+    if(cb_data == NULL){
+        m46e_logging(LOG_WARNING, "fail to allocate probe timer callback data\n");
+        return;
+    }
+
+    int result = m46e_timer_register(
+        pmtud_handler->timer_handler,
+        interval,
+        pmtud_probe_cb,
+        cb_data,
+        &pmtu_data->probe_timerid
+    );
+    if(result != 0){
+        m46e_logging(LOG_WARNING, "fail to register probe timer\n");
+        pmtu_data->probe_timerid = NULL;
+        pmtu_cb_data_free(cb_data);
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTU拡大プローブ停止関数
+//!
+//! PMTU拡大プローブ用のタイマを停止し、プローブ状態をクリアする。
+//! 本関数はPMTU管理の排他を獲得した状態で呼び出すこと。
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//! @param [in,out] pmtu_data     PMTUテーブルに登録されているデータ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_probe_stop(m46e_pmtud_t* pmtud_handler, path_mtu_data* pmtu_data)
+{
+    if(pmtu_data->probe_timerid != NULL){
+        pmtu_timer_cancel(pmtud_handler, pmtu_data->probe_timerid);
+        pmtu_data->probe_timerid = NULL;
+    }
+    pmtu_data->probe_mtu  = 0;
+    pmtu_data->probe_sent = false;
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマコールバックデータ確保関数
+//!
+//! タイマコールバックデータをプールから確保し、PMTU管理とキーを設定する。
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//! @param [in]     key           PMTUテーブルのキー
+//!
+//! @return 確保したコールバックデータ。確保失敗時はNULL。
+///////////////////////////////////////////////////////////////////////////////
+static pmtu_timer_cb_data_t* pmtu_cb_data_alloc(m46e_pmtud_t* pmtud_handler, const char* key)
+{
+    pmtu_timer_cb_data_t* cb_data = m46e_mempool_alloc(pmtud_handler->cb_data_pool);
+
+    if(cb_data != NULL){
+        cb_data->handler = pmtud_handler;
+        strcpy(cb_data->dst_addr, key);
+    }
+
+    return cb_data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマコールバックデータ解放関数
+//!
+//! タイマコールバックデータを確保元のプールへ返却する。
+//!
+//! @param [in]     cb_data       返却するコールバックデータ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_cb_data_free(pmtu_timer_cb_data_t* cb_data)
+{
+    if(cb_data != NULL){
+        m46e_mempool_free(cb_data->handler->cb_data_pool, cb_data);
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマ停止関数
+//!
+//! タイマを停止し、登録していたコールバックデータをプールへ返却する。
+//! 既にタイムアウトしている場合はコールバック側で返却するので何もしない。
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//! @param [in]     timerid       停止するタイマID(NULLの場合は何もしない)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_timer_cancel(m46e_pmtud_t* pmtud_handler, const timer_t timerid)
+{
+    void* cb_data = NULL;
+
+    if(timerid == NULL){
+        return;
+    }
+
+    if(m46e_timer_cancel(pmtud_handler->timer_handler, timerid, &cb_data) == 0){
+        pmtu_cb_data_free(cb_data);
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTUテーブルエントリ タイマ停止関数
+//!
+//! PMTUテーブルのエントリ毎に呼ばれ、保持タイマとプローブタイマを停止する。
+//! (m46e_hashtable_foreachのコールバック)
+//!
+//! @param [in]     key           PMTUテーブルのキー
+//! @param [in]     key_len       キー長
+//! @param [in]     value         PMTUテーブルに登録されているデータ
+//! @param [in]     userdata      PMTU管理
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_timer_cancel_entry(const void* key, const size_t key_len, const void* value, void* userdata)
+{
+    const path_mtu_data* pmtu_data     = (const path_mtu_data*)value;
+    m46e_pmtud_t*        pmtud_handler = (m46e_pmtud_t*)userdata;
+
+    pmtu_timer_cancel(pmtud_handler, pmtu_data->timerid);
+    pmtu_timer_cancel(pmtud_handler, pmtu_data->probe_timerid);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 単調増加時刻取得関数
+//!
+//! @return 単調増加時刻(秒)
+///////////////////////////////////////////////////////////////////////////////
+static time_t pmtu_get_monotonic_sec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ハッシュテーブル内部情報出力関数
 //!
@@ -547,13 +1048,14 @@ void m46e_pmtu_print_table(m46e_pmtud_t* pmtud_handler, int fd)
 //! ハッシュテーブルログ出力時にコールバック登録する関数
 //!
 //! @param [in]     key       テーブルに登録されているキー
+//! @param [in]     key_len   キー長
 //! @param [in]     value     キーに対応する値
 //! @param [in]     userdata  コールバック登録時に指定したユーザデータ
 //!                           (pmtu_print_data構造体)
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-static void pmtu_print_table_line(const char* key, const void* value, void* userdata)
+static void pmtu_print_table_line(const void* key, const size_t key_len, const void* value, void* userdata)
 {
     // 引数チェック
     if(value == NULL || userdata == NULL){
@@ -573,8 +1075,26 @@ static void pmtu_print_table_line(const char* key, const void* value, void* user
     }
 
     // mtu長出力
-    dprintf(print_data->fd, "%-46s|%10d|%12ld\n", key, data->mtu, tmspec.it_value.tv_sec);
+    dprintf(print_data->fd, "%-46s|%10d|%12ld\n", (const char*)key, data->mtu, tmspec.it_value.tv_sec);
 
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PMTUテーブルエントリ数更新関数
+//!
+//! 統計情報のPMTUテーブルエントリ数(OpenMetrics出力用)を更新する。
+//! 本関数はPMTU管理の排他を獲得した状態で呼び出すこと。
+//!
+//! @param [in]     pmtud_handler PMTU管理
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void pmtu_update_entry_num(m46e_pmtud_t* pmtud_handler)
+{
+    if(pmtud_handler->stat_info != NULL){
+        pmtud_handler->stat_info->pmtu_entry_num = m46e_hashtable_count(pmtud_handler->table);
+    }
+
+    return;
+}
@@ -6,6 +6,8 @@
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2014.01.21 M.Iwatsubo M46E-PR外部連携機能追加                 */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent オブジェクトプール追加                       */
+/*              2026.10.18 agent OpenMetrics出力追加                          */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2013-2016                */
 /******************************************************************************/
@@ -27,6 +29,7 @@
 #include "m46eapp_command.h"
 #include "m46eapp_pr_struct.h"
 #include "m46eapp_network.h"
+#include "m46eapp_mempool.h"
 
 // デバッグ用マクロ
 #ifdef DEBUG
@@ -35,9 +38,20 @@
 #define _D_(x)
 #endif
 
+//! M46E-PR Entry用オブジェクトプールのスラブあたりのエントリー数
+#define PR_ENTRY_POOL_SLAB_NUM  256
+
+//! M46E-PR Entry用オブジェクトプール
+static m46e_mempool_t* pr_entry_pool      = NULL;
+//! M46E-PR Entry用オブジェクトプール初期化制御
+static pthread_once_t  pr_entry_pool_once = PTHREAD_ONCE_INIT;
+
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
+static void m46e_pr_entry_pool_init(void);
+static m46e_pr_entry_t* m46e_pr_alloc_entry(void);
+static void m46e_pr_update_entry_num(struct m46e_handler_t* handler, m46e_pr_table_t* table);
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -92,8 +106,11 @@ m46e_pr_table_t* m46e_pr_init_pr_table(struct m46e_handler_t* handler)
             m46e_logging(LOG_ERR, "fail to convert entry.\n");
             return NULL;
         }
-        m46e_pr_add_entry(pr_table, pr_entry);
+        if(!m46e_pr_add_entry(pr_table, pr_entry)){
+            m46e_pr_free_entry(pr_entry);
+        }
     }
+    m46e_pr_update_entry_num(handler, pr_table);
 
     return pr_table;
 }
@@ -117,10 +134,9 @@ void m46e_pr_destruct_pr_table(m46e_pr_table_t* pr_handler)
     // M46E-PR Entry削除
     while(!m46e_list_empty(&pr_handler->entry_list)){
         m46e_list* node = pr_handler->entry_list.next;
-        m46e_pr_entry_t* pr_entry = node->data;
-        free(pr_entry);
+        m46e_pr_entry_t* pr_entry = m46e_list_entry(node, m46e_pr_entry_t, list);
         m46e_list_del(node);
-        free(node);
+        m46e_pr_free_entry(pr_entry);
         pr_handler->num--;
     }
 
@@ -502,7 +518,7 @@ void m46e_pr_table_dump(const m46e_pr_table_t* table)
 
     m46e_list* iter;
     m46e_list_for_each(iter, &table->entry_list){
-        m46e_pr_entry_t* entry = iter->data;
+        m46e_pr_entry_t* entry = m46e_list_entry(iter, m46e_pr_entry_t, list);
         DEBUG_LOG("%s v4address = %s/%d",
                 strbool[entry->enable],
                 inet_ntop(AF_INET,  &entry->v4addr, address, sizeof(address)), entry->v4cidr);
@@ -525,7 +541,7 @@ void m46e_pr_table_dump(const m46e_pr_table_t* table)
 //! 新たなエントリーは、IPv4アドレスのサブネットマスク長を基準に、
 //! 降順でソートして追加する。
 //! 本関数内でM46E-PR Tableへアクセスするための排他の獲得と解放を行う。
-//! ※entryは、ヒープ領域(malloc関数などで確保したメモリ領域)を渡すこと。
+//! ※entryは、m46e_pr_conf2entry関数などで確保したエントリーを渡すこと。
 //! エントリーのIPv4アドレスがネットワークアドレスでない場合は、
 //! 追加失敗とする。
 //! テーブル内にIPv4アドレスとv4cidrが同一のエントリーが既にある場合は、
@@ -565,18 +581,13 @@ bool m46e_pr_add_entry(m46e_pr_table_t* table, m46e_pr_entry_t* entry)
         // 要素数のインクリメント
         table->num++;
 
-        m46e_list* node = malloc(sizeof(m46e_list));
-        if(node == NULL){
-            m46e_logging(LOG_WARNING, "fail to allocate M46E-PR data.\n");
-            return false;
-        }
-
+        // エントリーに埋め込まれたリスト要素でテーブルに連結する
+        m46e_list* node = &entry->list;
         m46e_list_init(node);
-        m46e_list_add_data(node, entry);
 
         m46e_list* iter;
         m46e_list_for_each(iter, &table->entry_list){
-            m46e_pr_entry_t* tmp = iter->data;
+            m46e_pr_entry_t* tmp = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             // v4netmask長の大小判定
             if (entry->v4cidr >= tmp->v4cidr) {
@@ -640,15 +651,14 @@ bool m46e_pr_del_entry(m46e_pr_table_t* table, struct in_addr* addr, int cidr)
 
         m46e_list* iter;
         m46e_list_for_each(iter, &table->entry_list){
-            m46e_pr_entry_t* tmp = iter->data;
+            m46e_pr_entry_t* tmp = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             // アドレスとネットマスクが一致するエントリーを検索
             if ((addr->s_addr == tmp->v4addr.s_addr) && (cidr == tmp->v4cidr)) {
 
                 // 一致したエントリーを削除
-                free(tmp);
                 m46e_list_del(iter);
-                free(iter);
+                m46e_pr_free_entry(tmp);
 
                 // 要素数のディクリメント
                 table->num--;
@@ -715,7 +725,7 @@ bool m46e_pr_set_enable(m46e_pr_table_t* table, struct in_addr* addr, int cidr,
 
         m46e_list* iter;
         m46e_list_for_each(iter, &table->entry_list){
-            m46e_pr_entry_t* tmp = iter->data;
+            m46e_pr_entry_t* tmp = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             // アドレスとネットマスクが一致するエントリーを検索
             if ((addr->s_addr == tmp->v4addr.s_addr) && (cidr == tmp->v4cidr)) {
@@ -778,7 +788,7 @@ m46e_pr_entry_t* m46e_search_pr_table(m46e_pr_table_t* table, struct in_addr* ad
 
         m46e_list* iter;
         m46e_list_for_each(iter, &table->entry_list){
-            m46e_pr_entry_t* tmp = iter->data;
+            m46e_pr_entry_t* tmp = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             // アドレスとネットマスクが一致するエントリーを検索
             if ((addr->s_addr == tmp->v4addr.s_addr) && (cidr == tmp->v4cidr)) {
@@ -875,7 +885,7 @@ bool m46e_pr_plane_prefix(
 //!
 //! M46E-PR config情報構造体をM46E-PR Entry 構造体へ変換する。
 //! ※変換成功時に受け取ったm46e_pr_entry_tのアドレスは、
-//! ※free関数で解放すること。
+//! ※m46e_pr_free_entry関数で解放すること。
 //!
 //! @param [in]  handler    アプリケーションハンドラー
 //!        [in]  conf       M46E-PR config情報
@@ -896,7 +906,7 @@ m46e_pr_entry_t* m46e_pr_conf2entry(
         return NULL;
     }
 
-    entry = malloc(sizeof(m46e_pr_entry_t));
+    entry = m46e_pr_alloc_entry();
     if(entry == NULL){
         m46e_logging(LOG_WARNING, "fail to allocate M46E-PR data.\n");
         return NULL;
@@ -923,7 +933,7 @@ m46e_pr_entry_t* m46e_pr_conf2entry(
 
     if(!ret) {
         m46e_logging(LOG_WARNING, "fail to create M46E-PR plefix+PlaneID.\n");
-        free(entry);
+        m46e_pr_free_entry(entry);
         return NULL;
     }
 
@@ -970,7 +980,7 @@ m46e_pr_entry_t* m46e_pr_entry_search_stub(m46e_pr_table_t* table, struct in_add
 
         m46e_list* iter;
         m46e_list_for_each(iter, &table->entry_list){
-            m46e_pr_entry_t* tmp = iter->data;
+            m46e_pr_entry_t* tmp = m46e_list_entry(iter, m46e_pr_entry_t, list);
             struct in_addr network;
 
             // disableはスキップ
@@ -1037,7 +1047,7 @@ bool m46e_pr_prefix_check( m46e_pr_table_t* table, struct in6_addr* addr)
 
         m46e_list* iter;
         m46e_list_for_each(iter, &table->entry_list){
-            m46e_pr_entry_t* tmp = iter->data;
+            m46e_pr_entry_t* tmp = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             // M46E-PR prefix + Plane ID判定
             if (IS_EQUAL_M46E_PR_PREFIX(addr, &tmp->pr_prefix_planeid)) {
@@ -1076,7 +1086,7 @@ bool m46e_pr_prefix_check( m46e_pr_table_t* table, struct in6_addr* addr)
 //!
 //! M46E-PR Commandデータ構造体をM46E-PR Entry 構造体へ変換する。
 //! ※変換成功時に受け取ったm46e_pr_entry_tのアドレスは、
-//! ※free関数で解放すること。
+//! ※m46e_pr_free_entry関数で解放すること。
 //!
 //! @param [in]  handler    アプリケーションハンドラー
 //!        [in]  data       M46E-PR Commandデータ
@@ -1097,7 +1107,7 @@ m46e_pr_entry_t* m46e_pr_command2entry(
         return NULL;
     }
 
-    entry = malloc(sizeof(m46e_pr_entry_t));
+    entry = m46e_pr_alloc_entry();
     if(entry == NULL){
         m46e_logging(LOG_WARNING, "fail to allocate M46E-PR data.\n");
         return NULL;
@@ -1124,7 +1134,7 @@ m46e_pr_entry_t* m46e_pr_command2entry(
 
     if(!ret) {
         m46e_logging(LOG_WARNING, "fail to create M46E-PR plefix+PlaneID.\n");
-        free(entry);
+        m46e_pr_free_entry(entry);
         return NULL;
     }
 
@@ -1141,6 +1151,78 @@ m46e_pr_entry_t* m46e_pr_command2entry(
     return entry;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Entry用オブジェクトプール初期化関数
+//!
+//! M46E-PR Entry用のオブジェクトプールを生成する。
+//! (pthread_onceで一度だけ呼び出す)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void m46e_pr_entry_pool_init(void)
+{
+    pr_entry_pool = m46e_mempool_create(sizeof(m46e_pr_entry_t), PR_ENTRY_POOL_SLAB_NUM);
+    if(pr_entry_pool == NULL){
+        m46e_logging(LOG_WARNING, "fail to create M46E-PR entry pool.\n");
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Entry確保関数
+//!
+//! M46E-PR Entryをオブジェクトプールから確保する。
+//! 一括登録時などにエントリー毎のmalloc/freeが発生しないよう、
+//! エントリーはスラブ単位でまとめて確保したものを再利用する。
+//!
+//! @return m46e_pr_entry_tアドレス    確保成功
+//! @return NULL                        確保失敗
+///////////////////////////////////////////////////////////////////////////////
+static m46e_pr_entry_t* m46e_pr_alloc_entry(void)
+{
+    pthread_once(&pr_entry_pool_once, m46e_pr_entry_pool_init);
+
+    return m46e_mempool_alloc(pr_entry_pool);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Entry解放関数
+//!
+//! m46e_pr_conf2entry関数、m46e_pr_command2entry関数で確保した
+//! M46E-PR Entryをオブジェクトプールへ返却する。
+//! M46E-PR Tableに登録済みのエントリーはリストから外してから呼び出すこと。
+//!
+//! @param [in]  entry   解放するM46E-PR Entry
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_pr_free_entry(m46e_pr_entry_t* entry)
+{
+    m46e_mempool_free(pr_entry_pool, entry);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Entry数更新関数
+//!
+//! 統計情報のM46E-PR Tableエントリ数(OpenMetrics出力用)を更新する。
+//!
+//! @param [in]  handler  M46Eハンドラ
+//! @param [in]  table    M46E-PR Table
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void m46e_pr_update_entry_num(struct m46e_handler_t* handler, m46e_pr_table_t* table)
+{
+    if((handler->stat_info != NULL) && (table != NULL)){
+        handler->stat_info->pr_entry_num = table->num;
+    }
+
+    return;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief M46E-PR Config Entry 構造体変換関数(コマンド用)
 //!
@@ -1251,6 +1333,7 @@ bool m46e_pr_add_entry_pr_table(struct m46e_handler_t* handler, struct m46e_comm
 
             // ここでConsoleに要求コマンド失敗のエラーを返す。
             m46e_pr_print_error(req->pr_data.fd, M46E_PR_COMMAND_ENTRY_FOUND);
+            m46e_pr_free_entry(entry);
             return false;
         }
         // 形式変換OKなのでM46E-PR TableにM46E-PR Entryを追加
@@ -1264,10 +1347,13 @@ bool m46e_pr_add_entry_pr_table(struct m46e_handler_t* handler, struct m46e_comm
                  req->pr_data.v6cidr);
             // ここでConsoleに要求コマンド失敗のエラーを返す。
             m46e_pr_print_error(req->pr_data.fd, M46E_PR_COMMAND_EXEC_FAILURE);
+            m46e_pr_free_entry(entry);
 
             return false;
         }
         else {
+            m46e_pr_update_entry_num(handler, handler->pr_handler);
+
             // PRテーブルへの登録が成功した場合、活性化を伴う追加要求の場合は
             // 当該PR EntryのIPネットワーク経路を追加
             if(req->pr_data.enable == true) {
@@ -1332,6 +1418,8 @@ bool m46e_pr_del_entry_pr_table(struct m46e_handler_t* handler, struct m46e_comm
         return false;
     }
     else {
+        m46e_pr_update_entry_num(handler, handler->pr_handler);
+
         //  PRテーブルから削除が成功した場合、活性化/非活性化に関わらず
         //  当該PR EntryのIPネットワークアドレス経路を削除
         m46e_network_del_route(
@@ -1371,7 +1459,7 @@ bool m46e_pr_delall_entry_pr_table(struct m46e_handler_t* handler, struct m46e_c
     // M46E-PR Entry全削除
     while(!m46e_list_empty(&handler->pr_handler->entry_list)){
         m46e_list* node = handler->pr_handler->entry_list.next;
-        m46e_pr_entry_t* pr_entry = node->data;
+        m46e_pr_entry_t* pr_entry = m46e_list_entry(node, m46e_pr_entry_t, list);
         m46e_network_del_route(
             AF_INET,
             handler->conf->tunnel->ipv4.ifindex,
@@ -1379,14 +1467,14 @@ bool m46e_pr_delall_entry_pr_table(struct m46e_handler_t* handler, struct m46e_c
             pr_entry->v4cidr,
             NULL
         );
-        free(pr_entry);
         m46e_list_del(node);
-        free(node);
+        m46e_pr_free_entry(pr_entry);
         handler->pr_handler->num--;
     }
 
     //リストの初期化
     m46e_list_init(&handler->pr_handler->entry_list);
+    m46e_pr_update_entry_num(handler, handler->pr_handler);
 
     // 排他解除
     pthread_mutex_unlock(&handler->pr_handler->mutex);
@@ -1529,7 +1617,7 @@ void m46e_pr_show_entry_pr_table(m46e_pr_table_t* pr_handler, int fd, char *plan
 
     m46e_list* iter;
     m46e_list_for_each(iter, &pr_handler->entry_list){
-        m46e_pr_entry_t* pr_entry = iter->data;
+        m46e_pr_entry_t* pr_entry = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             if(pr_entry != NULL){
                 // enable/disable frag
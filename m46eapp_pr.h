@@ -5,6 +5,7 @@
 /* 修正履歴   : 2013.08.22 H.KoganemaruM46E-PR機能拡張                        */
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent オブジェクトプール追加                       */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2013-2016                */
 /******************************************************************************/
@@ -78,6 +79,7 @@ bool m46e_pr_prefix_check( m46e_pr_table_t* table, struct in6_addr* addr);
 bool m46e_pr_plane_prefix(struct in6_addr* inaddr, int cidr, char* plane_id, struct in6_addr* outaddr);
 m46e_pr_entry_t* m46e_pr_conf2entry(struct m46e_handler_t* handler, m46e_pr_config_entry_t* conf);
 m46e_pr_entry_t* m46e_pr_command2entry( struct m46e_handler_t* handler, struct m46e_pr_entry_command_data* data);
+void m46e_pr_free_entry(m46e_pr_entry_t* entry);
 m46e_pr_config_entry_t* m46e_pr_command2conf(struct m46e_handler_t* handler, struct m46e_pr_entry_command_data* data);
 
 bool m46eapp_pr_check_network_addr(struct in_addr *addr, int cidr);
@@ -3,6 +3,7 @@
 /* 機能概要   : M46E Prefix Resolution 構造体定義ヘッダファイル               */
 /* 修正履歴   : 2013.08.01 Y.Shibata   新規作成                               */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent オブジェクトプール追加                       */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2013-2016                */
 /******************************************************************************/
@@ -27,6 +28,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 typedef struct _m46e_pr_entry_t
 {
+    m46e_list               list;               ///< M46E-PR Tableのリスト要素(エントリーに埋め込む)
     bool                    enable;             ///< エントリーか有効(true)/無効(false)かを表すフラグ
     struct in_addr          v4addr;             ///< 送信先のIPv4ネットワークアドレス（ホスト部のアドレスは0）
     struct in_addr          v4mask;             ///< xxx.xxx.xxx.xxx形式のIPv4サブネットマスク
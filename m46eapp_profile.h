@@ -0,0 +1,94 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_profile.h                                             */
+/* 機能概要   : 転送処理ステージ毎のサイクル計測 ヘッダファイル               */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#ifndef __M46EAPP_PROFILE_H__
+#define __M46EAPP_PROFILE_H__
+
+#include <stdint.h>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// ステージ毎のサイクル計測はM46E_PROFILEを定義してビルドした場合のみ有効。
+// (未定義の場合、計測用のマクロは空となり転送処理に一切影響しない)
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//! 計測対象ステージ
+////////////////////////////////////////////////////////////////////////////////
+enum m46e_profile_stage
+{
+    M46E_PROFILE_STAGE_PARSE = 0,    ///< 受信パケット解析
+    M46E_PROFILE_STAGE_PR_LOOKUP,    ///< M46E-PRテーブル/プレフィックス検索
+    M46E_PROFILE_STAGE_HEADER,       ///< ヘッダ構築
+    M46E_PROFILE_STAGE_PMTU_LOOKUP,  ///< Path MTU検索
+    M46E_PROFILE_STAGE_FRAGMENT,     ///< フラグメント送信/Fragment Needed送信
+    M46E_PROFILE_STAGE_WRITE,        ///< パケット送信
+    M46E_PROFILE_STAGE_NUM           ///< ステージ数
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! ステージ毎の計測結果 構造体
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_profile_t
+{
+    uint64_t cycles[M46E_PROFILE_STAGE_NUM];  ///< 消費サイクル数の合計
+    uint64_t count[M46E_PROFILE_STAGE_NUM];   ///< 通過回数
+} __attribute__((aligned(64))) m46e_profile_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief サイクルカウンタ取得関数
+//!
+//! x86ではTSCを、それ以外ではCLOCK_MONOTONICのナノ秒を返す。
+//!
+//! @return カウンタ値
+///////////////////////////////////////////////////////////////////////////////
+static inline uint64_t m46e_profile_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ステージ計測関数
+//!
+//! 前回の計測点からの経過サイクルを指定ステージに加算し、計測点を更新する。
+//!
+//! @param [in,out] profile   計測結果
+//! @param [in,out] last      前回の計測点
+//! @param [in]     stage     ステージ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static inline void m46e_profile_mark(m46e_profile_t* profile, uint64_t* last, const int stage)
+{
+    uint64_t now = m46e_profile_cycles();
+
+    profile->cycles[stage] += now - *last;
+    profile->count[stage]++;
+    *last = now;
+}
+
+#ifdef M46E_PROFILE
+//! 計測点の宣言
+#define M46E_PROFILE_DECLARE(__last)               uint64_t __last
+//! 計測開始
+#define M46E_PROFILE_START(__last)                 ((__last) = m46e_profile_cycles())
+//! ステージ終了(__profileはm46e_profile_t*)
+#define M46E_PROFILE_MARK(__profile, __last, __stage) \
+    m46e_profile_mark((__profile), &(__last), (__stage))
+#else
+#define M46E_PROFILE_DECLARE(__last)
+#define M46E_PROFILE_START(__last)                 do{}while(0)
+#define M46E_PROFILE_MARK(__profile, __last, __stage) do{}while(0)
+#endif
+
+#endif // __M46EAPP_PROFILE_H__
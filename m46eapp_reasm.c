@@ -0,0 +1,531 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_reasm.c                                               */
+/* 機能概要   : IPv6フラグメント再構築クラス ソースファイル                   */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "m46eapp_reasm.h"
+#include "m46eapp_hashtable.h"
+#include "m46eapp_mempool.h"
+#include "m46eapp_log.h"
+#include "m46eapp_util.h"
+
+//! 再構築後のペイロードの最大長
+#define REASM_PAYLOAD_MAX     65535
+
+//! 1データグラムあたりの最大フラグメント数
+#define REASM_FRAG_MAX        64
+
+//! 再構築バッファの拡張単位
+#define REASM_BUF_UNIT        2048
+
+//! エントリ用オブジェクトプールのスラブあたりのエントリ数
+#define REASM_SLAB_NUM        64
+
+////////////////////////////////////////////////////////////////////////////////
+//! 再構築エントリのキー
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _reasm_key
+{
+    struct in6_addr src;    ///< 送信元アドレス
+    struct in6_addr dst;    ///< 送信先アドレス
+    uint32_t        ident;  ///< Identification
+} reasm_key;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 受信済みフラグメントの範囲
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _reasm_range
+{
+    uint16_t start;  ///< 先頭オフセット
+    uint16_t end;    ///< 終端オフセット(この位置を含まない)
+} reasm_range;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 再構築エントリ
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _reasm_entry
+{
+    reasm_key            key;       ///< キー
+    struct _reasm_entry* prev;      ///< 前のエントリ(生成順)
+    struct _reasm_entry* next;      ///< 次のエントリ(生成順)
+    time_t               expire;    ///< 破棄時刻(CLOCK_MONOTONIC秒)
+    uint8_t              nxt;       ///< フラグメント可能部の先頭ヘッダ種別
+    uint32_t             total_len; ///< 再構築後の長さ(最終フラグメント受信まで0)
+    uint32_t             recv_len;  ///< 受信済みの長さ
+    uint32_t             buf_size;  ///< 再構築バッファのサイズ
+    uint8_t*             buf;       ///< 再構築バッファ
+    int                  range_num; ///< 受信済みフラグメント数
+    reasm_range          range[REASM_FRAG_MAX]; ///< 受信済みフラグメントの範囲
+} reasm_entry;
+
+////////////////////////////////////////////////////////////////////////////////
+//! IPv6フラグメント再構築構造体
+//! (デカプセル化スレッドからのみ参照するため排他は行わない)
+////////////////////////////////////////////////////////////////////////////////
+struct _m46e_reasm_t
+{
+    uint32_t          entry_max;   ///< 同時に再構築するデータグラムの最大数
+    uint32_t          source_max;  ///< 送信元毎に同時に再構築するデータグラムの最大数
+    int               timeout;     ///< 再構築のタイムアウト時間(秒)
+    m46e_hashtable_t* table;       ///< 再構築エントリのテーブル(キー:reasm_key)
+    m46e_hashtable_t* source;      ///< 送信元毎のエントリ数(キー:送信元アドレス)
+    m46e_mempool_t*   pool;        ///< 再構築エントリのプール
+    reasm_entry*      head;        ///< 最も古いエントリ
+    reasm_entry*      tail;        ///< 最も新しいエントリ
+    uint8_t*          done_buf;    ///< 再構築を完了したバッファ(次回の呼出しで解放)
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+static reasm_entry* reasm_entry_create(m46e_reasm_t* reasm, const reasm_key* key, const time_t now);
+static void reasm_entry_release(m46e_reasm_t* reasm, reasm_entry* entry, const bool keep_buf);
+static bool reasm_entry_add(reasm_entry* entry, const uint16_t offset, const bool more, const uint8_t* data, const size_t data_len);
+static time_t reasm_now(void);
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6フラグメント再構築 生成関数
+//!
+//! IPv6フラグメント再構築用のテーブルを生成する。<br/>
+//! 使用するメモリは最大でentry_max×65535byteに制限される。
+//!
+//! @param [in]     entry_max   同時に再構築するデータグラムの最大数
+//! @param [in]     source_max  送信元毎に同時に再構築するデータグラムの最大数
+//! @param [in]     timeout     再構築のタイムアウト時間(秒)
+//!
+//! @return 生成したIPv6フラグメント再構築へのポインタ
+///////////////////////////////////////////////////////////////////////////////
+m46e_reasm_t* m46e_reasm_create(const uint32_t entry_max, const uint32_t source_max, const int timeout)
+{
+    // ローカル変数宣言
+    m46e_reasm_t* reasm;
+
+    // 引数チェック
+    if((entry_max == 0) || (source_max == 0) || (timeout <= 0)){
+        return NULL;
+    }
+
+    reasm = (m46e_reasm_t*)malloc(sizeof(m46e_reasm_t));
+    if(reasm == NULL){
+        return NULL;
+    }
+
+    reasm->entry_max  = entry_max;
+    reasm->source_max = source_max;
+    reasm->timeout    = timeout;
+    reasm->head       = NULL;
+    reasm->tail       = NULL;
+    reasm->done_buf   = NULL;
+    reasm->table      = m46e_hashtable_create(entry_max);
+    reasm->source     = m46e_hashtable_create(entry_max);
+    reasm->pool       = m46e_mempool_create(sizeof(reasm_entry), REASM_SLAB_NUM);
+
+    if((reasm->table == NULL) || (reasm->source == NULL) || (reasm->pool == NULL)){
+        m46e_reasm_destroy(reasm);
+        return NULL;
+    }
+
+    return reasm;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6フラグメント再構築 解放関数
+//!
+//! 再構築中の全エントリとテーブルを解放する。
+//!
+//! @param [in]  reasm  解放するIPv6フラグメント再構築
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_reasm_destroy(m46e_reasm_t* reasm)
+{
+    // 引数チェック
+    if(reasm == NULL){
+        return;
+    }
+
+    while(reasm->head != NULL){
+        reasm_entry_release(reasm, reasm->head, false);
+    }
+
+    free(reasm->done_buf);
+    m46e_hashtable_delete(reasm->table);
+    m46e_hashtable_delete(reasm->source);
+    m46e_mempool_destroy(reasm->pool);
+    free(reasm);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief フラグメント入力関数
+//!
+//! 受信したフラグメントを送信元/送信先/Identification毎のエントリに格納し、
+//! 全てのフラグメントが揃った場合は再構築したデータを返す。<br/>
+//! 重複したフラグメント(RFC5722)、8byte境界でない後続ありフラグメント、
+//! 65535byteを超えるフラグメントを受信した場合はデータグラムごと破棄する。<br/>
+//! 再構築したデータは次回の本関数の呼出しまで有効。<br/>
+//! タイムアウトしたエントリは呼出元でm46e_reasm_expireにより破棄すること。
+//!
+//! @param [in]     reasm       IPv6フラグメント再構築
+//! @param [in]     ip6         受信したパケットのIPv6ヘッダ
+//! @param [in]     frag        受信したパケットのFragmentヘッダ
+//! @param [in]     data        Fragmentヘッダに続くデータ
+//! @param [in]     data_len    Fragmentヘッダに続くデータの長さ
+//! @param [out]    nxt         再構築したデータの先頭ヘッダ種別
+//! @param [out]    packet      再構築したデータ
+//! @param [out]    packet_len  再構築したデータの長さ
+//!
+//! @retval M46E_REASM_COMPLETE  再構築完了(nxt、packet、packet_lenを設定)
+//! @retval M46E_REASM_PENDING   後続のフラグメント待ち
+//! @retval M46E_REASM_ERROR     フラグメントを破棄
+///////////////////////////////////////////////////////////////////////////////
+int m46e_reasm_input(
+    m46e_reasm_t*           reasm,
+    const struct ip6_hdr*   ip6,
+    const struct ip6_frag*  frag,
+    const uint8_t*          data,
+    const size_t            data_len,
+    uint8_t*                nxt,
+    uint8_t**               packet,
+    size_t*                 packet_len
+)
+{
+    // ローカル変数宣言
+    reasm_key     key;
+    reasm_entry** entry_p;
+    reasm_entry*  entry;
+    uint16_t      offset;
+    bool          more;
+    time_t        now;
+
+    // 引数チェック
+    if((reasm == NULL) || (ip6 == NULL) || (frag == NULL) || (data == NULL)){
+        return M46E_REASM_ERROR;
+    }
+
+    // 前回再構築したデータを解放
+    free(reasm->done_buf);
+    reasm->done_buf = NULL;
+
+    offset = ntohs(frag->ip6f_offlg & IP6F_OFF_MASK);
+    more   = ((frag->ip6f_offlg & IP6F_MORE_FRAG) != 0);
+
+    if((offset == 0) && !more){
+        // 分割されていないフラグメント(RFC6946)はそのまま返す
+        *nxt        = frag->ip6f_nxt;
+        *packet     = (uint8_t*)data;
+        *packet_len = data_len;
+        return M46E_REASM_COMPLETE;
+    }
+
+    now = reasm_now();
+
+    memset(&key, 0, sizeof(key));
+    key.src   = ip6->ip6_src;
+    key.dst   = ip6->ip6_dst;
+    key.ident = frag->ip6f_ident;
+
+    entry_p = m46e_hashtable_get(reasm->table, &key, sizeof(key));
+    if(entry_p != NULL){
+        entry = *entry_p;
+    }
+    else{
+        entry = reasm_entry_create(reasm, &key, now);
+        if(entry == NULL){
+            return M46E_REASM_ERROR;
+        }
+    }
+
+    if(!reasm_entry_add(entry, offset, more, data, data_len)){
+        DEBUG_LOG("drop invalid fragment (offset=%d, len=%zu, more=%d)\n", offset, data_len, more);
+        reasm_entry_release(reasm, entry, false);
+        return M46E_REASM_ERROR;
+    }
+
+    if(offset == 0){
+        entry->nxt = frag->ip6f_nxt;
+    }
+
+    if((entry->total_len == 0) || (entry->recv_len < entry->total_len)){
+        return M46E_REASM_PENDING;
+    }
+
+    // 全フラグメント受信済み
+    *nxt            = entry->nxt;
+    *packet         = entry->buf;
+    *packet_len     = entry->total_len;
+    reasm->done_buf = entry->buf;
+    reasm_entry_release(reasm, entry, true);
+
+    return M46E_REASM_COMPLETE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイムアウトエントリ破棄関数
+//!
+//! 生成から再構築のタイムアウト時間を経過したエントリを破棄する。
+//!
+//! @param [in]  reasm  IPv6フラグメント再構築
+//!
+//! @return 破棄したエントリ数
+///////////////////////////////////////////////////////////////////////////////
+uint32_t m46e_reasm_expire(m46e_reasm_t* reasm)
+{
+    // ローカル変数宣言
+    uint32_t count = 0;
+    time_t   now;
+
+    // 引数チェック
+    if(reasm == NULL){
+        return 0;
+    }
+
+    now = reasm_now();
+
+    // エントリは生成順に並んでいるので、先頭から期限切れのものを破棄する
+    while((reasm->head != NULL) && (reasm->head->expire <= now)){
+        reasm_entry_release(reasm, reasm->head, false);
+        count++;
+    }
+
+    if(count > 0){
+        DEBUG_LOG("expire %u reassembly entries\n", count);
+    }
+
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 再構築中エントリ数取得関数
+//!
+//! @param [in]  reasm  IPv6フラグメント再構築
+//!
+//! @return 再構築中のエントリ数
+///////////////////////////////////////////////////////////////////////////////
+uint32_t m46e_reasm_count(m46e_reasm_t* reasm)
+{
+    // 引数チェック
+    if(reasm == NULL){
+        return 0;
+    }
+
+    return m46e_hashtable_count(reasm->table);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 再構築エントリ生成関数
+//!
+//! エントリを生成してテーブルに登録する。<br/>
+//! 全体または送信元毎のエントリ数が上限に達している場合は生成しない。
+//!
+//! @param [in]  reasm  IPv6フラグメント再構築
+//! @param [in]  key    キー
+//! @param [in]  now    現在時刻(CLOCK_MONOTONIC秒)
+//!
+//! @return 生成したエントリ。上限超過時、生成失敗時はNULL。
+///////////////////////////////////////////////////////////////////////////////
+static reasm_entry* reasm_entry_create(m46e_reasm_t* reasm, const reasm_key* key, const time_t now)
+{
+    // ローカル変数宣言
+    reasm_entry* entry;
+    uint32_t*    src_num;
+    uint32_t     one = 1;
+
+    if(m46e_hashtable_count(reasm->table) >= reasm->entry_max){
+        DEBUG_LOG("reassembly table is full\n");
+        return NULL;
+    }
+
+    src_num = m46e_hashtable_get(reasm->source, &key->src, sizeof(key->src));
+    if((src_num != NULL) && (*src_num >= reasm->source_max)){
+        DEBUG_LOG("reassembly entries per source is full\n");
+        return NULL;
+    }
+
+    entry = m46e_mempool_alloc(reasm->pool);
+    if(entry == NULL){
+        return NULL;
+    }
+
+    if(!m46e_hashtable_add(reasm->table, key, sizeof(*key), &entry, sizeof(entry), false, NULL, NULL)){
+        m46e_mempool_free(reasm->pool, entry);
+        return NULL;
+    }
+
+    if(src_num != NULL){
+        (*src_num)++;
+    }
+    else if(!m46e_hashtable_add(reasm->source, &key->src, sizeof(key->src), &one, sizeof(one), false, NULL, NULL)){
+        m46e_hashtable_remove(reasm->table, key, sizeof(*key), NULL);
+        m46e_mempool_free(reasm->pool, entry);
+        return NULL;
+    }
+
+    entry->key       = *key;
+    entry->expire    = now + reasm->timeout;
+    entry->nxt       = IPPROTO_NONE;
+    entry->total_len = 0;
+    entry->recv_len  = 0;
+    entry->buf_size  = 0;
+    entry->buf       = NULL;
+    entry->range_num = 0;
+
+    // 生成順リストの末尾に追加
+    entry->prev = reasm->tail;
+    entry->next = NULL;
+    if(reasm->tail != NULL){
+        reasm->tail->next = entry;
+    }
+    else{
+        reasm->head = entry;
+    }
+    reasm->tail = entry;
+
+    return entry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 再構築エントリ解放関数
+//!
+//! エントリをテーブルから削除して解放する。
+//!
+//! @param [in]  reasm     IPv6フラグメント再構築
+//! @param [in]  entry     解放するエントリ
+//! @param [in]  keep_buf  再構築バッファを解放しない場合はtrue
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void reasm_entry_release(m46e_reasm_t* reasm, reasm_entry* entry, const bool keep_buf)
+{
+    // ローカル変数宣言
+    uint32_t* src_num;
+
+    m46e_hashtable_remove(reasm->table, &entry->key, sizeof(entry->key), NULL);
+
+    src_num = m46e_hashtable_get(reasm->source, &entry->key.src, sizeof(entry->key.src));
+    if((src_num != NULL) && (--(*src_num) == 0)){
+        m46e_hashtable_remove(reasm->source, &entry->key.src, sizeof(entry->key.src), NULL);
+    }
+
+    // 生成順リストから削除
+    if(entry->prev != NULL){
+        entry->prev->next = entry->next;
+    }
+    else{
+        reasm->head = entry->next;
+    }
+    if(entry->next != NULL){
+        entry->next->prev = entry->prev;
+    }
+    else{
+        reasm->tail = entry->prev;
+    }
+
+    if(!keep_buf){
+        free(entry->buf);
+    }
+    m46e_mempool_free(reasm->pool, entry);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief フラグメント格納関数
+//!
+//! フラグメントのデータを再構築バッファの該当位置にコピーする。
+//!
+//! @param [in,out] entry     再構築エントリ
+//! @param [in]     offset    フラグメントのオフセット
+//! @param [in]     more      後続のフラグメントがある場合はtrue
+//! @param [in]     data      フラグメントのデータ
+//! @param [in]     data_len  フラグメントのデータの長さ
+//!
+//! @retval true   格納成功
+//! @retval false  不正なフラグメント(データグラムごと破棄すること)
+///////////////////////////////////////////////////////////////////////////////
+static bool reasm_entry_add(
+    reasm_entry*    entry,
+    const uint16_t  offset,
+    const bool      more,
+    const uint8_t*  data,
+    const size_t    data_len
+)
+{
+    // ローカル変数宣言
+    uint32_t end = offset + data_len;
+
+    // 長さのチェック
+    if((data_len == 0) || (end > REASM_PAYLOAD_MAX)){
+        return false;
+    }
+    if(more && ((data_len & 0x7) != 0)){
+        return false;
+    }
+
+    // 最終フラグメントとの整合性チェック
+    if(!more){
+        if((entry->total_len != 0) && (entry->total_len != end)){
+            return false;
+        }
+        entry->total_len = end;
+    }
+    if((entry->total_len != 0) && (end > entry->total_len)){
+        return false;
+    }
+
+    // 受信済みフラグメントとの重複チェック
+    if(entry->range_num >= REASM_FRAG_MAX){
+        return false;
+    }
+    for(int i = 0; i < entry->range_num; i++){
+        if((offset < entry->range[i].end) && (entry->range[i].start < end)){
+            return false;
+        }
+    }
+
+    // 再構築バッファの拡張
+    if(entry->buf_size < end){
+        uint32_t size = (entry->total_len != 0) ? entry->total_len :
+                        min((end + REASM_BUF_UNIT - 1) & ~(REASM_BUF_UNIT - 1), REASM_PAYLOAD_MAX);
+        uint8_t* buf  = realloc(entry->buf, size);
+        if(buf == NULL){
+            m46e_logging(LOG_WARNING, "fail to allocate reassembly buffer\n");
+            return false;
+        }
+        entry->buf      = buf;
+        entry->buf_size = size;
+    }
+
+    memcpy(entry->buf + offset, data, data_len);
+    entry->range[entry->range_num].start = offset;
+    entry->range[entry->range_num].end   = end;
+    entry->range_num++;
+    entry->recv_len += data_len;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 現在時刻取得関数
+//!
+//! @return 現在時刻(CLOCK_MONOTONIC秒)
+///////////////////////////////////////////////////////////////////////////////
+static time_t reasm_now(void)
+{
+    // ローカル変数宣言
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec;
+}
@@ -0,0 +1,37 @@
+/******************************************************************************/
+/* ファイル名 : m46eapp_reasm.h                                               */
+/* 機能概要   : IPv6フラグメント再構築クラス ヘッダファイル                   */
+/* 修正履歴   : 2026.10.18 agent 新規作成                                     */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2026                     */
+/******************************************************************************/
+#ifndef __M46EAPP_REASM_H__
+#define __M46EAPP_REASM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/ip6.h>
+
+//! IPv6フラグメント再構築構造体
+typedef struct _m46e_reasm_t m46e_reasm_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! フラグメント入力結果
+////////////////////////////////////////////////////////////////////////////////
+enum m46e_reasm_result
+{
+    M46E_REASM_COMPLETE = 0,  ///< 再構築完了
+    M46E_REASM_PENDING,       ///< 後続のフラグメント待ち
+    M46E_REASM_ERROR,         ///< 不正なフラグメント、または上限超過により破棄
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+m46e_reasm_t* m46e_reasm_create(const uint32_t entry_max, const uint32_t source_max, const int timeout);
+void     m46e_reasm_destroy(m46e_reasm_t* reasm);
+int      m46e_reasm_input(m46e_reasm_t* reasm, const struct ip6_hdr* ip6, const struct ip6_frag* frag, const uint8_t* data, const size_t data_len, uint8_t* nxt, uint8_t** packet, size_t* packet_len);
+uint32_t m46e_reasm_expire(m46e_reasm_t* reasm);
+uint32_t m46e_reasm_count(m46e_reasm_t* reasm);
+
+#endif // __M46EAPP_REASM_H__
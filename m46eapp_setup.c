@@ -6,6 +6,7 @@
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2013.11.15 H.Koganemaru mkstempワーニング対処                 */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent オブジェクトプール追加                       */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -440,7 +441,7 @@ int m46e_start_stub_network(struct m46e_handler_t* handler)
         m46e_list* iter;
         m46e_list_for_each(iter, &handler->pr_handler->entry_list){
             m46e_pr_entry_t* pr_entry;
-            pr_entry = iter->data;
+            pr_entry = m46e_list_entry(iter, m46e_pr_entry_t, list);
 
             flag = false;
             m46e_list* iter_device;
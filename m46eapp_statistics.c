@@ -6,56 +6,226 @@
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2013.11.17 H.Koganemaru 統計情報出力イメージ修正              */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent Packet Too Big重複抑止追加                   */
+/*              2026.10.18 agent Packet Too Big妥当性検証追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
+/*              2026.10.18 agent 統計情報のスレッド毎カウンタ化               */
+/*              2026.10.18 agent 統計情報のバイト数/レート追加                */
+/*              2026.10.18 agent 遅延ヒストグラム追加                         */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent 統計情報領域のseqlock化                      */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
+/*              2026.10.18 agent Fragment Needed送信の流量制限                */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
-#include <sys/shm.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <syslog.h>
 #include <stdarg.h>
 #include <time.h>
 #include <errno.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <sched.h>
+#include <poll.h>
 
 #include "m46eapp_statistics.h"
 #include "m46eapp_log.h"
+#include "m46eapp_util.h"
+#include "m46eapp_command_data.h"
+
+//! 自スレッドのカウンタ種別(未設定のスレッドはその他とする)
+__thread int m46e_statistics_worker = M46E_STATISTICS_WORKER_OTHER;
+
+//! インライン展開されなかった場合のカウンタ領域書き込み開始/終了関数の実体
+extern inline void m46e_statistics_write_begin(m46e_statistics_t* statistics);
+extern inline void m46e_statistics_write_end(m46e_statistics_t* statistics);
+
+//! 統計情報領域の名前のプレフィックス(/dev/shm配下に作成される)
+#define STATISTICS_SHM_PREFIX  "/m46e_stat_"
+//! 統計情報領域の名前の最大長
+#define STATISTICS_SHM_NAME_LEN 256
+//! スナップショット取得の最大リトライ回数
+#define STATISTICS_SNAPSHOT_RETRY 100
+//! スナップショット取得でsched_yieldにより待ち合わせるリトライ回数(以降はスリープする)
+#define STATISTICS_SNAPSHOT_YIELD 8
+//! スナップショット取得のリトライ時のスリープ時間(ナノ秒)
+#define STATISTICS_SNAPSHOT_SLEEP_NSEC 100000
+
+//! 差分通知の同時接続数の上限
+#define STATISTICS_WATCH_MAX 16
+//! 差分通知(表形式)でヘッダを再表示する行数
+#define STATISTICS_WATCH_HEADER_INTERVAL 20
+
+//! 差分通知スレッドの引数
+typedef struct _statistics_watch_arg
+{
+    m46e_statistics_t* statistics;  ///< 統計情報用領域のポインタ
+    int                fd;          ///< 通知先ソケット
+    int                interval;    ///< 通知間隔(秒)
+    bool               json;        ///< JSON形式で通知するかどうか
+    pthread_t          tid;         ///< 差分通知スレッドのID
+    bool               done;        ///< スレッドが終了したかどうか
+} statistics_watch_arg;
+
+//! 起動中の差分通知スレッドの一覧(終了したスレッドは次の起動時か停止時にjoinする)
+static statistics_watch_arg* statistics_watch_list[STATISTICS_WATCH_MAX];
+//! 差分通知スレッド一覧の排他用mutex
+static pthread_mutex_t statistics_watch_mutex = PTHREAD_MUTEX_INITIALIZER;
+//! 差分通知を停止済みかどうか(停止後は新たに起動しない)
+static bool statistics_watch_stopped = false;
+
+//! 作成した統計情報領域の名前(解放時に削除する)
+static char statistics_shm_name[STATISTICS_SHM_NAME_LEN];
+
+//! カウンタ名テーブルのエントリ定義
+#define STATISTICS_NAME(__field) { #__field, offsetof(m46e_statistics_counter_t, __field) }
+
+////////////////////////////////////////////////////////////////////////////////
+//! カウンタ名テーブル
+//! (m46e_statistics_counter_tのメンバを追加した場合は本テーブルにも追加すること)
+////////////////////////////////////////////////////////////////////////////////
+static const struct
+{
+    const char* name;    ///< カウンタ名
+    size_t      offset;  ///< カウンタ領域先頭からのオフセット
+} statistics_name_table[] = {
+    STATISTICS_NAME(icmp_pkt_toobig_recv_count),
+    STATISTICS_NAME(icmp_pkt_toobig_suppress_count),
+    STATISTICS_NAME(icmp_pkt_toobig_invalid_count),
+    STATISTICS_NAME(icmp_fragneeded_send_count),
+    STATISTICS_NAME(icmp_fragneeded_send_success_count),
+    STATISTICS_NAME(icmp_fragneeded_send_err_count),
+    STATISTICS_NAME(icmp_fragneeded_suppress_count),
+    STATISTICS_NAME(pmtu_probe_send_count),
+    STATISTICS_NAME(pmtu_probe_restore_count),
+    STATISTICS_NAME(tunnel_v4_recieve_count),
+    STATISTICS_NAME(tunnel_v4_recieve_bytes),
+    STATISTICS_NAME(tunnel_v4_recv_unicast_count),
+    STATISTICS_NAME(tunnel_v4_recv_unicast_bytes),
+    STATISTICS_NAME(tunnel_v4_recv_multicast_count),
+    STATISTICS_NAME(tunnel_v4_recv_multicast_bytes),
+    STATISTICS_NAME(tunnel_v4_send_count),
+    STATISTICS_NAME(tunnel_v4_send_bytes),
+    STATISTICS_NAME(tunnel_v4_send_v6_success_count),
+    STATISTICS_NAME(tunnel_v4_send_v6_success_bytes),
+    STATISTICS_NAME(tunnel_v4_send_v6_err_count),
+    STATISTICS_NAME(tunnel_v4_send_fragneed_count),
+    STATISTICS_NAME(tunnel_v4_send_fragment_success_count),
+    STATISTICS_NAME(tunnel_v4_send_fragment_success_bytes),
+    STATISTICS_NAME(tunnel_v4_send_fragment_err_count),
+    STATISTICS_NAME(tunnel_v4_err_broadcast_count),
+    STATISTICS_NAME(tunnel_v4_err_other_proto_count),
+    STATISTICS_NAME(tunnel_v4_err_linklocal_multi_count),
+    STATISTICS_NAME(tunnel_v4_err_as_not_support_proto_count),
+    STATISTICS_NAME(tunnel_v4_err_as_fragment_count),
+    STATISTICS_NAME(tunnel_v4_err_pr_search_failure_count),
+    STATISTICS_NAME(tunnel_v4_err_pr_multi_count),
+    STATISTICS_NAME(tunnel_v6_recieve_count),
+    STATISTICS_NAME(tunnel_v6_recieve_bytes),
+    STATISTICS_NAME(tunnel_v6_recv_unicast_count),
+    STATISTICS_NAME(tunnel_v6_recv_unicast_bytes),
+    STATISTICS_NAME(tunnel_v6_recv_multicast_count),
+    STATISTICS_NAME(tunnel_v6_recv_multicast_bytes),
+    STATISTICS_NAME(tunnel_v6_send_count),
+    STATISTICS_NAME(tunnel_v6_send_bytes),
+    STATISTICS_NAME(tunnel_v6_send_v4_success_count),
+    STATISTICS_NAME(tunnel_v6_send_v4_success_bytes),
+    STATISTICS_NAME(tunnel_v6_send_v4_err_count),
+    STATISTICS_NAME(tunnel_v6_err_broadcast_count),
+    STATISTICS_NAME(tunnel_v6_err_ttl_count),
+    STATISTICS_NAME(tunnel_v6_err_other_proto_count),
+    STATISTICS_NAME(tunnel_v6_err_linklocal_multi_count),
+    STATISTICS_NAME(tunnel_v6_err_nxthdr_count),
+    STATISTICS_NAME(tunnel_v6_reasm_fragment_count),
+    STATISTICS_NAME(tunnel_v6_reasm_success_count),
+    STATISTICS_NAME(tunnel_v6_reasm_timeout_count),
+    STATISTICS_NAME(tunnel_v6_err_reasm_count),
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+static void statistics_init_header(m46e_statistics_header_t* header);
+static bool statistics_get_rate_counter(m46e_statistics_t* statistics, uint64_t* pkts, uint64_t* bytes);
+static void statistics_snapshot_backoff(const int retry);
+static void statistics_printf_rate(m46e_statistics_t* statistics, int fd);
+static void statistics_printf_latency(m46e_statistics_t* statistics, int fd);
+static void* statistics_watch_thread(void* arg);
+static void statistics_watch_cleanup(void* arg);
+static bool statistics_watch_wait(statistics_watch_arg* watch, const struct timespec* deadline);
+static int statistics_watch_format(statistics_watch_arg* watch, m46e_statistics_counter_t* delta, const double elapsed, const int row, char* buf, const size_t size);
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 統計情報領域作成関数
 //!
-//! 共有メモリに統計情報用領域を確保する。
+//! 共有メモリ(/dev/shm/m46e_stat_<plane_name>)に統計情報用領域を確保し、
+//! 外部の収集プロセスが参照するヘッダを初期化する。
 //!
-//! @param [in] key_path 共有メモリ作成のキー。
-//!             設定ファイルの絶対パス名を使用する。
+//! @param [in] plane_name plane識別名。統計情報領域の名前に使用する。
 //!
 //! @return 作成した統計情報領域のポインタ
 ///////////////////////////////////////////////////////////////////////////////
-m46e_statistics_t*  m46e_initial_statistics(const char* key_path)
+m46e_statistics_t*  m46e_initial_statistics(const char* plane_name)
 {
-    int shm_id = 0;
+    // ローカル変数宣言
+    m46e_statistics_t* statistics_info;
+    int                fd;
+
+    // 引数チェック
+    if(plane_name == NULL){
+        return NULL;
+    }
+
+    // plane識別名の'/'は名前に使用できないので置き換える
+    snprintf(statistics_shm_name, sizeof(statistics_shm_name), "%s%s", STATISTICS_SHM_PREFIX, plane_name);
+    for(char* p = statistics_shm_name + 1; *p != '\0'; p++){
+        if(*p == '/'){
+            *p = '_';
+        }
+    }
 
     // 統計情報が作成されていない場合に、新規に共有メモリに作成する
-    shm_id = shmget(ftok(key_path, 'a'), sizeof(m46e_statistics_t), IPC_CREAT);
-    if (shm_id == -1) {
+    fd = shm_open(statistics_shm_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if(fd == -1){
         m46e_logging(LOG_ERR, "shared memory allocation faulure for statistics : %s\n", strerror(errno));
         return NULL;
     }
 
-    m46e_statistics_t* statistics_info = (m46e_statistics_t*)shmat(shm_id, NULL, 0);
-    if (statistics_info == (void *)-1) {
+    if(ftruncate(fd, sizeof(m46e_statistics_t)) == -1){
+        m46e_logging(LOG_ERR, "shared memory allocation faulure for statistics : %s\n", strerror(errno));
+        close(fd);
+        shm_unlink(statistics_shm_name);
+        return NULL;
+    }
+
+    statistics_info = (m46e_statistics_t*)mmap(NULL, sizeof(m46e_statistics_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(statistics_info == MAP_FAILED){
         m46e_logging(LOG_ERR, "shared memory attach failure for statistics : %s\n", strerror(errno));
+        shm_unlink(statistics_shm_name);
         return NULL;
     }
 
     memset(statistics_info, 0, sizeof(m46e_statistics_t));
 
-    statistics_info->shm_id = shm_id;
+    // ヘッダは全て書き終えてから識別子を設定する
+    statistics_init_header(&statistics_info->header);
 
-    m46e_logging(LOG_INFO, "shared memory ID=%d \n", shm_id);
+    m46e_logging(LOG_INFO, "shared memory name=%s \n", statistics_shm_name);
 
     return statistics_info;
 }
@@ -74,12 +244,12 @@ void  m46e_finish_statistics(m46e_statistics_t* statistics_info)
     int ret;
 
     // 共有メモリ破棄
-    ret = shmctl(statistics_info->shm_id, IPC_RMID, NULL);
+    ret = shm_unlink(statistics_shm_name);
     if (ret == -1) {
         m46e_logging(LOG_ERR, "fail to destruct shared memory : %s\n", strerror(errno));
     }
 
-    ret = shmdt(statistics_info);
+    ret = munmap(statistics_info, sizeof(m46e_statistics_t));
     if (ret == -1) {
         m46e_logging(LOG_ERR, "fail to detach shared memory : %s\n", strerror(errno));
     }
@@ -87,16 +257,460 @@ void  m46e_finish_statistics(m46e_statistics_t* statistics_info)
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報領域ヘッダ初期化関数
+//!
+//! 領域のレイアウトとカウンタ名テーブルを設定する。
+//!
+//! @param [out] header 統計情報領域ヘッダ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void statistics_init_header(m46e_statistics_header_t* header)
+{
+    // ローカル変数宣言
+    int num = sizeof(statistics_name_table) / sizeof(statistics_name_table[0]);
+
+    if(num != M46E_STATISTICS_COUNTER_NUM){
+        m46e_logging(LOG_WARNING, "statistics name table mismatch (%d/%d)\n", num, (int)M46E_STATISTICS_COUNTER_NUM);
+        num = min(num, M46E_STATISTICS_COUNTER_NUM);
+    }
+
+    header->version        = M46E_STATISTICS_VERSION;
+    header->header_size    = sizeof(m46e_statistics_header_t);
+    header->total_size     = sizeof(m46e_statistics_t);
+    header->worker_num     = M46E_STATISTICS_WORKER_NUM;
+    header->counter_num    = num;
+    header->counter_offset = offsetof(m46e_statistics_t, worker);
+    header->counter_stride = sizeof(m46e_statistics_counter_t);
+    header->seq_offset     = offsetof(m46e_statistics_t, seq);
+    header->seq_stride     = sizeof(m46e_statistics_seq_t);
+
+    for(int i = 0; i < num; i++){
+        strncpy(header->name[i].name, statistics_name_table[i].name, M46E_STATISTICS_NAME_LEN - 1);
+        header->name[i].offset = statistics_name_table[i].offset;
+    }
+
+    __atomic_store_n(&header->magic, M46E_STATISTICS_MAGIC, __ATOMIC_RELEASE);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報カウンタ種別設定関数
+//!
+//! 呼出元スレッドが更新するカウンタ領域を設定する。
+//! 各パケット処理スレッドの開始時に呼び出すこと。
+//!
+//! @param [in] worker カウンタ種別(M46E_STATISTICS_WORKER_xxx)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_statistics_set_worker(const int worker)
+{
+    if((worker < 0) || (worker >= M46E_STATISTICS_WORKER_NUM)){
+        m46e_logging(LOG_WARNING, "invalid statistics worker = %d\n", worker);
+        return;
+    }
+
+    m46e_statistics_worker = worker;
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報集計関数
+//!
+//! スレッド種別毎のカウンタを合計する。
+//!
+//! @param [in]  statistics 統計情報用領域のポインタ
+//! @param [out] total      集計結果格納先
+//!
+//! @retval true   集計成功
+//! @retval false  整合の取れたスナップショットを取得できなかった(集計結果は不定)
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_statistics_sum(m46e_statistics_t* statistics, m46e_statistics_counter_t* total)
+{
+    uint64_t*                 dst = (uint64_t*)total;
+    m46e_statistics_counter_t counter;
+    const uint64_t*           src = (const uint64_t*)&counter;
+
+    memset(total, 0, sizeof(m46e_statistics_counter_t));
+
+    for(int i = 0; i < M46E_STATISTICS_WORKER_NUM; i++){
+        if(!m46e_statistics_snapshot(statistics, i, &counter)){
+            return false;
+        }
+        for(int j = 0; j < M46E_STATISTICS_COUNTER_NUM; j++){
+            dst[j] += src[j];
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief カウンタ領域スナップショット取得関数
+//!
+//! 指定したスレッド種別のカウンタ領域を世代番号で整合を取って複写する。
+//! (書き込み中の場合は待ち合わせてから読み直す)
+//!
+//! @param [in]  statistics 統計情報用領域のポインタ
+//! @param [in]  worker     スレッド種別(M46E_STATISTICS_WORKER_xxx)
+//! @param [out] counter    複写先
+//!
+//! @retval true   取得成功
+//! @retval false  リトライ回数内に整合の取れた複写ができなかった(複写先は不定)
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_statistics_snapshot(m46e_statistics_t* statistics, const int worker, m46e_statistics_counter_t* counter)
+{
+    // ローカル変数宣言
+    m46e_statistics_seq_t* gen = &statistics->seq[worker];
+    uint64_t               before;
+    uint64_t               after;
+
+    // 書き込みスレッドが停止した場合に備えてリトライ回数は制限する
+    for(int retry = 0; retry < STATISTICS_SNAPSHOT_RETRY; retry++){
+        if(retry > 0){
+            statistics_snapshot_backoff(retry);
+        }
+        before = __atomic_load_n(&gen->seq, __ATOMIC_ACQUIRE);
+        if(before & 1){
+            continue;
+        }
+        memcpy(counter, &statistics->worker[worker], sizeof(m46e_statistics_counter_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&gen->seq, __ATOMIC_RELAXED);
+        if(before == after){
+            return true;
+        }
+    }
+
+    m46e_logging(LOG_WARNING, "fail to get statistics snapshot (worker=%d)\n", worker);
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief スナップショット取得リトライ待ち合わせ関数
+//!
+//! 書き込み中のカウンタ領域を読み直す前に待ち合わせる。<br/>
+//! 最初の数回はCPUを譲るだけとし、以降は短時間スリープする。
+//!
+//! @param [in]  retry  リトライ回数(1～)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void statistics_snapshot_backoff(const int retry)
+{
+    // ローカル変数宣言
+    struct timespec wait = { 0, STATISTICS_SNAPSHOT_SLEEP_NSEC };
+
+    if(retry < STATISTICS_SNAPSHOT_YIELD){
+        sched_yield();
+    }
+    else{
+        nanosleep(&wait, NULL);
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 転送レート算出スレッド
+//!
+//! 1秒毎に統計情報のスナップショットを取得し、前回からの差分で
+//! 転送レート(pps/bps)を算出してリングに格納する。<br/>
+//! 算出結果は共有メモリ上に格納するので、バックボーン側でのみ起動すること。
+//!
+//! @param [in] arg 統計情報用領域のポインタ
+//!
+//! @return NULL固定
+///////////////////////////////////////////////////////////////////////////////
+void* m46e_statistics_rate_thread(void* arg)
+{
+    // ローカル変数宣言
+    m46e_statistics_t*        statistics;
+    m46e_statistics_rate_t*   rate;
+    m46e_statistics_sample_t* sample;
+    uint64_t                  prev_pkts[M46E_STATISTICS_RATE_DIR_NUM];
+    uint64_t                  prev_bytes[M46E_STATISTICS_RATE_DIR_NUM];
+    uint64_t                  pkts[M46E_STATISTICS_RATE_DIR_NUM];
+    uint64_t                  bytes[M46E_STATISTICS_RATE_DIR_NUM];
+    struct timespec           prev_time;
+    struct timespec           now;
+    struct timespec           next;
+    double                    elapsed;
+
+    // 引数チェック
+    if(arg == NULL){
+        pthread_exit(NULL);
+    }
+
+    statistics = (m46e_statistics_t*)arg;
+    rate       = &statistics->rate;
+
+    while(!statistics_get_rate_counter(statistics, prev_pkts, prev_bytes)){
+        // 取得できるまで1秒毎にリトライ(スレッドの取り消しはここで受け付ける)
+        sleep(1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &prev_time);
+    next = prev_time;
+
+    while(1){
+        // 次の1秒境界まで待ち合わせ(スレッドの取り消しはここで受け付ける)
+        next.tv_sec++;
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR){
+            // シグナル割り込みの場合は処理継続
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (double)(now.tv_sec - prev_time.tv_sec) + (double)(now.tv_nsec - prev_time.tv_nsec) / 1000000000.0;
+        if(elapsed <= 0.0){
+            continue;
+        }
+
+        // スナップショット取得
+        // (取得できない場合は今回の算出を見送り、次回に経過時間込みで算出する)
+        if(!statistics_get_rate_counter(statistics, pkts, bytes)){
+            continue;
+        }
+
+        // 待ち合わせが遅れた場合も実経過時間で正規化する
+        sample = &rate->sample[rate->head];
+        for(int i = 0; i < M46E_STATISTICS_RATE_DIR_NUM; i++){
+            sample->pps[i] = (uint64_t)((double)(pkts[i] - prev_pkts[i]) / elapsed);
+            sample->bps[i] = (uint64_t)((double)(bytes[i] - prev_bytes[i]) * 8.0 / elapsed);
+
+            if(sample->pps[i] > rate->peak.pps[i]){
+                rate->peak.pps[i] = sample->pps[i];
+            }
+            if(sample->bps[i] > rate->peak.bps[i]){
+                rate->peak.bps[i] = sample->bps[i];
+            }
+
+            prev_pkts[i]  = pkts[i];
+            prev_bytes[i] = bytes[i];
+        }
+
+        // スナップショットを書き終えてから書き込み位置を進める
+        __sync_synchronize();
+        rate->head = (rate->head + 1) % M46E_STATISTICS_RATE_RING;
+        if(rate->num < M46E_STATISTICS_RATE_RING){
+            rate->num++;
+        }
+
+        // 大きく遅れた場合は待ち合わせの基準を現在時刻に合わせる
+        if(now.tv_sec > next.tv_sec){
+            next = now;
+        }
+        prev_time = now;
+    }
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 転送レート算出用カウンタ取得関数
+//!
+//! 転送レート算出対象毎のパケット数とバイト数を取得する。
+//! 送信は送信成功分のみを対象とする。
+//!
+//! @param [in]  statistics 統計情報用領域のポインタ
+//! @param [out] pkts       パケット数格納先(M46E_STATISTICS_RATE_DIR_NUM個)
+//! @param [out] bytes      バイト数格納先(M46E_STATISTICS_RATE_DIR_NUM個)
+//!
+//! @retval true   取得成功
+//! @retval false  取得失敗
+///////////////////////////////////////////////////////////////////////////////
+static bool statistics_get_rate_counter(m46e_statistics_t* statistics, uint64_t* pkts, uint64_t* bytes)
+{
+    // ローカル変数宣言
+    m46e_statistics_counter_t total;
+
+    if(!m46e_statistics_sum(statistics, &total)){
+        return false;
+    }
+
+    pkts[M46E_STATISTICS_RATE_V4_RECV]  = total.tunnel_v4_recieve_count;
+    bytes[M46E_STATISTICS_RATE_V4_RECV] = total.tunnel_v4_recieve_bytes;
+    pkts[M46E_STATISTICS_RATE_V4_SEND]  = total.tunnel_v4_send_v6_success_count
+                                        + total.tunnel_v4_send_fragment_success_count;
+    bytes[M46E_STATISTICS_RATE_V4_SEND] = total.tunnel_v4_send_bytes;
+    pkts[M46E_STATISTICS_RATE_V6_RECV]  = total.tunnel_v6_recieve_count;
+    bytes[M46E_STATISTICS_RATE_V6_RECV] = total.tunnel_v6_recieve_bytes;
+    pkts[M46E_STATISTICS_RATE_V6_SEND]  = total.tunnel_v6_send_v4_success_count;
+    bytes[M46E_STATISTICS_RATE_V6_SEND] = total.tunnel_v6_send_bytes;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 転送レート出力関数
+//!
+//! 直近1秒間の転送レートと起動後の最大値を出力する。
+//!
+//! @param [in] statistics      統計情報用領域のポインタ
+//! @param [in] fd              統計情報出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void statistics_printf_rate(m46e_statistics_t* statistics, int fd)
+{
+    // ローカル変数宣言
+    m46e_statistics_rate_t*  rate = &statistics->rate;
+    m46e_statistics_sample_t current;
+    const char*              label[M46E_STATISTICS_RATE_DIR_NUM] = {
+        "IPv4 -> IPv6 recieve          ",
+        "IPv4 -> IPv6 send             ",
+        "IPv6 -> IPv4 recieve          ",
+        "IPv6 -> IPv4 send             ",
+    };
+
+    // 算出前はゼロとして扱う
+    memset(&current, 0, sizeof(current));
+    if(rate->num > 0){
+        current = rate->sample[(rate->head + M46E_STATISTICS_RATE_RING - 1) % M46E_STATISTICS_RATE_RING];
+    }
+
+    dprintf(fd, "【RATE】\n");
+    dprintf(fd, "\n");
+    dprintf(fd, "   current(last 1 sec) / peak\n");
+    for(int i = 0; i < M46E_STATISTICS_RATE_DIR_NUM; i++){
+        dprintf(fd, "     %s  : %" PRIu64 " pps, %" PRIu64 " bps (peak %" PRIu64 " pps, %" PRIu64 " bps)\n",
+            label[i], current.pps[i], current.bps[i], rate->peak.pps[i], rate->peak.bps[i]);
+    }
+    dprintf(fd, "\n");
+    dprintf(fd, "\n");
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 処理時間パーセンタイル取得関数
+//!
+//! 処理時間ヒストグラムから指定したパーセンタイル値を求める。<br/>
+//! 該当する区間の上限値を返す(区間の幅だけ大きめの値となる)。
+//!
+//! @param [in] latency   処理時間ヒストグラム
+//! @param [in] percent   パーセンタイル(0～100)
+//!
+//! @return パーセンタイル値(ns)。計測結果が無い場合は0。
+///////////////////////////////////////////////////////////////////////////////
+uint64_t m46e_statistics_latency_percentile(const m46e_statistics_latency_t* latency, const double percent)
+{
+    // ローカル変数宣言
+    uint64_t total;
+    uint64_t rank;
+    uint64_t count;
+    uint64_t upper;
+    int      shift;
+
+    // 引数チェック
+    if((latency == NULL) || (percent < 0.0) || (percent > 100.0)){
+        return 0;
+    }
+
+    // 更新中のヒストグラムを参照する場合もあるので、合計は区間毎の値から求める
+    total = 0;
+    for(int i = 0; i < M46E_STATISTICS_LATENCY_BUCKET_NUM; i++){
+        total += latency->bucket[i];
+    }
+    if(total == 0){
+        return 0;
+    }
+
+    rank = (uint64_t)((double)total * percent / 100.0 + 0.5);
+    if(rank == 0){
+        rank = 1;
+    }
+
+    count = 0;
+    for(int i = 0; i < M46E_STATISTICS_LATENCY_BUCKET_NUM; i++){
+        count += latency->bucket[i];
+        if(count < rank){
+            continue;
+        }
+
+        if(i == M46E_STATISTICS_LATENCY_BUCKET_NUM - 1){
+            // 最終区間は上限が無いので最大値を返す
+            return latency->max;
+        }
+        else if(i < M46E_STATISTICS_LATENCY_SUB_NUM){
+            upper = i;
+        }
+        else{
+            shift = (i >> M46E_STATISTICS_LATENCY_SUB_BITS) - 1;
+            upper = ((uint64_t)(M46E_STATISTICS_LATENCY_SUB_NUM + (i & (M46E_STATISTICS_LATENCY_SUB_NUM - 1))) << shift)
+                  + (1ULL << shift) - 1;
+        }
+
+        // 区間の上限が実測の最大値を超える場合は最大値を返す
+        return (upper < latency->max) ? upper : latency->max;
+    }
+
+    return latency->max;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 処理時間出力関数
+//!
+//! カプセル化/デカプセル化の処理時間(パケット受信から送信完了まで)の
+//! パーセンタイル値を出力する。
+//!
+//! @param [in] statistics      統計情報用領域のポインタ
+//! @param [in] fd              統計情報出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void statistics_printf_latency(m46e_statistics_t* statistics, int fd)
+{
+    // ローカル変数宣言
+    const m46e_statistics_latency_t* latency;
+    const int    worker[]  = { M46E_STATISTICS_WORKER_ENCAP, M46E_STATISTICS_WORKER_DECAP };
+    const char*  title[]   = { "encap(IPv4 -> IPv6)", "decap(IPv6 -> IPv4)" };
+    const double percent[] = { 50.0, 90.0, 99.0, 99.9 };
+    const char*  label[]   = {
+        "p50                           ",
+        "p90                           ",
+        "p99                           ",
+        "p99.9                         ",
+    };
+
+    dprintf(fd, "【LATENCY】\n");
+    dprintf(fd, "\n");
+    for(int i = 0; i < sizeof(worker) / sizeof(worker[0]); i++){
+        latency = &statistics->latency[worker[i]];
+
+        dprintf(fd, "   %s\n", title[i]);
+        dprintf(fd, "     sample count                    : %" PRIu64 " \n", latency->count);
+        if(latency->count == 0){
+            continue;
+        }
+        dprintf(fd, "     average                         : %.3f usec\n", (double)latency->sum / latency->count / 1000.0);
+        for(int j = 0; j < sizeof(percent) / sizeof(percent[0]); j++){
+            dprintf(fd, "     %s  : %.3f usec\n", label[j],
+                (double)m46e_statistics_latency_percentile(latency, percent[j]) / 1000.0);
+        }
+        dprintf(fd, "     max                             : %.3f usec\n", (double)latency->max / 1000.0);
+    }
+    dprintf(fd, "\n");
+    dprintf(fd, "\n");
+
+    return;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 受信パケット合計数取得関数
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics_info 集計した統計情報
 //!
 //! @return 受信パケット合計数
 ///////////////////////////////////////////////////////////////////////////////
-static inline uint32_t statistics_get_total_recv(m46e_statistics_t* statistics_info)
+static inline uint64_t statistics_get_total_recv(m46e_statistics_counter_t* statistics_info)
 {
-    uint32_t result = 0;
+    uint64_t result = 0;
 
     result += statistics_info->tunnel_v4_recieve_count;
     result += statistics_info->tunnel_v6_recieve_count;
@@ -107,13 +721,13 @@ static inline uint32_t statistics_get_total_recv(m46e_statistics_t* statistics_i
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 送信パケット合計数取得関数
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics_info 集計した統計情報
 //!
 //! @return 送信パケット合計数
 ///////////////////////////////////////////////////////////////////////////////
-static inline uint32_t statistics_get_total_send(m46e_statistics_t* statistics_info)
+static inline uint64_t statistics_get_total_send(m46e_statistics_counter_t* statistics_info)
 {
-    uint32_t result = 0;
+    uint64_t result = 0;
 
     result += statistics_info->tunnel_v4_send_count;
     result += statistics_info->tunnel_v6_send_count;
@@ -124,13 +738,13 @@ static inline uint32_t statistics_get_total_send(m46e_statistics_t* statistics_i
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ドロップパケット合計数取得関数
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics_info 集計した統計情報
 //!
 //! @return ドロップパケット合計数
 ///////////////////////////////////////////////////////////////////////////////
-static inline uint32_t statistics_get_total_drop(m46e_statistics_t* statistics_info)
+static inline uint64_t statistics_get_total_drop(m46e_statistics_counter_t* statistics_info)
 {
-    uint32_t result = 0;
+    uint64_t result = 0;
 
     result += statistics_info->tunnel_v4_err_broadcast_count;
     result += statistics_info->tunnel_v4_err_other_proto_count;
@@ -144,6 +758,7 @@ static inline uint32_t statistics_get_total_drop(m46e_statistics_t* statistics_i
     result += statistics_info->tunnel_v6_err_other_proto_count;
     result += statistics_info->tunnel_v6_err_linklocal_multi_count;
     result += statistics_info->tunnel_v6_err_nxthdr_count;
+    result += statistics_info->tunnel_v6_err_reasm_count;
 
     return result;
 }
@@ -151,13 +766,13 @@ static inline uint32_t statistics_get_total_drop(m46e_statistics_t* statistics_i
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief エラーパケット合計数取得関数
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics_info 集計した統計情報
 //!
 //! @return エラーパケット合計数
 ///////////////////////////////////////////////////////////////////////////////
-static inline uint32_t statistics_get_total_error(m46e_statistics_t* statistics_info)
+static inline uint64_t statistics_get_total_error(m46e_statistics_counter_t* statistics_info)
 {
-    uint32_t result = 0;
+    uint64_t result = 0;
 
     result += statistics_info->tunnel_v4_send_v6_err_count;
     result += statistics_info->tunnel_v4_send_fragment_err_count;
@@ -172,63 +787,103 @@ static inline uint32_t statistics_get_total_error(m46e_statistics_t* statistics_
 //!
 //! 統計情報を引数で指定されたディスクリプタへ出力する。
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics      統計情報用領域のポインタ
 //! @param [in] fd              統計情報出力先のディスクリプタ
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-void m46e_printf_statistics_info_normal(m46e_statistics_t* statistics_info, int fd)
+void m46e_printf_statistics_info_normal(m46e_statistics_t* statistics, int fd)
 {
+    // スレッド種別毎のカウンタを集計
+    m46e_statistics_counter_t total;
+    m46e_statistics_counter_t* statistics_info = &total;
+    if(!m46e_statistics_sum(statistics, statistics_info)){
+        dprintf(fd, "statistics is busy. please retry.\n");
+        return;
+    }
+
     // 統計情報をファイルへ出力する
     dprintf(fd, "【M46E】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     total recieve count             : %d\n", statistics_get_total_recv(statistics_info));
-    dprintf(fd, "     total send count                : %d\n", statistics_get_total_send(statistics_info));
-    dprintf(fd, "     total drop count                : %d\n", statistics_get_total_drop(statistics_info));
-    dprintf(fd, "     total error count               : %d\n", statistics_get_total_error(statistics_info));
+    dprintf(fd, "     total recieve count             : %" PRIu64 "\n", statistics_get_total_recv(statistics_info));
+    dprintf(fd, "     total send count                : %" PRIu64 "\n", statistics_get_total_send(statistics_info));
+    dprintf(fd, "     total drop count                : %" PRIu64 "\n", statistics_get_total_drop(statistics_info));
+    dprintf(fd, "     total error count               : %" PRIu64 "\n", statistics_get_total_error(statistics_info));
     dprintf(fd, "\n");
     dprintf(fd, "\n");
+
+    // 転送レートを出力する
+    statistics_printf_rate(statistics, fd);
+
+    // 処理時間を出力する
+    statistics_printf_latency(statistics, fd);
     dprintf(fd, "【TUNNEL IPV4】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     recieve count                   : %d \n", statistics_info->tunnel_v4_recieve_count);
-    dprintf(fd, "       unicast(forward)              : %d \n", statistics_info->tunnel_v4_recv_unicast_count);
-    dprintf(fd, "       multicast(forward)            : %d \n", statistics_info->tunnel_v4_recv_multicast_count);
-    dprintf(fd, "       broadcast(drop)               : %d \n", statistics_info->tunnel_v4_err_broadcast_count);
-    dprintf(fd, "       not IPv4 protocol(drop)       : %d \n", statistics_info->tunnel_v4_err_other_proto_count);
-    dprintf(fd, "       link local multicast(drop)    : %d \n", statistics_info->tunnel_v4_err_linklocal_multi_count);
-    dprintf(fd, "     send count                      : %d \n", statistics_info->tunnel_v4_send_count);
-    dprintf(fd, "       send success                  : %d \n", statistics_info->tunnel_v4_send_v6_success_count);
-    dprintf(fd, "       send error                    : %d \n", statistics_info->tunnel_v4_send_v6_err_count);
-    dprintf(fd, "       send(fragment) success        : %d \n", statistics_info->tunnel_v4_send_fragment_success_count);
-    dprintf(fd, "       send(fragment) error          : %d \n", statistics_info->tunnel_v4_send_fragment_err_count);
+    dprintf(fd, "     recieve count                   : %" PRIu64 " \n", statistics_info->tunnel_v4_recieve_count);
+    dprintf(fd, "       unicast(forward)              : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_unicast_count);
+    dprintf(fd, "       multicast(forward)            : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_multicast_count);
+    dprintf(fd, "       broadcast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v4_err_broadcast_count);
+    dprintf(fd, "       not IPv4 protocol(drop)       : %" PRIu64 " \n", statistics_info->tunnel_v4_err_other_proto_count);
+    dprintf(fd, "       link local multicast(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v4_err_linklocal_multi_count);
+    dprintf(fd, "     send count                      : %" PRIu64 " \n", statistics_info->tunnel_v4_send_count);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_success_count);
+    dprintf(fd, "       send error                    : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_err_count);
+    dprintf(fd, "       send(fragment) success        : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_success_count);
+    dprintf(fd, "       send(fragment) error          : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_err_count);
+    dprintf(fd, "   byte count\n");
+    dprintf(fd, "     recieve bytes                   : %" PRIu64 " \n", statistics_info->tunnel_v4_recieve_bytes);
+    dprintf(fd, "       unicast(forward)              : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_unicast_bytes);
+    dprintf(fd, "       multicast(forward)            : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_multicast_bytes);
+    dprintf(fd, "     send bytes                      : %" PRIu64 " \n", statistics_info->tunnel_v4_send_bytes);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_success_bytes);
+    dprintf(fd, "       send(fragment) success        : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_success_bytes);
     dprintf(fd, "\n");
     dprintf(fd, "\n");
     dprintf(fd, "【TUNNEL IPV6】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     recieve count                   : %d \n", statistics_info->tunnel_v6_recieve_count);
-    dprintf(fd, "       encap unicast(forward)        : %d \n", statistics_info->tunnel_v6_recv_unicast_count);
-    dprintf(fd, "       encap multicast(forward)      : %d \n", statistics_info->tunnel_v6_recv_multicast_count);
-    dprintf(fd, "       broadcast(drop)               : %d \n", statistics_info->tunnel_v6_err_broadcast_count);
-    dprintf(fd, "       not IPv6 protocol(drop)       : %d \n", statistics_info->tunnel_v6_err_other_proto_count);
-    dprintf(fd, "       ttl over(drop)                : %d \n", statistics_info->tunnel_v6_err_ttl_count);
-    dprintf(fd, "       link local multicast(drop)    : %d \n", statistics_info->tunnel_v6_err_linklocal_multi_count);
-    dprintf(fd, "       invalid next header(drop)     : %d \n", statistics_info->tunnel_v6_err_nxthdr_count);
-    dprintf(fd, "     send count                      : %d \n", statistics_info->tunnel_v6_send_count);
-    dprintf(fd, "       send success                  : %d \n", statistics_info->tunnel_v6_send_v4_success_count);
-    dprintf(fd, "       send error                    : %d \n", statistics_info->tunnel_v6_send_v4_err_count);
+    dprintf(fd, "     recieve count                   : %" PRIu64 " \n", statistics_info->tunnel_v6_recieve_count);
+    dprintf(fd, "       encap unicast(forward)        : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_unicast_count);
+    dprintf(fd, "       encap multicast(forward)      : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_multicast_count);
+    dprintf(fd, "       broadcast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v6_err_broadcast_count);
+    dprintf(fd, "       not IPv6 protocol(drop)       : %" PRIu64 " \n", statistics_info->tunnel_v6_err_other_proto_count);
+    dprintf(fd, "       ttl over(drop)                : %" PRIu64 " \n", statistics_info->tunnel_v6_err_ttl_count);
+    dprintf(fd, "       link local multicast(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v6_err_linklocal_multi_count);
+    dprintf(fd, "       invalid next header(drop)     : %" PRIu64 " \n", statistics_info->tunnel_v6_err_nxthdr_count);
+    dprintf(fd, "       fragment                      : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_fragment_count);
+    dprintf(fd, "         reassemble success          : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_success_count);
+    dprintf(fd, "         reassemble timeout          : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_timeout_count);
+    dprintf(fd, "         invalid/over limit(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v6_err_reasm_count);
+    dprintf(fd, "     send count                      : %" PRIu64 " \n", statistics_info->tunnel_v6_send_count);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_success_count);
+    dprintf(fd, "       send error                    : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_err_count);
+    dprintf(fd, "   byte count\n");
+    dprintf(fd, "     recieve bytes                   : %" PRIu64 " \n", statistics_info->tunnel_v6_recieve_bytes);
+    dprintf(fd, "       encap unicast(forward)        : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_unicast_bytes);
+    dprintf(fd, "       encap multicast(forward)      : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_multicast_bytes);
+    dprintf(fd, "     send bytes                      : %" PRIu64 " \n", statistics_info->tunnel_v6_send_bytes);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_success_bytes);
     dprintf(fd, "\n");
     dprintf(fd, "【ICMP】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
     dprintf(fd, "     recieve count\n");
-    dprintf(fd, "       IPv6 icmp packet too big      : %d \n", statistics_info->icmp_pkt_toobig_recv_count);
+    dprintf(fd, "       IPv6 icmp packet too big      : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_recv_count);
+    dprintf(fd, "         suppressed(duplicate)       : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_suppress_count);
+    dprintf(fd, "         invalid(drop)               : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_invalid_count);
     dprintf(fd, "     send count\n");
-    dprintf(fd, "       IPv4 icmp fragment needed     : %d \n", statistics_info->icmp_fragneeded_send_count);
-    dprintf(fd, "         send success                : %d \n", statistics_info->icmp_fragneeded_send_success_count);
-    dprintf(fd, "         send error                  : %d \n", statistics_info->icmp_fragneeded_send_err_count);
+    dprintf(fd, "       IPv4 icmp fragment needed     : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_count);
+    dprintf(fd, "         send success                : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_success_count);
+    dprintf(fd, "         send error                  : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_err_count);
+    dprintf(fd, "         suppressed(rate limit)      : %" PRIu64 " \n", statistics_info->icmp_fragneeded_suppress_count);
+    dprintf(fd, "\n");
+    dprintf(fd, "【PATH MTU】\n");
+    dprintf(fd, "\n");
+    dprintf(fd, "   probe count\n");
+    dprintf(fd, "     probe send                      : %" PRIu64 " \n", statistics_info->pmtu_probe_send_count);
+    dprintf(fd, "     path mtu restore                : %" PRIu64 " \n", statistics_info->pmtu_probe_restore_count);
     dprintf(fd, "\n");
 
     return;
@@ -239,65 +894,105 @@ void m46e_printf_statistics_info_normal(m46e_statistics_t* statistics_info, int
 //!
 //! 統計情報を引数で指定されたディスクリプタへ出力する。
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics      統計情報用領域のポインタ
 //! @param [in] fd              統計情報出力先のディスクリプタ
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-void m46e_printf_statistics_info_as(m46e_statistics_t* statistics_info, int fd)
+void m46e_printf_statistics_info_as(m46e_statistics_t* statistics, int fd)
 {
+    // スレッド種別毎のカウンタを集計
+    m46e_statistics_counter_t total;
+    m46e_statistics_counter_t* statistics_info = &total;
+    if(!m46e_statistics_sum(statistics, statistics_info)){
+        dprintf(fd, "statistics is busy. please retry.\n");
+        return;
+    }
+
     // 統計情報をファイルへ出力する
     dprintf(fd, "【M46E-AS】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     total recieve count             : %d\n", statistics_get_total_recv(statistics_info));
-    dprintf(fd, "     total send count                : %d\n", statistics_get_total_send(statistics_info));
-    dprintf(fd, "     total drop count                : %d\n", statistics_get_total_drop(statistics_info));
-    dprintf(fd, "     total error count               : %d\n", statistics_get_total_error(statistics_info));
+    dprintf(fd, "     total recieve count             : %" PRIu64 "\n", statistics_get_total_recv(statistics_info));
+    dprintf(fd, "     total send count                : %" PRIu64 "\n", statistics_get_total_send(statistics_info));
+    dprintf(fd, "     total drop count                : %" PRIu64 "\n", statistics_get_total_drop(statistics_info));
+    dprintf(fd, "     total error count               : %" PRIu64 "\n", statistics_get_total_error(statistics_info));
     dprintf(fd, "\n");
     dprintf(fd, "\n");
+
+    // 転送レートを出力する
+    statistics_printf_rate(statistics, fd);
+
+    // 処理時間を出力する
+    statistics_printf_latency(statistics, fd);
     dprintf(fd, "【TUNNEL IPV4】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     recieve count                   : %d \n", statistics_info->tunnel_v4_recieve_count);
-    dprintf(fd, "       unicast(forward)              : %d \n", statistics_info->tunnel_v4_recv_unicast_count);
-    dprintf(fd, "       multicast(forward)            : %d \n", statistics_info->tunnel_v4_recv_multicast_count);
-    dprintf(fd, "       broadcast(drop)               : %d \n", statistics_info->tunnel_v4_err_broadcast_count);
-    dprintf(fd, "       not IPv4 protocol(drop)       : %d \n", statistics_info->tunnel_v4_err_other_proto_count);
-    dprintf(fd, "       link local multicast(drop)    : %d \n", statistics_info->tunnel_v4_err_linklocal_multi_count);
-    dprintf(fd, "       fragment(drop)                : %d \n", statistics_info->tunnel_v4_err_as_fragment_count);
-    dprintf(fd, "       not TCP/UDP(drop)             : %d \n", statistics_info->tunnel_v4_err_as_not_support_proto_count);
-    dprintf(fd, "     send count                      : %d \n", statistics_info->tunnel_v4_send_count);
-    dprintf(fd, "       send success                  : %d \n", statistics_info->tunnel_v4_send_v6_success_count);
-    dprintf(fd, "       send error                    : %d \n", statistics_info->tunnel_v4_send_v6_err_count);
-    dprintf(fd, "       send(fragment) success        : %d \n", statistics_info->tunnel_v4_send_fragment_success_count);
-    dprintf(fd, "       send(fragment) error          : %d \n", statistics_info->tunnel_v4_send_fragment_err_count);
+    dprintf(fd, "     recieve count                   : %" PRIu64 " \n", statistics_info->tunnel_v4_recieve_count);
+    dprintf(fd, "       unicast(forward)              : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_unicast_count);
+    dprintf(fd, "       multicast(forward)            : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_multicast_count);
+    dprintf(fd, "       broadcast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v4_err_broadcast_count);
+    dprintf(fd, "       not IPv4 protocol(drop)       : %" PRIu64 " \n", statistics_info->tunnel_v4_err_other_proto_count);
+    dprintf(fd, "       link local multicast(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v4_err_linklocal_multi_count);
+    dprintf(fd, "       fragment(drop)                : %" PRIu64 " \n", statistics_info->tunnel_v4_err_as_fragment_count);
+    dprintf(fd, "       not TCP/UDP(drop)             : %" PRIu64 " \n", statistics_info->tunnel_v4_err_as_not_support_proto_count);
+    dprintf(fd, "     send count                      : %" PRIu64 " \n", statistics_info->tunnel_v4_send_count);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_success_count);
+    dprintf(fd, "       send error                    : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_err_count);
+    dprintf(fd, "       send(fragment) success        : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_success_count);
+    dprintf(fd, "       send(fragment) error          : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_err_count);
+    dprintf(fd, "   byte count\n");
+    dprintf(fd, "     recieve bytes                   : %" PRIu64 " \n", statistics_info->tunnel_v4_recieve_bytes);
+    dprintf(fd, "       unicast(forward)              : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_unicast_bytes);
+    dprintf(fd, "       multicast(forward)            : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_multicast_bytes);
+    dprintf(fd, "     send bytes                      : %" PRIu64 " \n", statistics_info->tunnel_v4_send_bytes);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_success_bytes);
+    dprintf(fd, "       send(fragment) success        : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_success_bytes);
     dprintf(fd, "\n");
     dprintf(fd, "\n");
     dprintf(fd, "【TUNNEL IPV6】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     recieve count                   : %d \n", statistics_info->tunnel_v6_recieve_count);
-    dprintf(fd, "       encap unicast(forward)        : %d \n", statistics_info->tunnel_v6_recv_unicast_count);
-    dprintf(fd, "       encap multicast(forward)      : %d \n", statistics_info->tunnel_v6_recv_multicast_count);
-    dprintf(fd, "       broadcast(drop)               : %d \n", statistics_info->tunnel_v6_err_broadcast_count);
-    dprintf(fd, "       not IPv6 protocol(drop)       : %d \n", statistics_info->tunnel_v6_err_other_proto_count);
-    dprintf(fd, "       ttl over(drop)                : %d \n", statistics_info->tunnel_v6_err_ttl_count);
-    dprintf(fd, "       link local multicast(drop)    : %d \n", statistics_info->tunnel_v6_err_linklocal_multi_count);
-    dprintf(fd, "       invalid next header(drop)     : %d \n", statistics_info->tunnel_v6_err_nxthdr_count);
-    dprintf(fd, "     send count                      : %d \n", statistics_info->tunnel_v6_send_count);
-    dprintf(fd, "       send success                  : %d \n", statistics_info->tunnel_v6_send_v4_success_count);
-    dprintf(fd, "       send error                    : %d \n", statistics_info->tunnel_v6_send_v4_err_count);
+    dprintf(fd, "     recieve count                   : %" PRIu64 " \n", statistics_info->tunnel_v6_recieve_count);
+    dprintf(fd, "       encap unicast(forward)        : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_unicast_count);
+    dprintf(fd, "       encap multicast(forward)      : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_multicast_count);
+    dprintf(fd, "       broadcast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v6_err_broadcast_count);
+    dprintf(fd, "       not IPv6 protocol(drop)       : %" PRIu64 " \n", statistics_info->tunnel_v6_err_other_proto_count);
+    dprintf(fd, "       ttl over(drop)                : %" PRIu64 " \n", statistics_info->tunnel_v6_err_ttl_count);
+    dprintf(fd, "       link local multicast(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v6_err_linklocal_multi_count);
+    dprintf(fd, "       invalid next header(drop)     : %" PRIu64 " \n", statistics_info->tunnel_v6_err_nxthdr_count);
+    dprintf(fd, "       fragment                      : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_fragment_count);
+    dprintf(fd, "         reassemble success          : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_success_count);
+    dprintf(fd, "         reassemble timeout          : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_timeout_count);
+    dprintf(fd, "         invalid/over limit(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v6_err_reasm_count);
+    dprintf(fd, "     send count                      : %" PRIu64 " \n", statistics_info->tunnel_v6_send_count);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_success_count);
+    dprintf(fd, "       send error                    : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_err_count);
+    dprintf(fd, "   byte count\n");
+    dprintf(fd, "     recieve bytes                   : %" PRIu64 " \n", statistics_info->tunnel_v6_recieve_bytes);
+    dprintf(fd, "       encap unicast(forward)        : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_unicast_bytes);
+    dprintf(fd, "       encap multicast(forward)      : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_multicast_bytes);
+    dprintf(fd, "     send bytes                      : %" PRIu64 " \n", statistics_info->tunnel_v6_send_bytes);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_success_bytes);
     dprintf(fd, "\n");
     dprintf(fd, "【ICMP】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
     dprintf(fd, "     recieve count\n");
-    dprintf(fd, "       IPv6 icmp packet too big      : %d \n", statistics_info->icmp_pkt_toobig_recv_count);
+    dprintf(fd, "       IPv6 icmp packet too big      : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_recv_count);
+    dprintf(fd, "         suppressed(duplicate)       : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_suppress_count);
+    dprintf(fd, "         invalid(drop)               : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_invalid_count);
     dprintf(fd, "     send count\n");
-    dprintf(fd, "       IPv4 icmp fragment needed     : %d \n", statistics_info->icmp_fragneeded_send_count);
-    dprintf(fd, "         send success                : %d \n", statistics_info->icmp_fragneeded_send_success_count);
-    dprintf(fd, "         send error                  : %d \n", statistics_info->icmp_fragneeded_send_err_count);
+    dprintf(fd, "       IPv4 icmp fragment needed     : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_count);
+    dprintf(fd, "         send success                : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_success_count);
+    dprintf(fd, "         send error                  : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_err_count);
+    dprintf(fd, "         suppressed(rate limit)      : %" PRIu64 " \n", statistics_info->icmp_fragneeded_suppress_count);
+    dprintf(fd, "\n");
+    dprintf(fd, "【PATH MTU】\n");
+    dprintf(fd, "\n");
+    dprintf(fd, "   probe count\n");
+    dprintf(fd, "     probe send                      : %" PRIu64 " \n", statistics_info->pmtu_probe_send_count);
+    dprintf(fd, "     path mtu restore                : %" PRIu64 " \n", statistics_info->pmtu_probe_restore_count);
     dprintf(fd, "\n");
 
     return;
@@ -307,62 +1002,651 @@ void m46e_printf_statistics_info_as(m46e_statistics_t* statistics_info, int fd)
 //!
 //! 統計情報を引数で指定されたディスクリプタへ出力する。
 //!
-//! @param [in] statistics_info 統計情報用領域のポインタ
+//! @param [in] statistics      統計情報用領域のポインタ
 //! @param [in] fd              統計情報出力先のディスクリプタ
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-void m46e_printf_statistics_info_pr(m46e_statistics_t* statistics_info, int fd)
+void m46e_printf_statistics_info_pr(m46e_statistics_t* statistics, int fd)
 {
+    // スレッド種別毎のカウンタを集計
+    m46e_statistics_counter_t total;
+    m46e_statistics_counter_t* statistics_info = &total;
+    if(!m46e_statistics_sum(statistics, statistics_info)){
+        dprintf(fd, "statistics is busy. please retry.\n");
+        return;
+    }
+
     // 統計情報をファイルへ出力する
     dprintf(fd, "【M46E-PR】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     total recieve count             : %d\n", statistics_get_total_recv(statistics_info));
-    dprintf(fd, "     total send count                : %d\n", statistics_get_total_send(statistics_info));
-    dprintf(fd, "     total drop count                : %d\n", statistics_get_total_drop(statistics_info));
-    dprintf(fd, "     total error count               : %d\n", statistics_get_total_error(statistics_info));
+    dprintf(fd, "     total recieve count             : %" PRIu64 "\n", statistics_get_total_recv(statistics_info));
+    dprintf(fd, "     total send count                : %" PRIu64 "\n", statistics_get_total_send(statistics_info));
+    dprintf(fd, "     total drop count                : %" PRIu64 "\n", statistics_get_total_drop(statistics_info));
+    dprintf(fd, "     total error count               : %" PRIu64 "\n", statistics_get_total_error(statistics_info));
     dprintf(fd, "\n");
     dprintf(fd, "\n");
+
+    // 転送レートを出力する
+    statistics_printf_rate(statistics, fd);
+
+    // 処理時間を出力する
+    statistics_printf_latency(statistics, fd);
     dprintf(fd, "【TUNNEL IPV4】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     recieve count                   : %d \n", statistics_info->tunnel_v4_recieve_count);
-    dprintf(fd, "       unicast(forward)              : %d \n", statistics_info->tunnel_v4_recv_unicast_count);
-    dprintf(fd, "       broadcast(drop)               : %d \n", statistics_info->tunnel_v4_err_broadcast_count);
-    dprintf(fd, "       not IPv4 protocol(drop)       : %d \n", statistics_info->tunnel_v4_err_other_proto_count);
-    dprintf(fd, "       multicast(drop)               : %d \n", statistics_info->tunnel_v4_err_pr_multi_count);
-    dprintf(fd, "       destination unknown(drop)     : %d \n", statistics_info->tunnel_v4_err_pr_search_failure_count);
-    dprintf(fd, "     send count                      : %d \n", statistics_info->tunnel_v4_send_count);
-    dprintf(fd, "       send success                  : %d \n", statistics_info->tunnel_v4_send_v6_success_count);
-    dprintf(fd, "       send error                    : %d \n", statistics_info->tunnel_v4_send_v6_err_count);
-    dprintf(fd, "       send(fragment) success        : %d \n", statistics_info->tunnel_v4_send_fragment_success_count);
-    dprintf(fd, "       send(fragment) error          : %d \n", statistics_info->tunnel_v4_send_fragment_err_count);
+    dprintf(fd, "     recieve count                   : %" PRIu64 " \n", statistics_info->tunnel_v4_recieve_count);
+    dprintf(fd, "       unicast(forward)              : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_unicast_count);
+    dprintf(fd, "       broadcast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v4_err_broadcast_count);
+    dprintf(fd, "       not IPv4 protocol(drop)       : %" PRIu64 " \n", statistics_info->tunnel_v4_err_other_proto_count);
+    dprintf(fd, "       multicast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v4_err_pr_multi_count);
+    dprintf(fd, "       destination unknown(drop)     : %" PRIu64 " \n", statistics_info->tunnel_v4_err_pr_search_failure_count);
+    dprintf(fd, "     send count                      : %" PRIu64 " \n", statistics_info->tunnel_v4_send_count);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_success_count);
+    dprintf(fd, "       send error                    : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_err_count);
+    dprintf(fd, "       send(fragment) success        : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_success_count);
+    dprintf(fd, "       send(fragment) error          : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_err_count);
+    dprintf(fd, "   byte count\n");
+    dprintf(fd, "     recieve bytes                   : %" PRIu64 " \n", statistics_info->tunnel_v4_recieve_bytes);
+    dprintf(fd, "       unicast(forward)              : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_unicast_bytes);
+    dprintf(fd, "       multicast(forward)            : %" PRIu64 " \n", statistics_info->tunnel_v4_recv_multicast_bytes);
+    dprintf(fd, "     send bytes                      : %" PRIu64 " \n", statistics_info->tunnel_v4_send_bytes);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v4_send_v6_success_bytes);
+    dprintf(fd, "       send(fragment) success        : %" PRIu64 " \n", statistics_info->tunnel_v4_send_fragment_success_bytes);
     dprintf(fd, "\n");
     dprintf(fd, "\n");
     dprintf(fd, "【TUNNEL IPV6】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
-    dprintf(fd, "     recieve count                   : %d \n", statistics_info->tunnel_v6_recieve_count);
-    dprintf(fd, "       encap unicast(forward)        : %d \n", statistics_info->tunnel_v6_recv_unicast_count);
-    dprintf(fd, "       broadcast(drop)               : %d \n", statistics_info->tunnel_v6_err_broadcast_count);
-    dprintf(fd, "       not IPv6 protocol(drop)       : %d \n", statistics_info->tunnel_v6_err_other_proto_count);
-    dprintf(fd, "       ttl over(drop)                : %d \n", statistics_info->tunnel_v6_err_ttl_count);
-    dprintf(fd, "       invalid next header(drop)     : %d \n", statistics_info->tunnel_v6_err_nxthdr_count);
-    dprintf(fd, "     send count                      : %d \n", statistics_info->tunnel_v6_send_count);
-    dprintf(fd, "       send success                  : %d \n", statistics_info->tunnel_v6_send_v4_success_count);
-    dprintf(fd, "       send error                    : %d \n", statistics_info->tunnel_v6_send_v4_err_count);
+    dprintf(fd, "     recieve count                   : %" PRIu64 " \n", statistics_info->tunnel_v6_recieve_count);
+    dprintf(fd, "       encap unicast(forward)        : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_unicast_count);
+    dprintf(fd, "       broadcast(drop)               : %" PRIu64 " \n", statistics_info->tunnel_v6_err_broadcast_count);
+    dprintf(fd, "       not IPv6 protocol(drop)       : %" PRIu64 " \n", statistics_info->tunnel_v6_err_other_proto_count);
+    dprintf(fd, "       ttl over(drop)                : %" PRIu64 " \n", statistics_info->tunnel_v6_err_ttl_count);
+    dprintf(fd, "       invalid next header(drop)     : %" PRIu64 " \n", statistics_info->tunnel_v6_err_nxthdr_count);
+    dprintf(fd, "       fragment                      : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_fragment_count);
+    dprintf(fd, "         reassemble success          : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_success_count);
+    dprintf(fd, "         reassemble timeout          : %" PRIu64 " \n", statistics_info->tunnel_v6_reasm_timeout_count);
+    dprintf(fd, "         invalid/over limit(drop)    : %" PRIu64 " \n", statistics_info->tunnel_v6_err_reasm_count);
+    dprintf(fd, "     send count                      : %" PRIu64 " \n", statistics_info->tunnel_v6_send_count);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_success_count);
+    dprintf(fd, "       send error                    : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_err_count);
+    dprintf(fd, "   byte count\n");
+    dprintf(fd, "     recieve bytes                   : %" PRIu64 " \n", statistics_info->tunnel_v6_recieve_bytes);
+    dprintf(fd, "       encap unicast(forward)        : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_unicast_bytes);
+    dprintf(fd, "       encap multicast(forward)      : %" PRIu64 " \n", statistics_info->tunnel_v6_recv_multicast_bytes);
+    dprintf(fd, "     send bytes                      : %" PRIu64 " \n", statistics_info->tunnel_v6_send_bytes);
+    dprintf(fd, "       send success                  : %" PRIu64 " \n", statistics_info->tunnel_v6_send_v4_success_bytes);
     dprintf(fd, "\n");
     dprintf(fd, "【ICMP】\n");
     dprintf(fd, "\n");
     dprintf(fd, "   packet count\n");
     dprintf(fd, "     recieve count\n");
-    dprintf(fd, "       IPv6 icmp packet too big      : %d \n", statistics_info->icmp_pkt_toobig_recv_count);
+    dprintf(fd, "       IPv6 icmp packet too big      : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_recv_count);
+    dprintf(fd, "         suppressed(duplicate)       : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_suppress_count);
+    dprintf(fd, "         invalid(drop)               : %" PRIu64 " \n", statistics_info->icmp_pkt_toobig_invalid_count);
     dprintf(fd, "     send count\n");
-    dprintf(fd, "       IPv4 icmp fragment needed     : %d \n", statistics_info->icmp_fragneeded_send_count);
-    dprintf(fd, "         send success                : %d \n", statistics_info->icmp_fragneeded_send_success_count);
-    dprintf(fd, "         send error                  : %d \n", statistics_info->icmp_fragneeded_send_err_count);
+    dprintf(fd, "       IPv4 icmp fragment needed     : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_count);
+    dprintf(fd, "         send success                : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_success_count);
+    dprintf(fd, "         send error                  : %" PRIu64 " \n", statistics_info->icmp_fragneeded_send_err_count);
+    dprintf(fd, "         suppressed(rate limit)      : %" PRIu64 " \n", statistics_info->icmp_fragneeded_suppress_count);
+    dprintf(fd, "\n");
+    dprintf(fd, "【PATH MTU】\n");
+    dprintf(fd, "\n");
+    dprintf(fd, "   probe count\n");
+    dprintf(fd, "     probe send                      : %" PRIu64 " \n", statistics_info->pmtu_probe_send_count);
+    dprintf(fd, "     path mtu restore                : %" PRIu64 " \n", statistics_info->pmtu_probe_restore_count);
+    dprintf(fd, "\n");
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ステージ別サイクル計測結果出力関数
+//!
+//! カプセル化/デカプセル化スレッド毎に、転送処理の各ステージで
+//! 消費したサイクル数を引数で指定されたディスクリプタへ出力する。<br/>
+//! M46E_PROFILEを定義せずにビルドした場合は計測無効である旨を出力する。
+//!
+//! @param [in] statistics      統計情報用領域のポインタ
+//! @param [in] fd              出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_printf_statistics_profile(m46e_statistics_t* statistics, int fd)
+{
+#ifdef M46E_PROFILE
+    // ローカル変数宣言
+    const m46e_profile_t* profile;
+    const int    worker[] = { M46E_STATISTICS_WORKER_ENCAP, M46E_STATISTICS_WORKER_DECAP };
+    const char*  title[]  = { "encap(IPv4 -> IPv6)", "decap(IPv6 -> IPv4)" };
+    const char*  stage[M46E_PROFILE_STAGE_NUM] = {
+        "parse                 ",
+        "pr lookup             ",
+        "header build          ",
+        "pmtu lookup           ",
+        "fragment              ",
+        "write                 ",
+    };
+
+    dprintf(fd, "【PROFILE】\n");
+    dprintf(fd, "\n");
+    for(int i = 0; i < sizeof(worker) / sizeof(worker[0]); i++){
+        profile = &statistics->profile[worker[i]];
+
+        dprintf(fd, "   %s\n", title[i]);
+        dprintf(fd, "     stage                   count                cycles       cycles/packet\n");
+        for(int j = 0; j < M46E_PROFILE_STAGE_NUM; j++){
+            dprintf(fd, "     %s %20" PRIu64 " %20" PRIu64 " %18.1f\n",
+                stage[j], profile->count[j], profile->cycles[j],
+                (profile->count[j] != 0) ? (double)profile->cycles[j] / profile->count[j] : 0.0);
+        }
+        dprintf(fd, "\n");
+    }
+#else
+    dprintf(fd, "profiler is disabled. (rebuild with -DM46E_PROFILE to enable)\n");
+#endif
+
+    return;
+}
+
+//! 破棄理由の表示名
+static const char* statistics_drop_reason_name[M46E_DROP_REASON_NUM] = {
+    "v4 broadcast",
+    "v4 not IPv4 protocol",
+    "v4 link local multicast",
+    "v4 multicast(M46E-PR)",
+    "v4 M46E-PR table search failure",
+    "v4 fragment(M46E-AS)",
+    "v4 not tcp/udp(M46E-AS)",
+    "v4 send error",
+    "v6 broadcast",
+    "v6 not IPv6 protocol",
+    "v6 link local multicast",
+    "v6 ttl over",
+    "v6 invalid next header",
+    "v6 send error",
+    "invalid icmpv6 packet too big",
+    "v6 reassembly failure",
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄パケット記録関数
+//!
+//! 破棄したパケットを自スレッドの記録リングに記録する。<br/>
+//! drop_sample_rate件に1件の割合で、時刻、破棄理由、パケット先頭
+//! M46E_STATISTICS_DROP_DATA_LENバイトを記録する。(古い記録から上書き)
+//!
+//! @param [in] statistics 統計情報用領域のポインタ
+//! @param [in] reason     破棄理由(M46E_DROP_xxx)
+//! @param [in] packet     破棄したパケット(etherヘッダから)
+//! @param [in] len        破棄したパケットの長さ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_statistics_trace_drop(m46e_statistics_t* statistics, const int reason, const void* packet, const size_t len)
+{
+    // ローカル変数宣言
+    m46e_statistics_drop_ring_t* ring;
+    m46e_statistics_drop_t*      entry;
+    uint32_t                     rate;
+    uint64_t                     seq;
+    struct timespec              now;
+
+    // 引数チェック
+    if((statistics == NULL) || (packet == NULL) || (reason < 0) || (reason >= M46E_DROP_REASON_NUM)){
+        return;
+    }
+
+    rate = statistics->drop_sample_rate;
+    if(rate == 0){
+        return;
+    }
+
+    ring = &statistics->drops[m46e_statistics_worker];
+    if((__sync_fetch_and_add(&ring->sample_count, 1) % rate) != 0){
+        return;
+    }
+
+    // 記録番号を採番して書き込み先を確保
+    seq   = __sync_add_and_fetch(&ring->head, 1);
+    entry = &ring->entry[(seq - 1) % M46E_STATISTICS_DROP_RING];
+
+    // 書き込み中は記録番号を0にしておく
+    entry->seq = 0;
+    __sync_synchronize();
+
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    entry->time   = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    entry->reason = reason;
+    entry->len    = len;
+    memcpy(entry->data, packet, (len < M46E_STATISTICS_DROP_DATA_LEN) ? len : M46E_STATISTICS_DROP_DATA_LEN);
+
+    __sync_synchronize();
+    entry->seq = seq;
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄パケット記録出力関数
+//!
+//! カプセル化/デカプセル化スレッド毎の破棄パケット記録を、古い順に
+//! 引数で指定されたディスクリプタへ出力する。<br/>
+//! 出力中に上書きされた記録は出力しない。
+//!
+//! @param [in] statistics      統計情報用領域のポインタ
+//! @param [in] fd              出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_printf_statistics_drops(m46e_statistics_t* statistics, int fd)
+{
+    // ローカル変数宣言
+    m46e_statistics_drop_ring_t* ring;
+    m46e_statistics_drop_t*      entry;
+    m46e_statistics_drop_t       copy;
+    uint64_t                     head;
+    uint64_t                     seq;
+    time_t                       sec;
+    struct tm                    tm;
+    char                         timestr[32];
+    char                         line[16 * 3 + 1];
+    int                          line_len;
+    int                          data_len;
+    const int    worker[] = { M46E_STATISTICS_WORKER_ENCAP, M46E_STATISTICS_WORKER_DECAP, M46E_STATISTICS_WORKER_OTHER };
+    const char*  title[]  = { "encap(IPv4 -> IPv6)", "decap(IPv6 -> IPv4)", "other" };
+
+    dprintf(fd, "【DROPS】\n");
+    dprintf(fd, "\n");
+    dprintf(fd, "   sample rate                       : 1/%u\n", statistics->drop_sample_rate);
     dprintf(fd, "\n");
 
+    for(int i = 0; i < sizeof(worker) / sizeof(worker[0]); i++){
+        ring = &statistics->drops[worker[i]];
+        head = ring->head;
+
+        dprintf(fd, "   %s\n", title[i]);
+        dprintf(fd, "     recorded count                  : %" PRIu64 " \n", head);
+
+        seq = (head > M46E_STATISTICS_DROP_RING) ? (head - M46E_STATISTICS_DROP_RING + 1) : 1;
+        for(; seq <= head; seq++){
+            entry = &ring->entry[(seq - 1) % M46E_STATISTICS_DROP_RING];
+
+            // 記録番号が前後で一致しない場合は書き込み中または上書き済み
+            if(entry->seq != seq){
+                continue;
+            }
+            __sync_synchronize();
+            memcpy(&copy, entry, sizeof(copy));
+            __sync_synchronize();
+            if((entry->seq != seq) || (copy.reason < 0) || (copy.reason >= M46E_DROP_REASON_NUM)){
+                continue;
+            }
+
+            sec = copy.time / 1000000000;
+            localtime_r(&sec, &tm);
+            strftime(timestr, sizeof(timestr), "%Y/%m/%d %H:%M:%S", &tm);
+
+            dprintf(fd, "     [%" PRIu64 "] %s.%03u  %s  len=%u\n", seq, timestr,
+                (unsigned int)((copy.time % 1000000000) / 1000000),
+                statistics_drop_reason_name[copy.reason], copy.len);
+
+            // パケット先頭データを16バイト毎にダンプ
+            data_len = (copy.len < M46E_STATISTICS_DROP_DATA_LEN) ? copy.len : M46E_STATISTICS_DROP_DATA_LEN;
+            for(int j = 0; j < data_len; j += 16){
+                line_len = 0;
+                for(int k = j; (k < j + 16) && (k < data_len); k++){
+                    line_len += sprintf(&line[line_len], " %02x", copy.data[k]);
+                }
+                dprintf(fd, "       %04x:%s\n", j, line);
+            }
+        }
+        dprintf(fd, "\n");
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分通知開始関数
+//!
+//! 指定した間隔で統計情報の差分を通知するスレッドを起動する。<br/>
+//! 通知先ソケットは起動したスレッドが所有し、通知先の切断時に閉じる。
+//!
+//! @param [in] statistics 統計情報用領域のポインタ
+//! @param [in] fd         通知先ソケット
+//! @param [in] interval   通知間隔(秒)
+//! @param [in] json       JSON形式で通知するかどうか
+//!
+//! @retval true   起動成功
+//! @retval false  起動失敗(通知先ソケットは呼出元で閉じること)
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_statistics_start_watch(m46e_statistics_t* statistics, const int fd, const int interval, const bool json)
+{
+    // ローカル変数宣言
+    statistics_watch_arg* watch;
+    int                   slot = -1;
+    int                   ret;
+
+    // 引数チェック
+    if((statistics == NULL) || (fd < 0) || (interval <= 0)){
+        return false;
+    }
+
+    watch = (statistics_watch_arg*)malloc(sizeof(statistics_watch_arg));
+    if(watch == NULL){
+        m46e_logging(LOG_WARNING, "fail to allocate statistics watch data\n");
+        return false;
+    }
+    watch->statistics = statistics;
+    watch->fd         = fd;
+    watch->interval   = interval;
+    watch->json       = json;
+    watch->done       = false;
+
+    // 排他開始
+    pthread_mutex_lock(&statistics_watch_mutex);
+
+    if(statistics_watch_stopped){
+        pthread_mutex_unlock(&statistics_watch_mutex);
+        free(watch);
+        return false;
+    }
+
+    // 終了済みのスレッドをjoinして空きを探す
+    for(int i = 0; i < STATISTICS_WATCH_MAX; i++){
+        if((statistics_watch_list[i] != NULL) && statistics_watch_list[i]->done){
+            pthread_join(statistics_watch_list[i]->tid, NULL);
+            free(statistics_watch_list[i]);
+            statistics_watch_list[i] = NULL;
+        }
+        if((statistics_watch_list[i] == NULL) && (slot < 0)){
+            slot = i;
+        }
+    }
+    if(slot < 0){
+        pthread_mutex_unlock(&statistics_watch_mutex);
+        m46e_logging(LOG_WARNING, "too many statistics watch sessions\n");
+        free(watch);
+        return false;
+    }
+
+    // 停止時にjoinするのでjoin可能な状態で起動する
+    ret = pthread_create(&watch->tid, NULL, statistics_watch_thread, watch);
+    if(ret != 0){
+        pthread_mutex_unlock(&statistics_watch_mutex);
+        m46e_logging(LOG_WARNING, "fail to create statistics watch thread : %s\n", strerror(ret));
+        free(watch);
+        return false;
+    }
+    statistics_watch_list[slot] = watch;
+
+    // 排他解除
+    pthread_mutex_unlock(&statistics_watch_mutex);
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分通知停止関数
+//!
+//! 起動中の全ての差分通知スレッドを取り消し、終了を待ち合わせる。<br/>
+//! 以降の差分通知の開始は失敗する。
+//! 統計情報領域を解放する前に呼び出すこと。
+//!
+//! @param なし
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void m46e_statistics_stop_watch(void)
+{
+    // ローカル変数宣言
+    statistics_watch_arg* list[STATISTICS_WATCH_MAX];
+
+    // 排他開始
+    pthread_mutex_lock(&statistics_watch_mutex);
+
+    statistics_watch_stopped = true;
+    memcpy(list, statistics_watch_list, sizeof(list));
+    memset(statistics_watch_list, 0, sizeof(statistics_watch_list));
+
+    // 排他解除
+    // (スレッドの後処理で排他を獲得するので、joinの前に解除する)
+    pthread_mutex_unlock(&statistics_watch_mutex);
+
+    for(int i = 0; i < STATISTICS_WATCH_MAX; i++){
+        if(list[i] != NULL){
+            // 待ち合わせ中のスレッドはpollで取り消しを受け付ける
+            pthread_cancel(list[i]->tid);
+            pthread_join(list[i]->tid, NULL);
+            free(list[i]);
+        }
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分通知スレッド
+//!
+//! 通知間隔毎に前回からのカウンタの差分を1レコードとして送信する。
+//! 通知先の切断を検出した時点で終了する。
+//! (通知を待つ間も通知先ソケットを監視するので、切断は即座に検出する)
+//!
+//! @param [in] arg 差分通知スレッドの引数
+//!
+//! @return NULL固定
+///////////////////////////////////////////////////////////////////////////////
+static void* statistics_watch_thread(void* arg)
+{
+    // ローカル変数宣言
+    statistics_watch_arg*     watch = (statistics_watch_arg*)arg;
+    m46e_statistics_counter_t prev;
+    m46e_statistics_counter_t now;
+    m46e_statistics_counter_t delta;
+    struct timespec           prev_time;
+    struct timespec           now_time;
+    struct timespec           next;
+    double                    elapsed;
+    char                      buf[M46E_STAT_WATCH_RECORD_MAX];
+    int                       len;
+    int                       row;
+
+    // 終了時(取り消し時を含む)は通知先ソケットを閉じて終了済みにする
+    pthread_cleanup_push(statistics_watch_cleanup, watch);
+
+    while(!m46e_statistics_sum(watch->statistics, &prev)){
+        // 取得できるまで1秒毎にリトライ
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        next.tv_sec += 1;
+        if(!statistics_watch_wait(watch, &next)){
+            goto end;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &prev_time);
+    next = prev_time;
+    row  = 0;
+
+    while(1){
+        next.tv_sec += watch->interval;
+        if(!statistics_watch_wait(watch, &next)){
+            DEBUG_LOG("statistics watch end : peer closed\n");
+            break;
+        }
+
+        if(!m46e_statistics_sum(watch->statistics, &now)){
+            // 取得できない場合は今回の通知を見送り、次回にまとめて通知する
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now_time);
+        elapsed = (double)(now_time.tv_sec - prev_time.tv_sec) + (double)(now_time.tv_nsec - prev_time.tv_nsec) / 1000000000.0;
+
+        for(int i = 0; i < M46E_STATISTICS_COUNTER_NUM; i++){
+            ((uint64_t*)&delta)[i] = ((uint64_t*)&now)[i] - ((uint64_t*)&prev)[i];
+        }
+
+        len = statistics_watch_format(watch, &delta, elapsed, row++, buf, sizeof(buf));
+
+        // 1回分の差分を1レコードで送信する
+        if(send(watch->fd, buf, len, MSG_NOSIGNAL) < 0){
+            DEBUG_LOG("statistics watch end : %s\n", strerror(errno));
+            break;
+        }
+
+        // 大きく遅れた場合は待ち合わせの基準を現在時刻に合わせる
+        if(now_time.tv_sec > next.tv_sec){
+            next = now_time;
+        }
+        prev      = now;
+        prev_time = now_time;
+    }
+
+end:
+    pthread_cleanup_pop(1);
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分通知スレッド 後処理関数
+//!
+//! 通知先ソケットを閉じ、スレッドを終了済みにする。
+//! (引数の領域はスレッドをjoinした側で解放する)
+//!
+//! @param [in] arg 差分通知スレッドの引数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void statistics_watch_cleanup(void* arg)
+{
+    statistics_watch_arg* watch = (statistics_watch_arg*)arg;
+
+    close(watch->fd);
+
+    pthread_mutex_lock(&statistics_watch_mutex);
+    watch->done = true;
+    pthread_mutex_unlock(&statistics_watch_mutex);
+
     return;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分通知 待ち合わせ関数
+//!
+//! 指定時刻まで通知先ソケットを監視しながら待ち合わせる。<br/>
+//! 通知先からの受信データは読み捨てる。
+//! pollで待ち合わせるので、スレッドの取り消しは待ち合わせ中に受け付ける。
+//!
+//! @param [in] watch    差分通知スレッドの引数
+//! @param [in] deadline 待ち合わせる時刻(CLOCK_MONOTONIC)
+//!
+//! @retval true   指定時刻に到達した
+//! @retval false  通知先が切断した
+///////////////////////////////////////////////////////////////////////////////
+static bool statistics_watch_wait(statistics_watch_arg* watch, const struct timespec* deadline)
+{
+    // ローカル変数宣言
+    struct pollfd   pfd;
+    struct timespec now;
+    int64_t         timeout;
+    char            buf[256];
+    int             ret;
+
+    while(1){
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timeout = (int64_t)(deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+        if(timeout <= 0){
+            return true;
+        }
+
+        pfd.fd      = watch->fd;
+        pfd.events  = POLLIN | POLLRDHUP;
+        pfd.revents = 0;
+        ret = poll(&pfd, 1, (int)timeout);
+        if(ret < 0){
+            if(errno == EINTR){
+                // シグナル割り込みの場合は処理継続
+                continue;
+            }
+            m46e_logging(LOG_WARNING, "statistics watch poll error : %s\n", strerror(errno));
+            return false;
+        }
+        if(ret == 0){
+            continue;
+        }
+
+        if(pfd.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)){
+            return false;
+        }
+        if(pfd.revents & POLLIN){
+            // 受信データは読み捨て、0byte(切断)の場合は終了する
+            ret = recv(watch->fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if((ret == 0) || ((ret < 0) && (errno != EAGAIN) && (errno != EINTR))){
+                return false;
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分整形関数
+//!
+//! 表形式の場合は主要な合計値の差分を1行で、JSON形式の場合は
+//! 全カウンタの差分をカウンタ名テーブルの名前で1行に整形する。
+//!
+//! @param [in]  watch    差分通知スレッドの引数
+//! @param [in]  delta    前回からの差分
+//! @param [in]  elapsed  前回からの経過時間(秒)
+//! @param [in]  row      通知回数(表形式のヘッダ出力判定用)
+//! @param [out] buf      整形結果格納先
+//! @param [in]  size     整形結果格納先のサイズ
+//!
+//! @return 整形結果の長さ
+///////////////////////////////////////////////////////////////////////////////
+static int statistics_watch_format(
+    statistics_watch_arg*      watch,
+    m46e_statistics_counter_t* delta,
+    const double               elapsed,
+    const int                  row,
+    char*                      buf,
+    const size_t               size
+)
+{
+    // ローカル変数宣言
+    m46e_statistics_header_t* header = &watch->statistics->header;
+    struct timespec           now;
+    struct tm                 tm;
+    int                       len = 0;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    if(watch->json){
+        len += snprintf(&buf[len], size - len, "{\"time\":%ld.%03ld,\"interval\":%.3f,\"delta\":{",
+            (long)now.tv_sec, now.tv_nsec / 1000000, elapsed);
+        for(int i = 0; (i < header->counter_num) && (len < size); i++){
+            len += snprintf(&buf[len], size - len, "%s\"%s\":%" PRIu64, (i == 0) ? "" : ",",
+                header->name[i].name, *(uint64_t*)((char*)delta + header->name[i].offset));
+        }
+        if(len < size){
+            len += snprintf(&buf[len], size - len, "}}\n");
+        }
+    }
+    else{
+        if((row % STATISTICS_WATCH_HEADER_INTERVAL) == 0){
+            len += snprintf(&buf[len], size - len, "%8s %12s %12s %12s %12s %10s %10s\n",
+                "time", "v4-recv", "v4-send", "v6-recv", "v6-send", "drop", "error");
+        }
+        localtime_r(&now.tv_sec, &tm);
+        len += snprintf(&buf[len], size - len,
+            "%02d:%02d:%02d %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+            tm.tm_hour, tm.tm_min, tm.tm_sec,
+            delta->tunnel_v4_recieve_count, delta->tunnel_v4_send_count,
+            delta->tunnel_v6_recieve_count, delta->tunnel_v6_send_count,
+            statistics_get_total_drop(delta), statistics_get_total_error(delta));
+    }
+
+    // 切り詰めた場合は格納先のサイズに合わせる
+    return min(len, (int)size - 1);
+}
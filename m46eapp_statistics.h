@@ -5,6 +5,19 @@
 /*              2012.07.23 T.Maeda Phase4向けに全面改版                       */
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent Packet Too Big重複抑止追加                   */
+/*              2026.10.18 agent Packet Too Big妥当性検証追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
+/*              2026.10.18 agent 統計情報のスレッド毎カウンタ化               */
+/*              2026.10.18 agent 統計情報のバイト数/レート追加                */
+/*              2026.10.18 agent 遅延ヒストグラム追加                         */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent OpenMetrics出力追加                          */
+/*              2026.10.18 agent 統計情報領域のseqlock化                      */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
+/*              2026.10.18 agent Fragment Needed送信の流量制限                */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -12,251 +25,749 @@
 #define __M46EAPP_STATISTICS_H__
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "m46eapp_profile.h"
+
+//! 統計情報カウンタ領域のアライメント(キャッシュラインサイズ)
+#define M46E_STATISTICS_ALIGN   64
 
 ////////////////////////////////////////////////////////////////////////////////
-//! 仮想デバイス統計情報 構造体
+//! 統計情報カウンタ更新スレッド種別
+//! (スレッド毎に専用のカウンタ領域を更新する)
 ////////////////////////////////////////////////////////////////////////////////
-typedef struct _m46e_statistics_t
+enum m46e_statistics_worker
 {
-    //! 共有メモリID
-    int shm_id;
+    M46E_STATISTICS_WORKER_OTHER = 0, ///< その他(タイマスレッドなど)
+    M46E_STATISTICS_WORKER_ENCAP,     ///< カプセル化スレッド(Stub側)
+    M46E_STATISTICS_WORKER_DECAP,     ///< デカプセル化スレッド(Backbone側)
+    M46E_STATISTICS_WORKER_NUM        ///< スレッド種別数
+};
 
+////////////////////////////////////////////////////////////////////////////////
+//! 統計情報カウンタ 構造体
+//! (メンバは全てuint64_tのカウンタとすること。集計時は配列として加算する)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_counter_t
+{
     ////////////////////////////////////////////////////////////////////////////
     // ICMP関連
     ////////////////////////////////////////////////////////////////////////////
     //! ICMP Err too big(v6)受信数
-    uint32_t icmp_pkt_toobig_recv_count;
+    uint64_t icmp_pkt_toobig_recv_count;
+    //! ICMP Err too big(v6)重複による通知抑止数
+    uint64_t icmp_pkt_toobig_suppress_count;
+    //! ICMP Err too big(v6)不正による破棄数
+    uint64_t icmp_pkt_toobig_invalid_count;
     //! ICMP Err fragment needed(v4)送信数
-    uint32_t icmp_fragneeded_send_count;
+    uint64_t icmp_fragneeded_send_count;
     //! ICMP Err fragment needed(v4)送信成功数
-    uint32_t icmp_fragneeded_send_success_count;
+    uint64_t icmp_fragneeded_send_success_count;
     //! ICMP Err fragment needed(v4)送信失敗数
-    uint32_t icmp_fragneeded_send_err_count;
+    uint64_t icmp_fragneeded_send_err_count;
+    //! ICMP Err fragment needed(v4)送信レート制限による抑止数
+    uint64_t icmp_fragneeded_suppress_count;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Path MTU関連
+    ////////////////////////////////////////////////////////////////////////////
+    //! PMTU拡大プローブ送信数
+    uint64_t pmtu_probe_send_count;
+    //! PMTU拡大プローブ成功によるPMTU拡大数
+    uint64_t pmtu_probe_restore_count;
 
     ////////////////////////////////////////////////////////////////////////////
     // IPv4トンネル関連
     ////////////////////////////////////////////////////////////////////////////
     //! IPv4パケット受信数
-    uint32_t tunnel_v4_recieve_count;
+    uint64_t tunnel_v4_recieve_count;
+    //! IPv4パケット受信バイト数
+    uint64_t tunnel_v4_recieve_bytes;
     //! IPv4ユニキャストパケット受信数
-    uint32_t tunnel_v4_recv_unicast_count;
+    uint64_t tunnel_v4_recv_unicast_count;
+    //! IPv4ユニキャストパケット受信バイト数
+    uint64_t tunnel_v4_recv_unicast_bytes;
     //! IPv4マルチキャストパケット受信数
-    uint32_t tunnel_v4_recv_multicast_count;
+    uint64_t tunnel_v4_recv_multicast_count;
+    //! IPv4マルチキャストパケット受信バイト数
+    uint64_t tunnel_v4_recv_multicast_bytes;
     //! カプセル化パケット送信数
-    uint32_t tunnel_v4_send_count;
+    uint64_t tunnel_v4_send_count;
+    //! カプセル化パケット送信バイト数(送信成功分)
+    uint64_t tunnel_v4_send_bytes;
     //! カプセル化パケット送信成功数
-    uint32_t tunnel_v4_send_v6_success_count;
+    uint64_t tunnel_v4_send_v6_success_count;
+    //! カプセル化パケット送信成功バイト数
+    uint64_t tunnel_v4_send_v6_success_bytes;
     //! カプセル化パケット送信失敗数
-    uint32_t tunnel_v4_send_v6_err_count;
+    uint64_t tunnel_v4_send_v6_err_count;
     //! カプセル化(フラグメント有)パケット送信数
-    uint32_t tunnel_v4_send_fragneed_count;
+    uint64_t tunnel_v4_send_fragneed_count;
     //! カプセル化(フラグメント有)パケット送信成功数
-    uint32_t tunnel_v4_send_fragment_success_count;
+    uint64_t tunnel_v4_send_fragment_success_count;
+    //! カプセル化(フラグメント有)パケット送信成功バイト数
+    uint64_t tunnel_v4_send_fragment_success_bytes;
     //! カプセル化(フラグメント有)パケット送信失敗数
-    uint32_t tunnel_v4_send_fragment_err_count;
+    uint64_t tunnel_v4_send_fragment_err_count;
     //! ブロードキャストパケット受信数
-    uint32_t tunnel_v4_err_broadcast_count;
+    uint64_t tunnel_v4_err_broadcast_count;
     //! IPv4以外のプロトコルパケット受信数
-    uint32_t tunnel_v4_err_other_proto_count;
+    uint64_t tunnel_v4_err_other_proto_count;
     //! リンクローカルのマルチキャストパケット受信数
-    uint32_t tunnel_v4_err_linklocal_multi_count;
+    uint64_t tunnel_v4_err_linklocal_multi_count;
     //! M46E-ASモードでのTCP/UDP以外のパケット受信数
-    uint32_t tunnel_v4_err_as_not_support_proto_count;
+    uint64_t tunnel_v4_err_as_not_support_proto_count;
     //! M46E-ASモードでのフラグメントパケット受信数
-    uint32_t tunnel_v4_err_as_fragment_count;
+    uint64_t tunnel_v4_err_as_fragment_count;
     //! M46E-PRモードでのM46E-PR Tableの検索失敗数
-    uint32_t tunnel_v4_err_pr_search_failure_count;
+    uint64_t tunnel_v4_err_pr_search_failure_count;
     //! M46E-PRモードでのIPv4マルチキャストパケット受信数
-    uint32_t tunnel_v4_err_pr_multi_count;
+    uint64_t tunnel_v4_err_pr_multi_count;
 
     ////////////////////////////////////////////////////////////////////////////
     // IPv6トンネル関連
     ////////////////////////////////////////////////////////////////////////////
     //! IPv6パケット受信数
-    uint32_t tunnel_v6_recieve_count;
+    uint64_t tunnel_v6_recieve_count;
+    //! IPv6パケット受信バイト数
+    uint64_t tunnel_v6_recieve_bytes;
     //! IPv4ユニキャストパケット(デカプセル化後)受信数
-    uint32_t tunnel_v6_recv_unicast_count;
+    uint64_t tunnel_v6_recv_unicast_count;
+    //! IPv4ユニキャストパケット(デカプセル化後)受信バイト数
+    uint64_t tunnel_v6_recv_unicast_bytes;
     //! IPv4マルチキャストパケット(デカプセル化後)受信数
-    uint32_t tunnel_v6_recv_multicast_count;
+    uint64_t tunnel_v6_recv_multicast_count;
+    //! IPv4マルチキャストパケット(デカプセル化後)受信バイト数
+    uint64_t tunnel_v6_recv_multicast_bytes;
     //! デカプセル化パケット送信数
-    uint32_t tunnel_v6_send_count;
+    uint64_t tunnel_v6_send_count;
+    //! デカプセル化パケット送信バイト数(送信成功分)
+    uint64_t tunnel_v6_send_bytes;
     //! デカプセル化パケット送信成功数
-    uint32_t tunnel_v6_send_v4_success_count;
+    uint64_t tunnel_v6_send_v4_success_count;
+    //! デカプセル化パケット送信成功バイト数
+    uint64_t tunnel_v6_send_v4_success_bytes;
     //! デカプセル化パケット送信失敗数
-    uint32_t tunnel_v6_send_v4_err_count;
+    uint64_t tunnel_v6_send_v4_err_count;
     //! ブロードキャストパケット受信数
-    uint32_t tunnel_v6_err_broadcast_count;
+    uint64_t tunnel_v6_err_broadcast_count;
     //! TTL超過パケット(デカプセル化後)受信数
-    uint32_t tunnel_v6_err_ttl_count;
+    uint64_t tunnel_v6_err_ttl_count;
     //! IPv6以外のプロトコルパケット受信数
-    uint32_t tunnel_v6_err_other_proto_count;
+    uint64_t tunnel_v6_err_other_proto_count;
     //! リンクローカルのマルチキャストパケット(デカプセル化後)受信数
-    uint32_t tunnel_v6_err_linklocal_multi_count;
+    uint64_t tunnel_v6_err_linklocal_multi_count;
     //! NextHeaderがIPIP以外のパケット受信数
-    uint32_t tunnel_v6_err_nxthdr_count;
+    uint64_t tunnel_v6_err_nxthdr_count;
+    //! IPv6フラグメント受信数
+    uint64_t tunnel_v6_reasm_fragment_count;
+    //! IPv6フラグメント再構築成功数
+    uint64_t tunnel_v6_reasm_success_count;
+    //! IPv6フラグメント再構築タイムアウト数
+    uint64_t tunnel_v6_reasm_timeout_count;
+    //! 不正または上限超過により破棄したIPv6フラグメント数
+    uint64_t tunnel_v6_err_reasm_count;
+
+} __attribute__((aligned(M46E_STATISTICS_ALIGN))) m46e_statistics_counter_t;
+
+//! 転送レート算出用スナップショットの保持数(1秒毎)
+#define M46E_STATISTICS_RATE_RING   60
+
+////////////////////////////////////////////////////////////////////////////////
+//! 転送レート算出対象
+////////////////////////////////////////////////////////////////////////////////
+enum m46e_statistics_rate_dir
+{
+    M46E_STATISTICS_RATE_V4_RECV = 0, ///< IPv4パケット受信(カプセル化前)
+    M46E_STATISTICS_RATE_V4_SEND,     ///< カプセル化パケット送信
+    M46E_STATISTICS_RATE_V6_RECV,     ///< IPv6パケット受信(デカプセル化前)
+    M46E_STATISTICS_RATE_V6_SEND,     ///< デカプセル化パケット送信
+    M46E_STATISTICS_RATE_DIR_NUM      ///< 算出対象数
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! 転送レート 構造体(1秒あたりのパケット数/バイト数)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_sample_t
+{
+    uint64_t pps[M46E_STATISTICS_RATE_DIR_NUM];  ///< パケット数/秒
+    uint64_t bps[M46E_STATISTICS_RATE_DIR_NUM];  ///< ビット数/秒
+} m46e_statistics_sample_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 転送レート管理 構造体
+//! (レート算出スレッドのみが更新する)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_rate_t
+{
+    uint32_t                 head;   ///< 次に書き込むスナップショットの位置
+    uint32_t                 num;    ///< 保持しているスナップショット数
+    m46e_statistics_sample_t sample[M46E_STATISTICS_RATE_RING]; ///< 1秒毎のスナップショット
+    m46e_statistics_sample_t peak;   ///< 起動後の最大値
+} m46e_statistics_rate_t;
+
+//! 処理時間ヒストグラムの2のべき乗区間あたりの分割数(ビット数)
+#define M46E_STATISTICS_LATENCY_SUB_BITS    3
+//! 処理時間ヒストグラムの2のべき乗区間あたりの分割数
+#define M46E_STATISTICS_LATENCY_SUB_NUM     (1 << M46E_STATISTICS_LATENCY_SUB_BITS)
+//! 処理時間ヒストグラムで区別する最大値のビット数(2^32ns以上は最終区間に集約)
+#define M46E_STATISTICS_LATENCY_MAX_BITS    32
+//! 処理時間ヒストグラムの区間数
+#define M46E_STATISTICS_LATENCY_BUCKET_NUM  \
+    ((M46E_STATISTICS_LATENCY_MAX_BITS - M46E_STATISTICS_LATENCY_SUB_BITS + 1) * M46E_STATISTICS_LATENCY_SUB_NUM)
+
+////////////////////////////////////////////////////////////////////////////////
+//! 処理時間ヒストグラム 構造体
+//! (2のべき乗区間毎にM46E_STATISTICS_LATENCY_SUB_NUM分割した対数区間で記録する。
+//!  各区間の相対誤差は1/M46E_STATISTICS_LATENCY_SUB_NUM以下)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_latency_t
+{
+    uint64_t count;                                        ///< 計測回数
+    uint64_t sum;                                          ///< 処理時間の合計(ns)
+    uint64_t max;                                          ///< 処理時間の最大値(ns)
+    uint64_t bucket[M46E_STATISTICS_LATENCY_BUCKET_NUM];  ///< 区間毎の計測回数
+} __attribute__((aligned(M46E_STATISTICS_ALIGN))) m46e_statistics_latency_t;
+
+//! 破棄パケット記録リングの保持数(スレッド種別毎)
+#define M46E_STATISTICS_DROP_RING       64
+//! 破棄パケット記録で保持するパケット先頭からのバイト数
+#define M46E_STATISTICS_DROP_DATA_LEN   64
+
+////////////////////////////////////////////////////////////////////////////////
+//! パケット破棄理由
+////////////////////////////////////////////////////////////////////////////////
+enum m46e_statistics_drop_reason
+{
+    M46E_DROP_V4_BROADCAST = 0,        ///< IPv4側 ブロードキャスト
+    M46E_DROP_V4_OTHER_PROTO,          ///< IPv4側 IPv4以外のプロトコル
+    M46E_DROP_V4_LINKLOCAL_MULTI,      ///< IPv4側 リンクローカルマルチキャスト
+    M46E_DROP_V4_PR_MULTI,             ///< IPv4側 M46E-PRモードでのマルチキャスト
+    M46E_DROP_V4_PR_SEARCH_FAILURE,    ///< IPv4側 M46E-PRテーブル検索失敗
+    M46E_DROP_V4_AS_FRAGMENT,          ///< IPv4側 M46E-ASモードでのフラグメント
+    M46E_DROP_V4_AS_NOT_SUPPORT_PROTO, ///< IPv4側 M46E-ASモードでのTCP/UDP以外
+    M46E_DROP_V4_SEND_ERR,             ///< カプセル化パケット送信失敗
+    M46E_DROP_V6_BROADCAST,            ///< IPv6側 ブロードキャスト
+    M46E_DROP_V6_OTHER_PROTO,          ///< IPv6側 IPv6以外のプロトコル
+    M46E_DROP_V6_LINKLOCAL_MULTI,      ///< IPv6側 リンクローカルマルチキャスト
+    M46E_DROP_V6_TTL,                  ///< IPv6側 TTL超過
+    M46E_DROP_V6_NXTHDR,               ///< IPv6側 次ヘッダがIPIP以外
+    M46E_DROP_V6_SEND_ERR,             ///< デカプセル化パケット送信失敗
+    M46E_DROP_PTB_INVALID,             ///< 不正なICMPv6 Packet Too Big
+    M46E_DROP_V6_REASM,                ///< IPv6側 フラグメント再構築失敗
+    M46E_DROP_REASON_NUM               ///< 破棄理由数
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! 破棄パケット記録 構造体
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_drop_t
+{
+    volatile uint64_t seq;    ///< 記録番号(1～)。書き込み中と未使用は0
+    uint64_t time;            ///< 記録時刻(エポックからのナノ秒)
+    int32_t  reason;          ///< 破棄理由
+    uint32_t len;             ///< 元のパケット長
+    uint8_t  data[M46E_STATISTICS_DROP_DATA_LEN]; ///< パケット先頭データ
+} m46e_statistics_drop_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 破棄パケット記録リング 構造体
+//! (書き込みはロックせずに記録番号で領域を確保し、
+//!  参照側は記録番号の前後一致で書き込み中の記録を読み飛ばす)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_drop_ring_t
+{
+    uint64_t               head;          ///< 記録済みの件数
+    uint64_t               sample_count;  ///< サンプリング判定用の破棄件数
+    m46e_statistics_drop_t entry[M46E_STATISTICS_DROP_RING]; ///< 記録
+} __attribute__((aligned(M46E_STATISTICS_ALIGN))) m46e_statistics_drop_ring_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 統計情報領域のレイアウト
+//
+// 統計情報領域は /dev/shm/m46e_stat_<plane_name> に作成し、外部の収集
+// プロセスはデーモンと通信せずに読み取り専用でmmapして参照できる。
+// 領域の先頭には以下のヘッダを置き、カウンタ名とオフセットを格納する。
+//
+//  - magic/versionが一致しない場合は読み取らないこと。
+//  - スレッド種別毎のカウンタはcounter_offsetからcounter_strideおきに
+//    worker_num個並ぶ。各カウンタの位置はname[]のoffsetで示す。
+//  - スレッド種別毎の世代番号(seqlock)はseq_offsetからseq_strideおきに
+//    worker_num個並ぶ。書き込み中は奇数となるので、読み取り前後で
+//    偶数かつ同じ値であれば整合の取れたスナップショットとなる。
+////////////////////////////////////////////////////////////////////////////////
+
+//! 統計情報領域の識別子("M46S")
+#define M46E_STATISTICS_MAGIC        0x5336344d
+//! 統計情報領域のレイアウト版数(レイアウト変更時に更新すること)
+#define M46E_STATISTICS_VERSION      1
+//! カウンタ名の最大長(終端文字含む)
+#define M46E_STATISTICS_NAME_LEN     48
+//! カウンタ数
+#define M46E_STATISTICS_COUNTER_NUM  (sizeof(m46e_statistics_counter_t) / sizeof(uint64_t))
+
+////////////////////////////////////////////////////////////////////////////////
+//! カウンタ名テーブル エントリ 構造体
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_name_t
+{
+    char     name[M46E_STATISTICS_NAME_LEN]; ///< カウンタ名
+    uint32_t offset;                         ///< カウンタ領域先頭からのオフセット
+    uint32_t reserved;                       ///< 予約
+} m46e_statistics_name_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 統計情報領域ヘッダ 構造体
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_header_t
+{
+    uint32_t magic;           ///< 識別子(M46E_STATISTICS_MAGIC)
+    uint32_t version;         ///< レイアウト版数(M46E_STATISTICS_VERSION)
+    uint32_t header_size;     ///< ヘッダサイズ
+    uint32_t total_size;      ///< 統計情報領域全体のサイズ
+    uint32_t worker_num;      ///< スレッド種別数
+    uint32_t counter_num;     ///< カウンタ数(カウンタ名テーブルのエントリ数)
+    uint32_t counter_offset;  ///< 先頭のカウンタ領域のオフセット
+    uint32_t counter_stride;  ///< カウンタ領域の間隔
+    uint32_t seq_offset;      ///< 先頭の世代番号のオフセット
+    uint32_t seq_stride;      ///< 世代番号の間隔
+    m46e_statistics_name_t name[M46E_STATISTICS_COUNTER_NUM]; ///< カウンタ名テーブル
+} m46e_statistics_header_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! カウンタ領域の世代番号 構造体
+//! (書き込むスレッドが1つのカウンタ領域のみ更新する。
+//!  その他のスレッドが更新する領域は世代番号を更新しない)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_seq_t
+{
+    uint64_t seq;             ///< 世代番号(書き込み中は奇数)
+} __attribute__((aligned(M46E_STATISTICS_ALIGN))) m46e_statistics_seq_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! 仮想デバイス統計情報 構造体
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _m46e_statistics_t
+{
+    //! 統計情報領域ヘッダ
+    m46e_statistics_header_t header;
+
+    //! スレッド種別毎のカウンタ領域の世代番号
+    m46e_statistics_seq_t seq[M46E_STATISTICS_WORKER_NUM];
+
+    //! スレッド種別毎のカウンタ
+    m46e_statistics_counter_t worker[M46E_STATISTICS_WORKER_NUM];
+
+    //! 転送レート
+    m46e_statistics_rate_t rate;
+
+    //! スレッド種別毎の処理時間ヒストグラム
+    m46e_statistics_latency_t latency[M46E_STATISTICS_WORKER_NUM];
+
+    //! 破棄パケットを記録する間隔(0は記録なし)
+    uint32_t drop_sample_rate;
+
+    //! スレッド種別毎の破棄パケット記録
+    m46e_statistics_drop_ring_t drops[M46E_STATISTICS_WORKER_NUM];
+
+    //! M46E-PRテーブルのエントリ数(Stub側で更新)
+    uint32_t pr_entry_num;
+
+    //! PMTUテーブルのエントリ数(Stub側で更新)
+    uint32_t pmtu_entry_num;
+
+#ifdef M46E_PROFILE
+    //! スレッド種別毎のステージ別サイクル計測結果
+    m46e_profile_t profile[M46E_STATISTICS_WORKER_NUM];
+#endif
 
 } m46e_statistics_t;
 
+//! 自スレッドのカウンタ種別
+extern __thread int m46e_statistics_worker;
+
+//! 自スレッドが更新するカウンタ領域
+#define M46E_STATISTICS_LOCAL(statistics) (&(statistics)->worker[m46e_statistics_worker])
+
+#ifdef M46E_PROFILE
+//! 自スレッドが更新するサイクル計測結果
+#define M46E_STATISTICS_PROFILE(statistics) (&(statistics)->profile[m46e_statistics_worker])
+#endif
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ
 ///////////////////////////////////////////////////////////////////////////////
-m46e_statistics_t* m46e_initial_statistics(const char* key_path);
+m46e_statistics_t* m46e_initial_statistics(const char* plane_name);
 void m46e_finish_statistics(m46e_statistics_t* statistics_info);
+void m46e_statistics_set_worker(const int worker);
+bool m46e_statistics_snapshot(m46e_statistics_t* statistics, const int worker, m46e_statistics_counter_t* counter);
+bool m46e_statistics_sum(m46e_statistics_t* statistics, m46e_statistics_counter_t* total);
+void* m46e_statistics_rate_thread(void* arg);
+uint64_t m46e_statistics_latency_percentile(const m46e_statistics_latency_t* latency, const double percent);
 void m46e_printf_statistics_info_normal(m46e_statistics_t* statistics, int fd);
 void m46e_printf_statistics_info_as(m46e_statistics_t* statistics, int fd);
 void m46e_printf_statistics_info_pr(m46e_statistics_t* statistics, int fd);
+void m46e_printf_statistics_profile(m46e_statistics_t* statistics, int fd);
+void m46e_statistics_trace_drop(m46e_statistics_t* statistics, const int reason, const void* packet, const size_t len);
+void m46e_printf_statistics_drops(m46e_statistics_t* statistics, int fd);
+bool m46e_statistics_start_watch(m46e_statistics_t* statistics, const int fd, const int interval, const bool json);
+void m46e_statistics_stop_watch(void);
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // カウントアップ用の関数はinlineで定義する
 ///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief カウンタ領域書き込み開始関数
+//!
+//! 自スレッドのカウンタ領域の世代番号を奇数にする。<br/>
+//! カウントアップ用の関数の中でカウンタ更新の前後のみ
+//! m46e_statistics_write_endと対で呼び出す。
+//! (送信処理などを挟むと読み出し側が待たされるため、範囲を広げないこと)<br/>
+//! 複数のスレッドが更新するその他のカウンタ領域は世代番号を更新しない。
+//!
+//! @param [in] statistics 統計情報用領域のポインタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+inline void m46e_statistics_write_begin(m46e_statistics_t* statistics)
+{
+    if(m46e_statistics_worker == M46E_STATISTICS_WORKER_OTHER){
+        return;
+    }
+
+    m46e_statistics_seq_t* gen = &statistics->seq[m46e_statistics_worker];
+
+    __atomic_store_n(&gen->seq, gen->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief カウンタ領域書き込み終了関数
+//!
+//! 自スレッドのカウンタ領域の世代番号を偶数に戻す。
+//!
+//! @param [in] statistics 統計情報用領域のポインタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+inline void m46e_statistics_write_end(m46e_statistics_t* statistics)
+{
+    if(m46e_statistics_worker == M46E_STATISTICS_WORKER_OTHER){
+        return;
+    }
+
+    m46e_statistics_seq_t* gen = &statistics->seq[m46e_statistics_worker];
+
+    __atomic_store_n(&gen->seq, gen->seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline void m46e_add_latency(m46e_statistics_t* statistics, const uint64_t nsec)
+{
+    m46e_statistics_latency_t* latency = &statistics->latency[m46e_statistics_worker];
+    int                        index;
+
+    if(nsec < M46E_STATISTICS_LATENCY_SUB_NUM){
+        index = nsec;
+    }
+    else if(nsec >= (1ULL << M46E_STATISTICS_LATENCY_MAX_BITS)){
+        index = M46E_STATISTICS_LATENCY_BUCKET_NUM - 1;
+    }
+    else{
+        // 最上位ビットの位置で区間を、続くSUB_BITSビットで区間内の位置を決める
+        int shift = 63 - __builtin_clzll(nsec) - M46E_STATISTICS_LATENCY_SUB_BITS;
+        index = ((shift + 1) << M46E_STATISTICS_LATENCY_SUB_BITS)
+              + ((nsec >> shift) & (M46E_STATISTICS_LATENCY_SUB_NUM - 1));
+    }
+
+    latency->count++;
+    latency->sum += nsec;
+    latency->bucket[index]++;
+    if(nsec > latency->max){
+        latency->max = nsec;
+    }
+}
+
 inline void m46e_inc_icmp_pkt_toobig_recieve(m46e_statistics_t* statistics)
 {
-    statistics->icmp_pkt_toobig_recv_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->icmp_pkt_toobig_recv_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_icmp_pkt_toobig_suppress(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->icmp_pkt_toobig_suppress_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_icmp_pkt_toobig_invalid(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->icmp_pkt_toobig_invalid_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_icmp_frag_needed_send_success(m46e_statistics_t* statistics)
 {
-    statistics->icmp_fragneeded_send_count++;
-    statistics->icmp_fragneeded_send_success_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->icmp_fragneeded_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->icmp_fragneeded_send_success_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_icmp_frag_needed_send_err(m46e_statistics_t* statistics)
 {
-    statistics->icmp_fragneeded_send_count++;
-    statistics->icmp_fragneeded_send_err_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->icmp_fragneeded_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->icmp_fragneeded_send_err_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_icmp_frag_needed_suppress(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->icmp_fragneeded_suppress_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_pmtu_probe_send(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->pmtu_probe_send_count++;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v4_recieve(m46e_statistics_t* statistics)
+inline void m46e_inc_pmtu_probe_restore(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_recieve_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->pmtu_probe_restore_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_tunnel_v4_recieve(m46e_statistics_t* statistics, const uint64_t bytes)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_recieve_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_recieve_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_broadcast(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_broadcast_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_broadcast_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_other_proto(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_other_proto_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_other_proto_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_linklocal_multi(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_linklocal_multi_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_linklocal_multi_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_as_fragment(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_as_fragment_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_as_fragment_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_as_not_support_proto(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_as_not_support_proto_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_as_not_support_proto_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_send_v6_err_count(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_send_v6_err_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_v6_err_count++;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v4_recv_multicast(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v4_recv_multicast(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v4_recv_multicast_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_recv_multicast_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_recv_multicast_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v4_recv_unicast(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v4_recv_unicast(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v4_recv_unicast_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_recv_unicast_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_recv_unicast_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v4_send_success(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v4_send_success(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v4_send_count++;
-    statistics->tunnel_v4_send_v6_success_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_bytes += bytes;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_v6_success_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_v6_success_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_send_err(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_send_count++;
-    statistics->tunnel_v4_send_v6_err_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_v6_err_count++;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v4_send_fragment_success(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v4_send_fragment_success(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v4_send_count++;
-    statistics->tunnel_v4_send_fragment_success_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_bytes += bytes;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_fragment_success_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_fragment_success_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_send_fragment_err(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_send_count++;
-    statistics->tunnel_v4_send_fragment_err_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_send_fragment_err_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_pr_search_failure(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_pr_search_failure_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_pr_search_failure_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v4_err_pr_multi(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v4_err_pr_multi_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v4_err_pr_multi_count++;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v6_recieve(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v6_recieve(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v6_recieve_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_recieve_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_recieve_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v6_err_broadcast(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v6_err_broadcast_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_err_broadcast_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v6_err_ttl(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v6_err_ttl_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_err_ttl_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v6_err_other_proto(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v6_err_other_proto_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_err_other_proto_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v6_err_linklocal_multi(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v6_err_linklocal_multi_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_err_linklocal_multi_count++;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v6_send_v4_err(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v6_send_count++;
-    statistics->tunnel_v6_send_v4_err_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_send_v4_err_count++;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v6_send_v4_success(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v6_send_v4_success(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v6_send_count++;
-    statistics->tunnel_v6_send_v4_success_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_send_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_send_bytes += bytes;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_send_v4_success_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_send_v4_success_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
 inline void m46e_inc_tunnel_v6_err_nxthdr_count(m46e_statistics_t* statistics)
 {
-    statistics->tunnel_v6_err_nxthdr_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_err_nxthdr_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_tunnel_v6_reasm_fragment(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_reasm_fragment_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_tunnel_v6_reasm_success(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_reasm_success_count++;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_add_tunnel_v6_reasm_timeout(m46e_statistics_t* statistics, const uint64_t count)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_reasm_timeout_count += count;
+    m46e_statistics_write_end(statistics);
+};
+
+inline void m46e_inc_tunnel_v6_err_reasm(m46e_statistics_t* statistics)
+{
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_err_reasm_count++;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v6_recv_multicast(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v6_recv_multicast(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v6_recv_multicast_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_recv_multicast_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_recv_multicast_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
-inline void m46e_inc_tunnel_v6_recv_unicast(m46e_statistics_t* statistics)
+inline void m46e_inc_tunnel_v6_recv_unicast(m46e_statistics_t* statistics, const uint64_t bytes)
 {
-    statistics->tunnel_v6_recv_unicast_count++;
+    m46e_statistics_write_begin(statistics);
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_recv_unicast_count++;
+    M46E_STATISTICS_LOCAL(statistics)->tunnel_v6_recv_unicast_bytes += bytes;
+    m46e_statistics_write_end(statistics);
 };
 
 
@@ -6,6 +6,8 @@
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2013.12.02 Y.Shibata 経路同期機能追加                         */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent プレフィックス毎PMTU保持追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -224,13 +226,19 @@ static int stub_nw_start(void* data)
     // Path MTU管理の起動
     handler->pmtud_handler = m46e_init_pmtud(
         handler->conf->pmtud,
-        handler->conf->tunnel->ipv6.mtu
+        handler->conf->tunnel->ipv6.mtu,
+        handler->stat_info
     );
     if(handler->pmtud_handler == NULL){
         m46e_logging(LOG_ERR, "fail to create Path MTU Discovery table\n");
         _exit(-1);
     }
 
+    // M46E-PRモードの場合はプレフィックス毎の保持用にM46E-PR tableを設定
+    if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_PR){
+        m46e_pmtud_set_pr_table(handler->pmtud_handler, handler->pr_handler);
+    }
+
     // Stub側のスタートアップスクリプト実行
     m46e_stub_startup_script(handler);
 
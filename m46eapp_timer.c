@@ -4,19 +4,20 @@
 /* 修正履歴   : 2012.02.22 S.Yoshikawa 新規作成                               */
 /*              2012.08.08 T.Maeda Phase4向けに全面改版                       */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent タイマホイール化                             */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
 
 #include <errno.h>
-#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
-#include <pthread.h> 
+#include <pthread.h>
 #include <time.h>
 
-#include "m46eapp_list.h"
 #include "m46eapp_timer.h"
 #include "m46eapp_log.h"
 
@@ -27,15 +28,46 @@
 #define _D_(x)
 #endif
 
+//! タイマホイールの階層数
+#define TIMER_WHEEL_LEVEL       4
+//! タイマホイール1階層あたりのスロット数のビット数
+#define TIMER_WHEEL_BITS        6
+//! タイマホイール1階層あたりのスロット数
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_BITS)
+//! タイマホイールのスロット番号マスク
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SLOTS - 1)
+//! 登録可能な最大タイムアウト時間(秒)
+#define TIMER_WHEEL_MAX_EXPIRE  ((1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVEL)) - 1)
+
+//! タイマ管理データの初期確保数
+#define TIMER_ITEM_INIT_NUM     64
+
+//! リスト終端/未使用を表すインデックス
+#define TIMER_INDEX_NONE        (-1)
+
+//! タイマIDの世代番号のシフト量
+#define TIMER_ID_GEN_SHIFT      (sizeof(uintptr_t) * 4)
+//! タイマIDのインデックス部/世代番号部のマスク
+#define TIMER_ID_INDEX_MASK     ((((uintptr_t)1) << TIMER_ID_GEN_SHIFT) - 1)
+#define TIMER_ID_GEN_MASK       TIMER_ID_INDEX_MASK
+//! インデックスと世代番号からタイマIDを生成
+#define TIMER_MAKE_ID(index, gen) \
+        ((timer_t)((((uintptr_t)(gen)) << TIMER_ID_GEN_SHIFT) | (uintptr_t)((index) + 1)))
+
 ////////////////////////////////////////////////////////////////////////////////
 // タイマ内部管理用構造体
 ////////////////////////////////////////////////////////////////////////////////
-//! タイマリスト用管理データ
+//! タイマ管理データ
+//! (配列で管理し、スロットのリストはインデックスで連結する)
 struct timer_item
 {
-    timer_t         timerid;    ///< タイマID
-    timer_cbfunc    cb;         ///< ユーザ登録コールバック関数
-    void*           data;       ///< ユーザ登録データ
+    timer_cbfunc    cb;          ///< ユーザ登録コールバック関数
+    void*           data;        ///< ユーザ登録データ
+    uint64_t        expire;      ///< タイムアウトするtick値
+    uint32_t        generation;  ///< 世代番号(タイマIDの再利用検出用)
+    int             slot;        ///< 登録先スロット(TIMER_INDEX_NONEは未使用)
+    int             next;        ///< 次のデータのインデックス
+    int             prev;        ///< 前のデータのインデックス
 };
 typedef struct timer_item timer_item;
 
@@ -43,27 +75,35 @@ typedef struct timer_item timer_item;
 struct m46e_timer_t
 {
     pthread_mutex_t mutex;        ///< タイマ管理用mutex
-    m46e_list      timer_list;   ///< タイマリスト
-};
-
-//! タイマT.O時のコールバックデータ
-struct timer_cb_data
-{
-    m46e_timer_t*  handler;  ///< タイマ管理ハンドラ
-    timer_t         timerid;  ///< T.OしたタイマID
+    pthread_cond_t  cond;         ///< タイマスレッド停止通知用
+    pthread_t       thread;       ///< タイマスレッド
+    bool            stop;         ///< タイマスレッド停止要求
+    struct timespec base;         ///< tick値0の時刻
+    uint64_t        tick;         ///< 処理済みのtick値(秒)
+    timer_item*     items;        ///< タイマ管理データ配列
+    int             item_num;     ///< タイマ管理データ配列の要素数
+    int             free_head;    ///< 未使用タイマ管理データの先頭
+    int             wheel[TIMER_WHEEL_LEVEL * TIMER_WHEEL_SLOTS]; ///< 各スロットの先頭
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
-static int         timer_add_item(m46e_timer_t* timer_handler, timer_item* item);
-static timer_item* timer_del_item(m46e_timer_t* timer_handler, const timer_t timerid);
-static void        timer_timeout_cb(union sigval st);
+static void*       timer_thread_main(void* arg);
+static void        timer_advance(m46e_timer_t* timer_handler);
+static int         timer_alloc_item(m46e_timer_t* timer_handler);
+static void        timer_free_item(m46e_timer_t* timer_handler, int index);
+static void        timer_link_item(m46e_timer_t* timer_handler, int index);
+static void        timer_unlink_item(m46e_timer_t* timer_handler, int index);
+static timer_item* timer_find_item(m46e_timer_t* timer_handler, const timer_t timerid);
+static uint64_t    timer_get_elapsed_nsec(m46e_timer_t* timer_handler);
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief タイマ管理クラス コンストラクタ
 //!
 //! タイマ管理クラスの生成と初期化をおこなう。
+//! タイマは階層型タイマホイールで管理し、1秒毎にtickを進める
+//! タイマスレッドを起動する。
 //!
 //! @param なし
 //!
@@ -74,14 +114,55 @@ m46e_timer_t* m46e_init_timer()
     DEBUG_LOG("timer init\n");
 
     m46e_timer_t* timer_handler = malloc(sizeof(m46e_timer_t));
-    if(timer_handler != NULL){
-        // タイマリスト初期化
-        m46e_list_init(&timer_handler->timer_list);
-        // 排他制御初期化
-        pthread_mutexattr_t attr;
-        pthread_mutexattr_init(&attr);
-        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE_NP);
-        pthread_mutex_init(&timer_handler->mutex, &attr);
+    if(timer_handler == NULL){
+        return NULL;
+    }
+
+    // タイマ管理データ初期化
+    timer_handler->items = malloc(sizeof(timer_item) * TIMER_ITEM_INIT_NUM);
+    if(timer_handler->items == NULL){
+        free(timer_handler);
+        return NULL;
+    }
+    timer_handler->item_num  = TIMER_ITEM_INIT_NUM;
+    timer_handler->free_head = 0;
+    for(int i = 0; i < TIMER_ITEM_INIT_NUM; i++){
+        timer_handler->items[i].generation = 1;
+        timer_handler->items[i].slot       = TIMER_INDEX_NONE;
+        timer_handler->items[i].next       = (i + 1 < TIMER_ITEM_INIT_NUM) ? (i + 1) : TIMER_INDEX_NONE;
+    }
+
+    // タイマホイール初期化
+    for(int i = 0; i < TIMER_WHEEL_LEVEL * TIMER_WHEEL_SLOTS; i++){
+        timer_handler->wheel[i] = TIMER_INDEX_NONE;
+    }
+    timer_handler->tick = 0;
+    timer_handler->stop = false;
+    clock_gettime(CLOCK_MONOTONIC, &timer_handler->base);
+
+    // 排他制御初期化
+    pthread_mutex_init(&timer_handler->mutex, NULL);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_handler->cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    // タイマスレッド起動
+    // (終了時はスレッド自身が管理クラスを解放するのでdetachする)
+    pthread_attr_t tattr;
+    pthread_attr_init(&tattr);
+    pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+    int ret = pthread_create(&timer_handler->thread, &tattr, timer_thread_main, timer_handler);
+    pthread_attr_destroy(&tattr);
+    if(ret != 0){
+        m46e_logging(LOG_ERR, "timer thread create error : %s\n", strerror(ret));
+        pthread_cond_destroy(&timer_handler->cond);
+        pthread_mutex_destroy(&timer_handler->mutex);
+        free(timer_handler->items);
+        free(timer_handler);
+        return NULL;
     }
 
     return timer_handler;
@@ -91,8 +172,8 @@ m46e_timer_t* m46e_init_timer()
 //! @brief タイマ管理クラス デストラクタ
 //!
 //! タイマ管理クラスの解放をおこなう。
-//! タイマリスト内に残っている全タイマを削除し、
-//! 登録されているユーザデータの解放もおこなう。
+//! 登録されている全タイマを削除し、登録されているユーザデータの解放もおこなう。
+//! 管理クラス自体はタイマスレッドの終了時に解放する。
 //!
 //! @param [in] timer_handler 解放するタイマ管理クラス
 //!
@@ -105,29 +186,22 @@ void m46e_end_timer(m46e_timer_t* timer_handler)
     // 排他開始
     pthread_mutex_lock(&timer_handler->mutex);
 
-    // タイマリストに格納されているタイマを全て解除して
-    // データも全て解放する
-    while(!m46e_list_empty(&timer_handler->timer_list)){
-        m46e_list* node = timer_handler->timer_list.next;
-        timer_item* item = node->data;
-        // タイマ情報がNULL以外の場合、タイマ削除
-        if(item != NULL){
-            timer_delete(item->timerid);
-            free(item->data);
+    // 登録されているタイマを全て解除してデータも全て解放する
+    for(int i = 0; i < timer_handler->item_num; i++){
+        if(timer_handler->items[i].slot != TIMER_INDEX_NONE){
+            free(timer_handler->items[i].data);
+            timer_unlink_item(timer_handler, i);
+            timer_free_item(timer_handler, i);
         }
-        free(item);
-        m46e_list_del(node);
-        free(node);
     }
 
+    // タイマスレッドに停止を通知
+    timer_handler->stop = true;
+    pthread_cond_signal(&timer_handler->cond);
+
     // 排他解除
     pthread_mutex_unlock(&timer_handler->mutex);
 
-    // 排他制御終了
-    pthread_mutex_destroy(&timer_handler->mutex); 
-    
-    free(timer_handler);
-
     return;
 }
 
@@ -140,7 +214,7 @@ void m46e_end_timer(m46e_timer_t* timer_handler)
 //! @param [in]  expire_sec      タイムアウト時間(秒)
 //! @param [in]  func            タイムアウト時のcallback関数
 //! @param [in]  data            callback関数の引数データ(不要な場合はNULL)
-//! @param [out] timerid         登録時にシステムから払い出されたタイマID
+//! @param [out] timerid         登録時に払い出されたタイマID
 //!
 //! @retval 0      正常終了
 //! @retval 0以外  異常終了
@@ -153,86 +227,35 @@ int m46e_timer_register(
     timer_t*       timerid
 )
 {
-    struct sigevent   evp;                 // 動作設定構造体
-    struct itimerspec ispec;               // タイマ仕様
-    
+    // 引数チェック
+    if((timer_handler == NULL) || (expire_sec <= 0)){
+        return -1;
+    }
+
     // 排他開始
     pthread_mutex_lock(&timer_handler->mutex);
 
-    // 変数初期化
-    memset(&evp,   0, sizeof(struct sigevent));
-    memset(&ispec, 0, sizeof(struct itimerspec));
-
-    // タイマ構造体のメモリ確保（コールバック時の引数となる）
-    struct timer_cb_data* cb_data = malloc(sizeof(struct timer_cb_data));
-    if(data == NULL){
-        DEBUG_LOG("timer callback data malloc error.\n"); 
-        //排他解除
-        pthread_mutex_unlock(&timer_handler->mutex);
-        return -1;
-    }
-    cb_data->handler = timer_handler;
-
-    // タイマ作成
-    evp.sigev_notify = SIGEV_THREAD;              // SIGEV_THREADを指定(sival_ptrに指定する関数を実行)
-    evp.sigev_signo  = SIGRTMIN + 1;              // リアルタイムタイマーを指定
-    evp.sigev_notify_function = timer_timeout_cb; // 関数ポインタ
-    evp.sigev_value.sival_ptr = cb_data;          // 関数呼び出し時の引数
-
-    if(timer_create(CLOCK_MONOTONIC, &evp, &cb_data->timerid) < 0) {
-        // エラー処理
-        m46e_logging(LOG_INFO, "timer create error : %s\n", strerror(errno));
-        free(data);
+    // タイマ管理データ確保
+    int index = timer_alloc_item(timer_handler);
+    if(index == TIMER_INDEX_NONE){
+        DEBUG_LOG("timer item allocation error.\n");
         //排他解除
         pthread_mutex_unlock(&timer_handler->mutex);
         return -1;
     }
 
-    // タイマ設定
-    ispec.it_value.tv_sec     = expire_sec;    // 実行開始までの時間(0指定だと動作しない)
-    ispec.it_value.tv_nsec    = 0;
-    ispec.it_interval.tv_sec  = 0;             // 実行間隔(ワンショットタイマーであれば0)
-    ispec.it_interval.tv_nsec = 0;
-
-    if(timer_settime(cb_data->timerid, 0, &ispec, NULL) < 0){
-        // エラー処理
-        m46e_logging(LOG_INFO, "timer set error : %s\n", strerror(errno));
-        timer_delete(cb_data->timerid);
-        free(cb_data);
-        //排他解除
-        pthread_mutex_unlock(&timer_handler->mutex);
-        return -1;
-    };
-
-    // タイマリスト格納用のデータ作成
-    timer_item* item = malloc(sizeof(timer_item));
-    if(item == NULL){
-        DEBUG_LOG("timer list item malloc error.\n"); 
-        timer_delete(cb_data->timerid);
-        free(cb_data);
-        //排他解除
-        pthread_mutex_unlock(&timer_handler->mutex);
-        return -1;
-    }
-    // タイマ構造体メンバ設定
-    item->timerid = cb_data->timerid;
-    item->cb      = func;
-    item->data    = data;
-
-    // タイマ情報追加
-    if(timer_add_item(timer_handler, item) < 0){
-        DEBUG_LOG("timer set max error.\n"); 
-        timer_delete(cb_data->timerid);
-        free(cb_data);
-        free(item);
-        //排他解除
-        pthread_mutex_unlock(&timer_handler->mutex);
-        return -1;
-    }
+    // タイマ管理データ設定
+    timer_item* item = &timer_handler->items[index];
+    item->cb     = func;
+    item->data   = data;
+    item->expire = timer_handler->tick + expire_sec;
+
+    // タイマホイールに登録
+    timer_link_item(timer_handler, index);
 
     // タイマIDの出力設定
     if(timerid != NULL){
-        *timerid = cb_data->timerid;
+        *timerid = TIMER_MAKE_ID(index, item->generation);
     }
 
     //排他解除
@@ -263,21 +286,19 @@ int m46e_timer_cancel(m46e_timer_t* timer_handler, const timer_t timerid, void**
     // 排他開始
     pthread_mutex_lock(&timer_handler->mutex);
 
-    // タイマ削除
-    if(timer_delete(timerid) == -1){
-        DEBUG_LOG("timer delete error %s\n", strerror(errno)); 
-    }
-
     // IDをキーにして内部データを取得する
-    timer_item* item = timer_del_item(timer_handler, timerid);
+    timer_item* item = timer_find_item(timer_handler, timerid);
     if(item != NULL){
         if(data != NULL){
             *data = item->data;
         }
-        free(item);
+        int index = item - timer_handler->items;
+        timer_unlink_item(timer_handler, index);
+        timer_free_item(timer_handler, index);
         result = 0;
     }
     else{
+        DEBUG_LOG("timer is not found.\n");
         result = -1;
     }
 
@@ -305,26 +326,24 @@ int m46e_timer_reset(
     const long     time
 )
 {
-    struct itimerspec ispec;               // タイマ仕様
-    
+    int result;
+
     // 排他開始
     pthread_mutex_lock(&timer_handler->mutex);
 
-    // 変数初期化
-    memset(&ispec, 0, sizeof(struct itimerspec));
-
-    // タイマ設定
-    ispec.it_value.tv_sec     = time;    // 実行開始までの時間(0指定だと動作しない)
-    ispec.it_value.tv_nsec    = 0;
-    ispec.it_interval.tv_sec  = 0;       // 実行間隔(ワンショットタイマーであれば0)
-    ispec.it_interval.tv_nsec = 0;
-
-    int result = timer_settime(timerid, 0, &ispec, NULL);
-
-    if(result < 0){
-        // エラー処理
-        m46e_logging(LOG_INFO, "timer set error : %s\n", strerror(errno));
-     }
+    timer_item* item = timer_find_item(timer_handler, timerid);
+    if((item != NULL) && (time > 0)){
+        // 登録中のスロットから外して、新しいタイムアウト値で再登録
+        int index = item - timer_handler->items;
+        timer_unlink_item(timer_handler, index);
+        item->expire = timer_handler->tick + time;
+        timer_link_item(timer_handler, index);
+        result = 0;
+    }
+    else{
+        m46e_logging(LOG_INFO, "timer reset error : timer is not found\n");
+        result = -1;
+    }
 
     //排他解除
     pthread_mutex_unlock(&timer_handler->mutex);
@@ -341,7 +360,8 @@ int m46e_timer_reset(
 //! @param [in]  timerid         登録時に払い出されたタイマID
 //! @param [out] curr_value      タイマ満了までの残り時間
 //!
-//! @return なし
+//! @retval 0     正常終了
+//! @retval -1    指定されたタイマIDが存在しない
 ///////////////////////////////////////////////////////////////////////////////
 int m46e_timer_get(
     m46e_timer_t*     timer_handler,
@@ -349,122 +369,321 @@ int m46e_timer_get(
     struct itimerspec* curr_value
 )
 {
-    // タイマ取得
-    return timer_gettime(timerid, curr_value);
+    int result;
+
+    // 排他開始
+    pthread_mutex_lock(&timer_handler->mutex);
+
+    timer_item* item = timer_find_item(timer_handler, timerid);
+    if((item != NULL) && (curr_value != NULL)){
+        uint64_t expire_nsec  = item->expire * 1000000000ULL;
+        uint64_t elapsed_nsec = timer_get_elapsed_nsec(timer_handler);
+        uint64_t remain_nsec  = (expire_nsec > elapsed_nsec) ? (expire_nsec - elapsed_nsec) : 0;
+
+        memset(curr_value, 0, sizeof(struct itimerspec));
+        curr_value->it_value.tv_sec  = remain_nsec / 1000000000ULL;
+        curr_value->it_value.tv_nsec = remain_nsec % 1000000000ULL;
+        result = 0;
+    }
+    else{
+        errno  = EINVAL;
+        result = -1;
+    }
+
+    //排他解除
+    pthread_mutex_unlock(&timer_handler->mutex);
+
+    return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief タイマリスト追加関数
+//! @brief タイマスレッド
 //!
-//! 内部のタイマリストにデータを追加する。
+//! 1秒毎にタイマホイールのtickを進め、タイムアウトしたタイマの
+//! コールバック関数を呼び出す。
+//! 停止要求を受けた場合は、タイマ管理クラスを解放して終了する。
 //!
-//! @param [in]  timer_handler   追加先タイマ管理クラス
-//! @param [in]  item            追加するデータ
+//! @param [in] arg   タイマ管理クラス
 //!
-//! @retval 0     正常終了
-//! @retval 0以外 異常終了
+//! @return NULL固定
 ///////////////////////////////////////////////////////////////////////////////
-static int timer_add_item(m46e_timer_t* timer_handler, timer_item* item)
+static void* timer_thread_main(void* arg)
 {
-    int result;
+    m46e_timer_t* timer_handler = (m46e_timer_t*)arg;
 
-    DEBUG_LOG("%s start\n", __func__);
+    // 排他開始
+    pthread_mutex_lock(&timer_handler->mutex);
 
-    m46e_list* node = malloc(sizeof(m46e_list));
-    if(node != NULL){
-        m46e_list_init(node);
-        m46e_list_add_data(node, item);
-        m46e_list_add_tail(&timer_handler->timer_list, node);
-        result = 0;
-    }
-    else{
-        m46e_logging(LOG_WARNING, "fail to add timer item to timer list\n");
-        result = -1;
+    while(!timer_handler->stop){
+        // 次のtickの時刻まで待ち合わせ
+        struct timespec next = timer_handler->base;
+        next.tv_sec += timer_handler->tick + 1;
+        pthread_cond_timedwait(&timer_handler->cond, &timer_handler->mutex, &next);
+
+        // 経過時間分tickを進める
+        uint64_t now_tick = timer_get_elapsed_nsec(timer_handler) / 1000000000ULL;
+        while(!timer_handler->stop && (timer_handler->tick < now_tick)){
+            timer_advance(timer_handler);
+        }
     }
 
-    DEBUG_LOG("%s end. return %d\n", __func__, result);
-    return result;
+    //排他解除
+    pthread_mutex_unlock(&timer_handler->mutex);
+
+    // 後始末
+    pthread_cond_destroy(&timer_handler->cond);
+    pthread_mutex_destroy(&timer_handler->mutex);
+    free(timer_handler->items);
+    free(timer_handler);
+
+    DEBUG_LOG("timer thread end\n");
+
+    return NULL;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief タイマリスト削除関数
+//! @brief タイマホイール tick処理関数
 //!
-//! 内部のタイマリストからデータを削除する。
+//! tickを1つ進めて、上位階層のスロットを下位階層に再配置し、
+//! 最下位階層のスロットでタイムアウトしたタイマのコールバック関数を呼び出す。
+//! コールバック関数呼び出し中は排他を解除する。
+//! 本関数は排他を獲得した状態で呼び出すこと。
 //!
-//! @param [in]  timer_handler   削除先タイマ管理クラス
-//! @param [in]  timerid         削除するデータのタイマID
+//! @param [in] timer_handler   タイマ管理クラス
 //!
-//! @return 削除したデータ(タイマIDに対応するデータが無ければNULL)
+//! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-static timer_item* timer_del_item(m46e_timer_t* timer_handler, const timer_t timerid)
+static void timer_advance(m46e_timer_t* timer_handler)
 {
-    timer_item* result;
+    timer_handler->tick++;
+
+    // 下位階層が一周した場合は上位階層のスロットを再配置
+    if((timer_handler->tick & TIMER_WHEEL_MASK) == 0){
+        for(int level = 1; level < TIMER_WHEEL_LEVEL; level++){
+            int slot = (timer_handler->tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+            int head = level * TIMER_WHEEL_SLOTS + slot;
+            while(timer_handler->wheel[head] != TIMER_INDEX_NONE){
+                int index = timer_handler->wheel[head];
+                timer_unlink_item(timer_handler, index);
+                timer_link_item(timer_handler, index);
+            }
+            if(slot != 0){
+                break;
+            }
+        }
+    }
 
-    DEBUG_LOG("%s start\n", __func__);
+    // 最下位階層のスロットのタイマを全てタイムアウトさせる
+    int head = timer_handler->tick & TIMER_WHEEL_MASK;
+    while(!timer_handler->stop && (timer_handler->wheel[head] != TIMER_INDEX_NONE)){
+        int          index   = timer_handler->wheel[head];
+        timer_item*  item    = &timer_handler->items[index];
+        timer_cbfunc cb      = item->cb;
+        void*        data    = item->data;
+        timer_t      timerid = TIMER_MAKE_ID(index, item->generation);
 
-    m46e_list* node = NULL;
-    m46e_list* iter;
-    m46e_list_for_each(iter, &timer_handler->timer_list){
-        timer_item* item = iter->data;
-        if((item != NULL) && (timerid == item->timerid)){
-            node = iter;
-            break;
+        // コールバック前に削除しておく(コールバック中のcancelは-1を返す)
+        timer_unlink_item(timer_handler, index);
+        timer_free_item(timer_handler, index);
+
+        //排他解除
+        pthread_mutex_unlock(&timer_handler->mutex);
+
+        // 登録しているコールバック関数呼び出し
+        if(cb != NULL){
+            cb(timerid, data);
         }
-    }
 
-    if(node != NULL){
-        m46e_list_del(node);
-        result = node->data;
-        free(node);
+        // 排他開始
+        pthread_mutex_lock(&timer_handler->mutex);
     }
-    else{
-        result = NULL;
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマ管理データ確保関数
+//!
+//! 未使用のタイマ管理データを確保する。
+//! 未使用データが無い場合は配列を拡張する。
+//!
+//! @param [in]  timer_handler   タイマ管理クラス
+//!
+//! @return 確保したデータのインデックス(確保できない場合はTIMER_INDEX_NONE)
+///////////////////////////////////////////////////////////////////////////////
+static int timer_alloc_item(m46e_timer_t* timer_handler)
+{
+    if(timer_handler->free_head == TIMER_INDEX_NONE){
+        // 配列を2倍に拡張
+        int new_num = timer_handler->item_num * 2;
+        timer_item* new_items = realloc(timer_handler->items, sizeof(timer_item) * new_num);
+        if(new_items == NULL){
+            m46e_logging(LOG_WARNING, "fail to expand timer item\n");
+            return TIMER_INDEX_NONE;
+        }
+        for(int i = timer_handler->item_num; i < new_num; i++){
+            new_items[i].generation = 1;
+            new_items[i].slot       = TIMER_INDEX_NONE;
+            new_items[i].next       = (i + 1 < new_num) ? (i + 1) : TIMER_INDEX_NONE;
+        }
+        timer_handler->free_head = timer_handler->item_num;
+        timer_handler->items     = new_items;
+        timer_handler->item_num  = new_num;
     }
 
-    DEBUG_LOG("%s end. return %p\n", __func__, result);
-    return result;
+    int index = timer_handler->free_head;
+    timer_handler->free_head = timer_handler->items[index].next;
+
+    return index;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief タイムアウト時のコールバック関数
+//! @brief タイマ管理データ解放関数
 //!
-//! システムタイマT.O時に呼ばれるコールバック関数。
-//! タイマIDに対応するユーザコールバック関数を呼び出す
+//! タイマ管理データを未使用に戻す。
+//! 世代番号を更新して、解放前のタイマIDを無効にする。
 //!
-//! @param [in] st   タイマ登録時に設定した情報ポインタ
+//! @param [in]  timer_handler   タイマ管理クラス
+//! @param [in]  index           解放するデータのインデックス
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-static void timer_timeout_cb(union sigval st)
+static void timer_free_item(m46e_timer_t* timer_handler, int index)
 {
-    struct timer_cb_data* cb_data = (struct timer_cb_data*)st.sival_ptr;
+    timer_item* item = &timer_handler->items[index];
 
-    if(cb_data == NULL){
-        DEBUG_LOG("timeout param error.\n"); 
-        return;
+    item->generation = (item->generation + 1) & TIMER_ID_GEN_MASK;
+    if(item->generation == 0){
+        item->generation = 1;
     }
+    item->slot = TIMER_INDEX_NONE;
+    item->cb   = NULL;
+    item->data = NULL;
+    item->next = timer_handler->free_head;
+    timer_handler->free_head = index;
 
-    // 排他開始
-    pthread_mutex_lock(&cb_data->handler->mutex);
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマホイール登録関数
+//!
+//! タイムアウトまでの残りtick数に応じた階層のスロットにデータを登録する。
+//!
+//! @param [in]  timer_handler   タイマ管理クラス
+//! @param [in]  index           登録するデータのインデックス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void timer_link_item(m46e_timer_t* timer_handler, int index)
+{
+    timer_item* item  = &timer_handler->items[index];
+    uint64_t    delta;
+    int         level;
+
+    // 過ぎているものは現在のtick、最長でも登録可能な最大時間とする
+    // (現在のtickのものは再配置直後に最下位階層でタイムアウトさせる)
+    if(item->expire < timer_handler->tick){
+        item->expire = timer_handler->tick;
+    }
+    delta = item->expire - timer_handler->tick;
+    if(delta > TIMER_WHEEL_MAX_EXPIRE){
+        item->expire = timer_handler->tick + TIMER_WHEEL_MAX_EXPIRE;
+        delta        = TIMER_WHEEL_MAX_EXPIRE;
+    }
+
+    // 登録する階層を決定
+    for(level = 0; level < TIMER_WHEEL_LEVEL - 1; level++){
+        if(delta < (1ULL << (TIMER_WHEEL_BITS * (level + 1)))){
+            break;
+        }
+    }
 
-    // タイマ削除
-    if(timer_delete(cb_data->timerid) == -1){
-        DEBUG_LOG("timer delete error %s\n", strerror(errno));
+    // スロットの先頭に追加
+    int head = level * TIMER_WHEEL_SLOTS + ((item->expire >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    item->slot = head;
+    item->prev = TIMER_INDEX_NONE;
+    item->next = timer_handler->wheel[head];
+    if(item->next != TIMER_INDEX_NONE){
+        timer_handler->items[item->next].prev = index;
     }
+    timer_handler->wheel[head] = index;
 
-    timer_item* item = timer_del_item(cb_data->handler, cb_data->timerid);
+    return;
+}
 
-    //排他解除
-    pthread_mutex_unlock(&cb_data->handler->mutex);
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマホイール削除関数
+//!
+//! 登録されているスロットからデータを外す。
+//!
+//! @param [in]  timer_handler   タイマ管理クラス
+//! @param [in]  index           削除するデータのインデックス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void timer_unlink_item(m46e_timer_t* timer_handler, int index)
+{
+    timer_item* item = &timer_handler->items[index];
 
-    // 登録しているコールバック関数呼び出し
-    if((item != NULL) && item->cb != NULL){
-        item->cb(item->timerid, item->data);
+    if(item->prev != TIMER_INDEX_NONE){
+        timer_handler->items[item->prev].next = item->next;
+    }
+    else{
+        timer_handler->wheel[item->slot] = item->next;
     }
-    
-    free(item);
-    free(cb_data);
+    if(item->next != TIMER_INDEX_NONE){
+        timer_handler->items[item->next].prev = item->prev;
+    }
+    item->prev = TIMER_INDEX_NONE;
+    item->next = TIMER_INDEX_NONE;
 
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief タイマ管理データ検索関数
+//!
+//! タイマIDに対応する登録中のタイマ管理データを取得する。
+//!
+//! @param [in]  timer_handler   タイマ管理クラス
+//! @param [in]  timerid         登録時に払い出されたタイマID
+//!
+//! @return タイマ管理データ(タイマIDに対応するデータが無ければNULL)
+///////////////////////////////////////////////////////////////////////////////
+static timer_item* timer_find_item(m46e_timer_t* timer_handler, const timer_t timerid)
+{
+    uintptr_t id         = (uintptr_t)timerid;
+    int       index      = (int)(id & TIMER_ID_INDEX_MASK) - 1;
+    uint32_t  generation = (uint32_t)(id >> TIMER_ID_GEN_SHIFT);
+
+    if((index < 0) || (index >= timer_handler->item_num)){
+        return NULL;
+    }
+
+    timer_item* item = &timer_handler->items[index];
+    if((item->slot == TIMER_INDEX_NONE) || (item->generation != generation)){
+        return NULL;
+    }
+
+    return item;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経過時間取得関数
+//!
+//! タイマ管理クラス生成時からの経過時間を取得する。
+//!
+//! @param [in]  timer_handler   タイマ管理クラス
+//!
+//! @return 経過時間(ナノ秒)
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t timer_get_elapsed_nsec(m46e_timer_t* timer_handler)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)(now.tv_sec - timer_handler->base.tv_sec) * 1000000000ULL
+         + (int64_t)(now.tv_nsec - timer_handler->base.tv_nsec);
+}
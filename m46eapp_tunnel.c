@@ -7,6 +7,22 @@
 /*              2013.09.13 K.Nakamura バグ修正                                */
 /*              2013.09.13 K.Nakamura M46E-PR拡張機能 追加                    */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent Packet Too Big重複抑止追加                   */
+/*              2026.10.18 agent Packet Too Big妥当性検証追加                 */
+/*              2026.10.18 agent PMTU拡大プローブ追加                         */
+/*              2026.10.18 agent 統計情報のスレッド毎カウンタ化               */
+/*              2026.10.18 agent 統計情報のバイト数/レート追加                */
+/*              2026.10.18 agent 遅延ヒストグラム追加                         */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent フラグメント時のチェックサム差分更新         */
+/*              2026.10.18 agent フラグメントのバッチ書き込み                 */
+/*              2026.10.18 agent 外側IPv6フラグメント追加                     */
+/*              2026.10.18 agent カプセル化処理のモード別特化                 */
+/*              2026.10.18 agent Fragment Neededの注入追加                    */
+/*              2026.10.18 agent Fragment Needed送信の流量制限                */
+/*              2026.10.18 agent ASモードのフラグメント転送追加               */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -18,6 +34,7 @@
 #include <pthread.h>
 #include <limits.h>
 #include <errno.h>
+#include <time.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <netinet/udp.h>
@@ -42,6 +59,7 @@
 #include "m46eapp_pmtudisc.h"
 #include "m46eapp_command.h"
 #include "m46eapp_pr.h"
+#include "m46eapp_reasm.h"
 
 // デバッグ用マクロ
 #ifdef DEBUG
@@ -53,17 +71,175 @@
 //! 受信バッファのサイズ
 #define TUNNEL_RECV_BUF_SIZE 65535
 
+//! 転送処理のステージ終了(M46E_PROFILE定義時のみ有効)
+#define TUNNEL_PROFILE_MARK(handler, last, stage) \
+    M46E_PROFILE_MARK(M46E_STATISTICS_PROFILE((handler)->stat_info), last, stage)
+
+//! Packet Too Big重複抑止テーブルのエントリ数(2のべき乗)
+#define TUNNEL_PTB_CACHE_SIZE 64
+
+//! Packet Too Big重複抑止時間(ミリ秒)
+#define TUNNEL_PTB_COALESCE_MSEC 1000
+
+//! M46E-ASモードのフラグメントフローキャッシュのエントリ数(2のべき乗)
+#define TUNNEL_AS_FRAG_CACHE_SIZE 256
+
+//! M46E-ASモードのフラグメントフローキャッシュの保持時間(ミリ秒)
+#define TUNNEL_AS_FRAG_CACHE_MSEC 30000
+
+//! M46E-ASモードで先頭フラグメント待ちとして保持するフラグメント数
+#define TUNNEL_AS_FRAG_HOLD_NUM   16
+
+//! M46E-ASモードで先頭フラグメント待ちとして保持する時間(ミリ秒)
+#define TUNNEL_AS_FRAG_HOLD_MSEC  1000
+
+//! Fragment Needed送信レート(全体、1秒あたりの送信数)
+#define TUNNEL_FRAG_NEED_RATE_GLOBAL   1000
+
+//! Fragment Needed送信の最大バースト数(全体)
+#define TUNNEL_FRAG_NEED_BURST_GLOBAL  100
+
+//! Fragment Needed送信レート(送信元アドレス毎、1秒あたりの送信数)
+#define TUNNEL_FRAG_NEED_RATE_SOURCE   10
+
+//! Fragment Needed送信の最大バースト数(送信元アドレス毎)
+#define TUNNEL_FRAG_NEED_BURST_SOURCE  10
+
+//! Fragment Needed送信レート制限テーブルのエントリ数(2のべき乗)
+#define TUNNEL_FRAG_NEED_SOURCE_SIZE   256
+
+//! トークンバケットのトークン1個あたりの内部単位
+#define TUNNEL_TOKEN_UNIT              1000000L
+
+//! 1パケットから生成するフラグメントの最大数
+//! (IPv4最大長65535byteをIPv6最小MTU長で分割した場合の数以上とする)
+#define TUNNEL_FRAG_BATCH_MAX 64
+
+//! フラグメント1個あたりのiovec数(Ether/IPv6/フラグメント毎のヘッダ/ペイロード)
+#define TUNNEL_FRAG_IOV_NUM   4
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体
+////////////////////////////////////////////////////////////////////////////////
+//! Packet Too Big重複抑止テーブルのエントリ
+struct tunnel_ptb_cache_entry
+{
+    struct in6_addr  dst_addr;   ///< 通知済みの送信先アドレス
+    int              mtu;        ///< 通知済みのMTU長(0は未使用)
+    struct timespec  recv_time;  ///< 通知した時刻
+};
+
+//! Packet Too Big重複抑止テーブル
+//! (デカプセル化スレッドからのみ参照するため排他は行わない)
+static struct tunnel_ptb_cache_entry tunnel_ptb_cache[TUNNEL_PTB_CACHE_SIZE];
+
+//! 外側IPv6フラグメントのIdentification
+//! (カプセル化スレッドからのみ参照するため排他は行わない)
+static uint32_t tunnel_frag_ident;
+
+//! トークンバケット
+struct tunnel_token_bucket
+{
+    long             tokens;       ///< 残りトークン(TUNNEL_TOKEN_UNIT単位)
+    struct timespec  update_time;  ///< 最終補充時刻
+};
+
+//! Fragment Needed送信レート制限テーブルのエントリ
+struct tunnel_frag_need_source
+{
+    uint32_t                    saddr;   ///< 送信先(元パケットの送信元)アドレス
+    bool                        valid;   ///< 使用中かどうか
+    struct tunnel_token_bucket  bucket;  ///< 送信元アドレス毎のトークンバケット
+};
+
+//! Fragment Needed送信用のRAWソケット(未オープン時は-1)
+//! (カプセル化スレッドからのみ参照するため排他は行わない)
+static int tunnel_frag_need_fd = -1;
+
+//! Fragment Needed送信レート制限(全体)
+static struct tunnel_token_bucket tunnel_frag_need_global;
+
+//! Fragment Needed送信レート制限テーブル(送信元アドレス毎)
+static struct tunnel_frag_need_source tunnel_frag_need_source[TUNNEL_FRAG_NEED_SOURCE_SIZE];
+
+//! M46E-ASモードのフラグメントフローキャッシュのエントリ
+//! (先頭フラグメントのポート番号を後続のフラグメントに適用する)
+struct tunnel_as_frag_entry
+{
+    uint32_t         saddr;      ///< 送信元アドレス
+    uint32_t         daddr;      ///< 送信先アドレス
+    uint16_t         id;         ///< Identification
+    uint8_t          protocol;   ///< プロトコル
+    bool             valid;      ///< 使用中かどうか
+    uint16_t         sport;      ///< 先頭フラグメントの送信元ポート
+    uint16_t         dport;      ///< 先頭フラグメントの送信先ポート
+    struct timespec  recv_time;  ///< 先頭フラグメントの受信時刻
+};
+
+//! M46E-ASモードのフラグメントフローキャッシュ
+//! (カプセル化スレッドからのみ参照するため排他は行わない)
+static struct tunnel_as_frag_entry tunnel_as_frag_cache[TUNNEL_AS_FRAG_CACHE_SIZE];
+
+//! M46E-ASモードの先頭フラグメント待ちのフラグメント
+struct tunnel_as_frag_hold
+{
+    char*            buffer;     ///< 受信フレームの複製(未使用時はNULL)
+    ssize_t          len;        ///< 受信フレーム長
+    struct timespec  recv_time;  ///< 受信時刻
+};
+
+//! M46E-ASモードの先頭フラグメント待ちのフラグメント
+//! (カプセル化スレッドからのみ参照するため排他は行わない)
+static struct tunnel_as_frag_hold tunnel_as_frag_hold[TUNNEL_AS_FRAG_HOLD_NUM];
+
+//! IPv6フラグメント再構築(再構築しない場合はNULL)
+//! (デカプセル化スレッドからのみ参照するため排他は行わない)
+static m46e_reasm_t* tunnel_reasm;
+
+//! フラグメントバッチ
+//! (1パケット分の全フラグメントを組み立ててから書き込み、統計情報はまとめて計上する)
+typedef struct _tunnel_frag_batch_t
+{
+    int            num;                                          ///< 格納したフラグメント数
+    struct ip6_hdr ip6_full;                                     ///< 後続ありフラグメント用IPv6ヘッダ
+    uint32_t       hdr[TUNNEL_FRAG_BATCH_MAX][15];               ///< フラグメント毎のヘッダ(IPv4ヘッダ/IPv6 Fragmentヘッダ)
+    struct iovec   iov[TUNNEL_FRAG_BATCH_MAX][TUNNEL_FRAG_IOV_NUM]; ///< フラグメント毎の送信データ
+    size_t         len[TUNNEL_FRAG_BATCH_MAX];                   ///< フラグメント毎のフレーム長
+} tunnel_frag_batch_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
 static void tunnel_buffer_cleanup(void* buffer);
+static void tunnel_reasm_cleanup(void* reasm);
+static void tunnel_as_frag_hold_cleanup(void* arg);
+static void tunnel_frag_need_cleanup(void* arg);
 static void tunnel_ipv4_main_loop(struct m46e_handler_t* handler);
 static void tunnel_ipv6_main_loop(struct m46e_handler_t* handler);
 static void tunnel_forward_ipv4_packet(struct m46e_handler_t* handler, char* recv_buffer, ssize_t recv_len, m46e_device_t* recv_dev, m46e_device_t* send_dev);
+static void tunnel_encap_ipv4_packet(struct m46e_handler_t* handler, char* recv_buffer, ssize_t recv_len, m46e_device_t* recv_dev, m46e_device_t* send_dev);
+static inline void tunnel_encap_ipv4_packet_body(struct m46e_handler_t* handler, char* recv_buffer, ssize_t recv_len, m46e_device_t* recv_dev, m46e_device_t* send_dev, const m46e_tunnel_mode tunnel_mode);
+static void tunnel_encap_select(struct m46e_handler_t* handler);
 static void tunnel_forward_ipv6_packet(struct m46e_handler_t* handler, char* recv_buffer, ssize_t recv_len, m46e_device_t* recv_dev, m46e_device_t* send_dev);
 static void tunnel_send_fragment_packet(struct m46e_handler_t* hander, m46e_device_t* send_dev, struct ethhdr* p_ether, struct ip6_hdr* p_ip6, struct iphdr* p_ip4, const int pmtu_size);
-static void tunnel_send_frag_need_error(struct m46e_handler_t* handler, struct iphdr* p_ip4, const uint16_t next_mtu);
+static void tunnel_send_outer_fragment_packet(struct m46e_handler_t* handler, m46e_device_t* send_dev, struct ethhdr* p_ether, struct ip6_hdr* p_ip6, struct iphdr* p_ip4, const int pmtu_size);
+static void tunnel_write_frag_batch(struct m46e_handler_t* handler, m46e_device_t* send_dev, tunnel_frag_batch_t* batch);
+static void tunnel_send_frag_need_error(struct m46e_handler_t* handler, m46e_device_t* recv_dev, const struct ethhdr* p_ether, struct iphdr* p_ip4, const uint16_t next_mtu);
+static void tunnel_inject_icmp_error(struct m46e_handler_t* handler, m46e_device_t* recv_dev, const struct ethhdr* original_ether, const struct iphdr* original_ip4, struct iovec* icmp_iov);
 static bool tunnel_check_icmp_error_send(const struct iphdr* p_ip4);
+static inline bool tunnel_latency_start(struct m46e_handler_t* handler, int* sample_count, struct timespec* start);
+static inline void tunnel_latency_end(struct m46e_handler_t* handler, const struct timespec* start);
+static bool tunnel_check_ptb_valid(struct m46e_handler_t* handler, const struct icmp6_hdr* p_icmp6, const ssize_t icmp6_len);
+static bool tunnel_check_ptb_duplicate(const struct in6_addr* dst_addr, const int mtu);
+static void tunnel_token_bucket_refill(struct tunnel_token_bucket* bucket, const long rate, const long burst, const struct timespec* now);
+static bool tunnel_frag_need_rate_check(const uint32_t saddr);
+static inline long tunnel_elapsed_msec(const struct timespec* from, const struct timespec* now);
+static struct tunnel_as_frag_entry* tunnel_as_frag_entry_get(const struct iphdr* p_ip4);
+static void tunnel_as_frag_register(const struct iphdr* p_ip4, const uint16_t sport, const uint16_t dport);
+static bool tunnel_as_frag_lookup(const struct iphdr* p_ip4, uint16_t* sport, uint16_t* dport);
+static void tunnel_as_frag_hold_expire(struct m46e_handler_t* handler);
+static bool tunnel_as_frag_hold_add(struct m46e_handler_t* handler, const char* recv_buffer, const ssize_t recv_len);
+static void tunnel_as_frag_hold_flush(struct m46e_handler_t* handler, const struct iphdr* p_ip4, m46e_device_t* recv_dev, m46e_device_t* send_dev);
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief Stubネットワーク用 パケットカプセル化スレッド
@@ -87,6 +263,14 @@ void* m46e_tunnel_stub_thread(void* arg)
     // ローカル変数初期化
     handler = (struct m46e_handler_t*)arg;
 
+    // 統計情報はカプセル化スレッド用のカウンタを更新する
+    m46e_statistics_set_worker(M46E_STATISTICS_WORKER_ENCAP);
+
+    // 外側IPv6フラグメントのIdentificationは起動毎に異なる値から開始する
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    tunnel_frag_ident = (uint32_t)(now.tv_nsec ^ now.tv_sec ^ getpid());
+
     // メインループ開始
     tunnel_ipv4_main_loop(handler);
 
@@ -117,6 +301,9 @@ void* m46e_tunnel_backbone_thread(void* arg)
     // ローカル変数初期化
     handler = (struct m46e_handler_t*)arg;
 
+    // 統計情報はデカプセル化スレッド用のカウンタを更新する
+    m46e_statistics_set_worker(M46E_STATISTICS_WORKER_DECAP);
+
     // メインループ開始
     tunnel_ipv6_main_loop(handler);
 
@@ -145,6 +332,44 @@ static void tunnel_buffer_cleanup(void* buffer)
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6フラグメント再構築解放関数
+//!
+//! 引数で指定されたIPv6フラグメント再構築を解放する。
+//! スレッドの終了時に呼ばれる。
+//!
+//! @param [in] reasm     IPv6フラグメント再構築
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_reasm_cleanup(void* reasm)
+{
+    m46e_reasm_destroy((m46e_reasm_t*)reasm);
+    tunnel_reasm = NULL;
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief Fragment Needed送信用ソケット解放関数
+//!
+//! Fragment Needed送信用のRAWソケットをクローズする。
+//! スレッドの終了時に呼ばれる。
+//!
+//! @param [in] arg       未使用
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_frag_need_cleanup(void* arg)
+{
+    if(tunnel_frag_need_fd >= 0){
+        close(tunnel_frag_need_fd);
+        tunnel_frag_need_fd = -1;
+    }
+
+    return;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief Stubネットワーク メインループ関数
 //!
@@ -165,6 +390,9 @@ static void tunnel_ipv4_main_loop(struct m46e_handler_t* handler)
     ssize_t recv_len;
     m46e_device_t* ipv4_dev;
     m46e_device_t* ipv6_dev;
+    int     sample_count;
+    bool    measure;
+    struct timespec start;
 
     // 引数チェック
     if(handler == NULL){
@@ -180,6 +408,11 @@ static void tunnel_ipv4_main_loop(struct m46e_handler_t* handler)
 
     // 後始末ハンドラ登録
     pthread_cleanup_push(tunnel_buffer_cleanup, (void*)recv_buffer);
+    pthread_cleanup_push(tunnel_as_frag_hold_cleanup, NULL);
+
+    // 動作モード専用のカプセル化関数を選択
+    tunnel_encap_select(handler);
+    pthread_cleanup_push(tunnel_frag_need_cleanup, NULL);
 
     // トンネルデバイス
     ipv4_dev = &handler->conf->tunnel->ipv4;
@@ -215,6 +448,8 @@ static void tunnel_ipv4_main_loop(struct m46e_handler_t* handler)
 
     m46e_logging(LOG_INFO, "IPv4 tunnel thread main loop start\n");
 
+    sample_count = 0;
+
     while(1){
         // selectorの初期化
         FD_ZERO(&fds);
@@ -236,7 +471,11 @@ static void tunnel_ipv4_main_loop(struct m46e_handler_t* handler)
         // IPv4用TAPデバイスでデータ受信
         if(FD_ISSET(ipv4_dev->option.tunnel.fd, &fds)){
             if((recv_len=read(ipv4_dev->option.tunnel.fd, recv_buffer, TUNNEL_RECV_BUF_SIZE)) > 0){
+                measure = tunnel_latency_start(handler, &sample_count, &start);
                 tunnel_forward_ipv4_packet(handler, recv_buffer, recv_len, ipv4_dev, ipv6_dev);
+                if(measure){
+                    tunnel_latency_end(handler, &start);
+                }
             }
             else{
                 m46e_logging(LOG_ERR, "v4 recvfrom\n");
@@ -248,6 +487,8 @@ static void tunnel_ipv4_main_loop(struct m46e_handler_t* handler)
 
     // 後始末
     pthread_cleanup_pop(1);
+    pthread_cleanup_pop(1);
+    pthread_cleanup_pop(1);
     
     return;
 }
@@ -272,6 +513,9 @@ static void tunnel_ipv6_main_loop(struct m46e_handler_t* handler)
     ssize_t recv_len;
     m46e_device_t* ipv4_dev;
     m46e_device_t* ipv6_dev;
+    int     sample_count;
+    bool    measure;
+    struct timespec start;
 
     // 引数チェック
     if(handler == NULL){
@@ -288,6 +532,19 @@ static void tunnel_ipv6_main_loop(struct m46e_handler_t* handler)
     // 後始末ハンドラ登録
     pthread_cleanup_push(tunnel_buffer_cleanup, (void*)recv_buffer);
 
+    // IPv6フラグメント再構築領域を生成
+    if(handler->conf->general->reasm_entry_max > 0){
+        tunnel_reasm = m46e_reasm_create(
+            handler->conf->general->reasm_entry_max,
+            handler->conf->general->reasm_source_max,
+            handler->conf->general->reasm_timeout
+        );
+        if(tunnel_reasm == NULL){
+            m46e_logging(LOG_WARNING, "fail to create IPv6 reassembly table. fragments are dropped.\n");
+        }
+    }
+    pthread_cleanup_push(tunnel_reasm_cleanup, (void*)tunnel_reasm);
+
     // トンネルデバイス
     ipv4_dev = &handler->conf->tunnel->ipv4;
     ipv6_dev = &handler->conf->tunnel->ipv6;
@@ -322,13 +579,20 @@ static void tunnel_ipv6_main_loop(struct m46e_handler_t* handler)
 
     m46e_logging(LOG_INFO, "IPv6 tunnel thread main loop start\n");
 
+    sample_count = 0;
+
     while(1){
         // selectorの初期化
         FD_ZERO(&fds);
         FD_SET(ipv6_dev->option.tunnel.fd, &fds);
 
+        // 再構築中のフラグメントがある場合は、タイムアウト判定のため1秒毎に起床する
+        struct timeval  t = { 1, 0 };
+        struct timeval* timeout = (m46e_reasm_count(tunnel_reasm) > 0) ? &t : NULL;
+
         // 受信待ち
-        if(select(max_fd, &fds , NULL, NULL, NULL) < 0){
+        int ret = select(max_fd, &fds , NULL, NULL, timeout);
+        if(ret < 0){
             if(errno == EINTR){
                 // シグナル割込みの場合は処理継続
                 DEBUG_LOG("signal receive. continue thread loop.");
@@ -339,11 +603,20 @@ static void tunnel_ipv6_main_loop(struct m46e_handler_t* handler)
                 break;;
             }
         }
+        else if(ret == 0){
+            // タイムアウトしたフラグメントを破棄
+            m46e_add_tunnel_v6_reasm_timeout(handler->stat_info, m46e_reasm_expire(tunnel_reasm));
+            continue;
+        }
 
         // IPv6用TAPデバイスでデータ受信
         if(FD_ISSET(ipv6_dev->option.tunnel.fd, &fds)){
             if((recv_len=read(ipv6_dev->option.tunnel.fd, recv_buffer, TUNNEL_RECV_BUF_SIZE)) > 0){
+                measure = tunnel_latency_start(handler, &sample_count, &start);
                 tunnel_forward_ipv6_packet(handler, recv_buffer, recv_len, ipv6_dev, ipv4_dev);
+                if(measure){
+                    tunnel_latency_end(handler, &start);
+                }
             }
             else{
                 m46e_logging(LOG_ERR, "v6 recvfrom\n");
@@ -355,6 +628,7 @@ static void tunnel_ipv6_main_loop(struct m46e_handler_t* handler)
 
     // 後始末
     pthread_cleanup_pop(1);
+    pthread_cleanup_pop(1);
     
     return;
 }
@@ -379,6 +653,39 @@ static void tunnel_forward_ipv4_packet(
     m46e_device_t*           recv_dev,
     m46e_device_t*           send_dev
 )
+{
+    // 統計情報
+    m46e_inc_tunnel_v4_recieve(handler->stat_info, recv_len);
+
+    tunnel_encap_ipv4_packet(handler, recv_buffer, recv_len, recv_dev, send_dev);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4パケットカプセル化関数(動作モード別処理の共通部)
+//!
+//! IPv4パケットをカプセル化してIPv6デバイスに転送する。<br/>
+//! 動作モードを定数で渡して展開することで、モード毎の分岐を
+//! コンパイル時に解決した専用の転送関数を生成する。
+//!
+//! @param [in,out] handler     M46Eハンドラ
+//! @param [in]     recv_buffer 受信パケットデータ
+//! @param [in]     recv_len    受信パケット長
+//! @param [in]     recv_dev    パケットを受信したデバイス
+//! @param [in]     send_dev    パケットを転送するデバイス
+//! @param [in]     tunnel_mode 動作モード
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static inline __attribute__((always_inline)) void tunnel_encap_ipv4_packet_body(
+    struct m46e_handler_t*   handler,
+    char*                     recv_buffer,
+    ssize_t                   recv_len,
+    m46e_device_t*           recv_dev,
+    m46e_device_t*           send_dev,
+    const m46e_tunnel_mode   tunnel_mode
+)
 {
     // ローカル変数宣言
     struct ethhdr*   p_ether;
@@ -394,6 +701,12 @@ static void tunnel_forward_ipv4_packet(
 
     in_addr_t        v4dhostaddr;
     m46e_pr_entry_t* pr_entry;
+    bool             as_frag_first;
+    struct ethhdr    orig_ether;
+    M46E_PROFILE_DECLARE(prof_last);
+
+    // ステージ別サイクル計測開始
+    M46E_PROFILE_START(prof_last);
 
     // ローカル変数初期化
     p_ether        = (struct ethhdr*)recv_buffer;
@@ -407,14 +720,13 @@ static void tunnel_forward_ipv4_packet(
     v6addr_m         = NULL;
     v6addr_pr_src      = NULL;
     v4dhostaddr    = INADDR_NONE;
-
-    // 統計情報
-    m46e_inc_tunnel_v4_recieve(handler->stat_info);
+    as_frag_first  = false;
 
     if(m46e_util_is_broadcast_mac(&p_ether->h_dest[0])){
         // ブロードキャストパケットは黙って破棄
         DEBUG_LOG("drop packet so that recv packet is broadcast\n");
         m46e_inc_tunnel_v4_err_broadcast(handler->stat_info);
+        m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_BROADCAST, recv_buffer, recv_len);
         return;
     }
 
@@ -435,15 +747,17 @@ static void tunnel_forward_ipv4_packet(
             // マルチキャストパケット
             DEBUG_LOG("recv packet is multicast.\n");
 
-            if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_PR){
+            if(tunnel_mode == M46E_TUNNEL_MODE_PR){
                 DEBUG_LOG("drop packet so that recv packet is multicast.\n");
                 m46e_inc_tunnel_v4_err_pr_multi(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_PR_MULTI, recv_buffer, recv_len);
                 return;
             }
             if(v4dhostaddr <= INADDR_MAX_LOCAL_GROUP){
                 // リンクローカルのマルチキャストなので黙って破棄
                 DEBUG_LOG("drop packet so that recv packet is link local multicast.\n");
                 m46e_inc_tunnel_v4_err_linklocal_multi(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_LINKLOCAL_MULTI, recv_buffer, recv_len);
                 return;
             }
         }
@@ -452,36 +766,51 @@ static void tunnel_forward_ipv4_packet(
             DEBUG_LOG("recv packet is unicast.\n");
         }
 
-        switch(handler->conf->general->tunnel_mode){
+        switch(tunnel_mode){
         case M46E_TUNNEL_MODE_AS:
-            // ASモードの場合、フラグメントされたパケットは
-            // すべて破棄する。
+            // ASモードの場合、ポート番号はL4ヘッダを持つ先頭フラグメントからしか
+            // 取得できないので、フラグメントフローキャッシュに登録して
+            // 後続のフラグメントに同じポート番号を適用する。
             // フラグメントされているかどうかの判定は
             //   ・Fragment offset = 0
             //   ・MF(More Fragments)ビット = OFF(0)
             // が成立した場合、フラグメントされていないと判断する。
-            if((ntohs(p_ip4->frag_off) & (IP_MF | IP_OFFMASK)) != 0){
-                // フラグメントパケットなので黙って破棄
-                m46e_inc_tunnel_v4_err_as_fragment(handler->stat_info);
-                DEBUG_LOG("drop packet so that recv packet is fragment and mode is AS.\n");
-                return;
+            if((ntohs(p_ip4->frag_off) & IP_OFFMASK) != 0){
+                // 先頭以外のフラグメントはキャッシュからポート番号を取得
+                if(!tunnel_as_frag_lookup(p_ip4, &v4sport, &v4dport)){
+                    // 先頭フラグメントが未着の場合は保持して到着を待つ
+                    if(!tunnel_as_frag_hold_add(handler, recv_buffer, recv_len)){
+                        m46e_inc_tunnel_v4_err_as_fragment(handler->stat_info);
+                        m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_AS_FRAGMENT, recv_buffer, recv_len);
+                        DEBUG_LOG("drop packet so that fragment hold buffer is full.\n");
+                    }
+                    return;
+                }
             }
+            else{
+                // ASモードの場合はポート番号を取得
+                switch(p_ip4->protocol){
+                case IPPROTO_TCP:
+                    v4sport = ((struct tcphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->source;
+                    v4dport = ((struct tcphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->dest;
+                    break;
+                case IPPROTO_UDP:
+                    v4sport = ((struct udphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->source;
+                    v4dport = ((struct udphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->dest;
+                    break;
+                default:
+                    // L4がTCP/UDP以外の場合は黙って破棄
+                    m46e_inc_tunnel_v4_err_as_not_support_proto(handler->stat_info);
+                    m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_AS_NOT_SUPPORT_PROTO, recv_buffer, recv_len);
+                    DEBUG_LOG("drop packet so that payload is not tcp/udp.\n");
+                    return;
+                }
 
-            // ASモードの場合はポート番号を取得
-            switch(p_ip4->protocol){
-            case IPPROTO_TCP:
-                v4sport = ((struct tcphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->source;
-                v4dport = ((struct tcphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->dest;
-                break;
-            case IPPROTO_UDP:
-                v4sport = ((struct udphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->source;
-                v4dport = ((struct udphdr*)(((char*)p_ip4) + (p_ip4->ihl * 4)))->dest;
-                break;
-            default:
-                // L4がTCP/UDP以外の場合は黙って破棄
-                m46e_inc_tunnel_v4_err_as_not_support_proto(handler->stat_info);
-                DEBUG_LOG("drop packet so that payload is not tcp/udp.\n");
-                return;
+                if((ntohs(p_ip4->frag_off) & IP_MF) != 0){
+                    // 先頭フラグメントのポート番号を登録
+                    tunnel_as_frag_register(p_ip4, v4sport, v4dport);
+                    as_frag_first = true;
+                }
             }
             // IPアドレスも取得するので、このまま継続(breakしない)
 
@@ -495,18 +824,20 @@ static void tunnel_forward_ipv4_packet(
 
         default:
             // ありえないのでパケット破棄
-            DEBUG_LOG("drop packet so that M46E mode is invalid(mode=%d)\n", handler->conf->general->tunnel_mode);
+            DEBUG_LOG("drop packet so that M46E mode is invalid(mode=%d)\n", tunnel_mode);
             // このルートに来ることは無いので統計は省略
             return;
         }
 
+        TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_PARSE);
+
         // M46E prefixアドレスを取得
         if(IN_MULTICAST(v4dhostaddr)){
             v6addr_u = &handler->unicast_prefix;
             v6addr_m = &handler->multicast_prefix;
         }
         else{
-            switch(handler->conf->general->tunnel_mode) {
+            switch(tunnel_mode) {
             case M46E_TUNNEL_MODE_NORMAL:
             case M46E_TUNNEL_MODE_AS:
                 v6addr_u = &handler->unicast_prefix;
@@ -515,6 +846,7 @@ static void tunnel_forward_ipv4_packet(
                 pr_entry = m46e_pr_entry_search_stub(handler->pr_handler, (struct in_addr*)&v4daddr);
                 if(pr_entry == NULL){
                     m46e_inc_tunnel_v4_err_pr_search_failure(handler->stat_info);
+                    m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_PR_SEARCH_FAILURE, recv_buffer, recv_len);
                     DEBUG_LOG("drop packet so that destination address is NOT in M46E-PR Table.\n");
                     return;
                 }
@@ -524,12 +856,14 @@ static void tunnel_forward_ipv4_packet(
                 break;
             default:
                 // ありえないのでパケット破棄
-                DEBUG_LOG("drop packet so that M46E mode is invalid(mode=%d)\n", handler->conf->general->tunnel_mode);
+                DEBUG_LOG("drop packet so that M46E mode is invalid(mode=%d)\n", tunnel_mode);
                 // このルートに来ることは無いので統計は省略
                 return;
             }
         }
 
+        TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_PR_LOOKUP);
+
         // IPv6ヘッダ構築
         struct ip6_hdr ip6_header;
         p_ip6 = &ip6_header;
@@ -538,7 +872,7 @@ static void tunnel_forward_ipv4_packet(
         p_ip6->ip6_plen = p_ip4->tot_len;
         p_ip6->ip6_nxt  = IPPROTO_IPIP;
         p_ip6->ip6_hops = 0x80;
-        switch(handler->conf->general->tunnel_mode){
+        switch(tunnel_mode){
         case M46E_TUNNEL_MODE_NORMAL: // 通常モード
         case M46E_TUNNEL_MODE_PR:     // PRモード
             if(IN_MULTICAST(v4dhostaddr)){
@@ -552,12 +886,12 @@ static void tunnel_forward_ipv4_packet(
             p_ip6->ip6_dst.s6_addr32[3] = v4daddr;
             }
             else {
-if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
+if(tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
                 p_ip6->ip6_src.s6_addr32[0] = v6addr_u->s6_addr32[0];
                 p_ip6->ip6_src.s6_addr32[1] = v6addr_u->s6_addr32[1];
                 p_ip6->ip6_src.s6_addr32[2] = v6addr_u->s6_addr32[2];
                 p_ip6->ip6_src.s6_addr32[3] = v4saddr;
-}else{//handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_PR
+}else{//tunnel_mode == M46E_TUNNEL_MODE_PR
                 p_ip6->ip6_src.s6_addr32[0] = v6addr_pr_src->s6_addr32[0];
                 p_ip6->ip6_src.s6_addr32[1] = v6addr_pr_src->s6_addr32[1];
                 p_ip6->ip6_src.s6_addr32[2] = v6addr_pr_src->s6_addr32[2];
@@ -607,18 +941,21 @@ if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
 
         default:
             // ありえないのでパケット破棄
-            DEBUG_LOG("drop packet so that M46E mode is invalid(mode=%d)\n", handler->conf->general->tunnel_mode);
+            DEBUG_LOG("drop packet so that M46E mode is invalid(mode=%d)\n", tunnel_mode);
             // このルートに来ることは無いので統計は省略
             return;
         }
 
+        // ICMPエラーを返す場合に備えて書き換え前のetherヘッダを退避
+        memcpy(&orig_ether, p_ether, sizeof(struct ethhdr));
+
         // etherフレームのプロトコルをIPv6に書き換え
         p_ether->h_proto = htons(ETH_P_IPV6);
         // etherフレームのsrcをIPv4のMACに書き換え
         memcpy(p_ether->h_source, recv_dev->hwaddr, ETH_ALEN);
 
         if(IN_MULTICAST(v4dhostaddr)){
-            m46e_inc_tunnel_v4_recv_multicast(handler->stat_info);
+            m46e_inc_tunnel_v4_recv_multicast(handler->stat_info, recv_len);
             // etherフレームのdstをマルチキャストのMACに書き換え
             p_ether->h_dest[0] = 0x33;
             p_ether->h_dest[1] = 0x33;
@@ -628,26 +965,38 @@ if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
             p_ether->h_dest[5] = p_ip6->ip6_dst.s6_addr[15];
         }
         else{
-            m46e_inc_tunnel_v4_recv_unicast(handler->stat_info);
+            m46e_inc_tunnel_v4_recv_unicast(handler->stat_info, recv_len);
             // etherフレームのdstをIPv6のMACに書き換え
             memcpy(p_ether->h_dest, send_dev->hwaddr, ETH_ALEN);
         }
 
+        TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_HEADER);
+
         // 送信先IPv6アドレスのPMTUを取得
         int pmtu_size = m46e_path_mtu_get(handler->pmtud_handler, &p_ip6->ip6_dst);
 
+        TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_PMTU_LOOKUP);
+
         if(pmtu_size < 0){
             // 経路が見つからない(Network Unreachableを返すならここで)
         }
-        else if(pmtu_size < (ntohs(p_ip6->ip6_plen) + sizeof(struct ip6_hdr))){
+        else if((pmtu_size < (ntohs(p_ip6->ip6_plen) + sizeof(struct ip6_hdr))) &&
+                !m46e_path_mtu_probe(handler->pmtud_handler, &p_ip6->ip6_dst, ntohs(p_ip6->ip6_plen) + sizeof(struct ip6_hdr))){
+            // (PMTU拡大プローブとする場合はフラグメントせずにそのまま送信する)
             // 送信しようとしているIPv6パケットのサイズがPMTUのサイズを越える場合
             // IPv4パケットを分割して再カプセル化した上で送信する。
 
             // 元のIPv4パケットのフラグメントビットを取得
             uint16_t frag_df = ntohs(p_ip4->frag_off) & IP_DF;
 
+            if(handler->conf->general->fragment_mode == M46E_FRAGMENT_MODE_OUTER){
+                // 外側フラグメント方式の場合は、IPv4パケットを書き換えずに
+                // 外側のIPv6パケットをフラグメントして送信する(DFビットは対向で有効)
+                DEBUG_LOG("outer fragment.\n");
+                tunnel_send_outer_fragment_packet(handler, send_dev, p_ether, p_ip6, p_ip4, pmtu_size);
+            }
             // DFビットのチェック
-            if(frag_df == 0){
+            else if(frag_df == 0){
                 // DFビットが立っていないので、フラグメントして送信する
                 DEBUG_LOG("df=0 fragment.\n");
                 tunnel_send_fragment_packet(handler, send_dev, p_ether, p_ip6, p_ip4, pmtu_size);
@@ -656,7 +1005,11 @@ if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
                if(handler->conf->general->force_fragment){
                   // 強制フラグメント機能が有効の場合
                   // 元のIPv4パケットのDFビットを落とす
-                  p_ip4->frag_off = htons(~IP_DF & ntohs(p_ip4->frag_off));
+                  // (フラグメント時のチェックサムは元ヘッダからの差分で更新するので、
+                  //  ここでもチェックサムを合わせて更新しておく)
+                  uint16_t frag_off = htons(~IP_DF & ntohs(p_ip4->frag_off));
+                  p_ip4->check    = m46e_util_checksum_update(p_ip4->check, p_ip4->frag_off, frag_off);
+                  p_ip4->frag_off = frag_off;
                   DEBUG_LOG("df=0 fragment.\n");
                   tunnel_send_fragment_packet(handler, send_dev, p_ether, p_ip6, p_ip4, pmtu_size);
                 }
@@ -665,9 +1018,11 @@ if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
                   // DFビットが立っているのでFragment NeededのICMPエラーを返す
                   // 通知するMTUは(PMTU-IPv6ヘッダ長)とする(カプセル化するので)
                   DEBUG_LOG("df=1 send icmp err.\n");
-                  tunnel_send_frag_need_error(handler, p_ip4, pmtu_size-sizeof(struct ip6_hdr));
+                  tunnel_send_frag_need_error(handler, recv_dev, &orig_ether, p_ip4, pmtu_size-sizeof(struct ip6_hdr));
                }
            }
+
+            TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_FRAGMENT);
         }
         else{
             struct iovec iov[3];
@@ -682,19 +1037,144 @@ if(handler->conf->general->tunnel_mode == M46E_TUNNEL_MODE_NORMAL){
             if((send_len=writev(send_dev->option.tunnel.fd, iov, 3)) < 0){
                 m46e_logging(LOG_ERR, "fail to send IPv6 packet\n");
                 m46e_inc_tunnel_v4_send_err(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_SEND_ERR, recv_buffer, recv_len);
             }
             else{
                 DEBUG_LOG("forward %d bytes to IPv6\n", send_len);
-                m46e_inc_tunnel_v4_send_success(handler->stat_info);
+                m46e_inc_tunnel_v4_send_success(handler->stat_info, send_len);
             }
+
+            TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_WRITE);
+        }
+
+        if(as_frag_first){
+            // 先頭フラグメントより先に到着していたフラグメントを転送
+            tunnel_as_frag_hold_flush(handler, p_ip4, recv_dev, send_dev);
         }
     }
     else{
         // IPv4以外のパケットは、黙って破棄。
         DEBUG_LOG("Drop IPv4 Packet Ether Type : 0x%x\n", ntohs(p_ether->h_proto));
         m46e_inc_tunnel_v4_err_other_proto(handler->stat_info);
+        m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_OTHER_PROTO, recv_buffer, recv_len);
+    }
+
+    return;
+}
+
+//! 動作モード別のIPv4パケットカプセル化関数を定義する
+#define TUNNEL_ENCAP_DEFINE(name, mode)                                         \
+static void name(                                                               \
+    struct m46e_handler_t*   handler,                                          \
+    char*                     recv_buffer,                                      \
+    ssize_t                   recv_len,                                         \
+    m46e_device_t*           recv_dev,                                         \
+    m46e_device_t*           send_dev                                          \
+)                                                                               \
+{                                                                               \
+    tunnel_encap_ipv4_packet_body(handler, recv_buffer, recv_len, recv_dev, send_dev, mode); \
+}
+
+//! 通常モード専用のカプセル化関数
+TUNNEL_ENCAP_DEFINE(tunnel_encap_ipv4_packet_normal, M46E_TUNNEL_MODE_NORMAL)
+//! M46E-ASモード専用のカプセル化関数
+TUNNEL_ENCAP_DEFINE(tunnel_encap_ipv4_packet_as,     M46E_TUNNEL_MODE_AS)
+//! M46E-PRモード専用のカプセル化関数
+TUNNEL_ENCAP_DEFINE(tunnel_encap_ipv4_packet_pr,     M46E_TUNNEL_MODE_PR)
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4パケットカプセル化関数(動作モード不定時)
+//!
+//! 専用関数の無い動作モードの場合に、設定値の動作モードで処理する。
+//!
+//! @param [in,out] handler     M46Eハンドラ
+//! @param [in]     recv_buffer 受信パケットデータ
+//! @param [in]     recv_len    受信パケット長
+//! @param [in]     recv_dev    パケットを受信したデバイス
+//! @param [in]     send_dev    パケットを転送するデバイス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_encap_ipv4_packet_generic(
+    struct m46e_handler_t*   handler,
+    char*                     recv_buffer,
+    ssize_t                   recv_len,
+    m46e_device_t*           recv_dev,
+    m46e_device_t*           send_dev
+)
+{
+    tunnel_encap_ipv4_packet_body(handler, recv_buffer, recv_len, recv_dev, send_dev, handler->conf->general->tunnel_mode);
+
+    return;
+}
+
+//! IPv4パケットカプセル化関数の型
+typedef void (*tunnel_encap_func_t)(struct m46e_handler_t*, char*, ssize_t, m46e_device_t*, m46e_device_t*);
+
+//! 使用中のIPv4パケットカプセル化関数
+//! (他スレッドからの切り替えを考慮してアトミックに読み書きする)
+static tunnel_encap_func_t tunnel_encap_func = tunnel_encap_ipv4_packet_generic;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4パケットカプセル化関数選択関数
+//!
+//! 設定値の動作モードに対応する専用のカプセル化関数を選択する。<br/>
+//! 起動時と、動作モードに関わる設定の変更時に呼び出す。
+//!
+//! @param [in]     handler     M46Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_encap_select(struct m46e_handler_t* handler)
+{
+    // ローカル変数宣言
+    tunnel_encap_func_t func;
+
+    switch(handler->conf->general->tunnel_mode){
+    case M46E_TUNNEL_MODE_NORMAL:
+        func = tunnel_encap_ipv4_packet_normal;
+        break;
+    case M46E_TUNNEL_MODE_AS:
+        func = tunnel_encap_ipv4_packet_as;
+        break;
+    case M46E_TUNNEL_MODE_PR:
+        func = tunnel_encap_ipv4_packet_pr;
+        break;
+    default:
+        func = tunnel_encap_ipv4_packet_generic;
+        break;
     }
 
+    __atomic_store_n(&tunnel_encap_func, func, __ATOMIC_RELEASE);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4パケットカプセル化関数
+//!
+//! IPv4パケットを動作モード専用のカプセル化関数で処理する。<br/>
+//! (M46E-ASモードで保持していたフラグメントを再処理する場合は
+//!  受信済みとして計上済みのため、本関数を直接呼び出す)
+//!
+//! @param [in,out] handler     M46Eハンドラ
+//! @param [in]     recv_buffer 受信パケットデータ
+//! @param [in]     recv_len    受信パケット長
+//! @param [in]     recv_dev    パケットを受信したデバイス
+//! @param [in]     send_dev    パケットを転送するデバイス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_encap_ipv4_packet(
+    struct m46e_handler_t*   handler,
+    char*                     recv_buffer,
+    ssize_t                   recv_len,
+    m46e_device_t*           recv_dev,
+    m46e_device_t*           send_dev
+)
+{
+    __atomic_load_n(&tunnel_encap_func, __ATOMIC_ACQUIRE)(handler, recv_buffer, recv_len, recv_dev, send_dev);
+
     return;
 }
 
@@ -727,6 +1207,14 @@ static void tunnel_forward_ipv6_packet(
     in_addr_t       v4dhostaddr;
     struct ip6_hdr*   p_orig_hdr;
     struct icmp6_hdr* p_icmp6;
+    uint8_t*          payload;
+    size_t            payload_len;
+    size_t            offset;
+    uint8_t           nxt;
+    M46E_PROFILE_DECLARE(prof_last);
+
+    // ステージ別サイクル計測開始
+    M46E_PROFILE_START(prof_last);
 
     // ローカル変数初期化
     p_ether        = (struct ethhdr*)recv_buffer;
@@ -737,12 +1225,13 @@ static void tunnel_forward_ipv6_packet(
     v4dhostaddr    = INADDR_NONE;
 
     // 統計情報
-    m46e_inc_tunnel_v6_recieve(handler->stat_info);
+    m46e_inc_tunnel_v6_recieve(handler->stat_info, recv_len);
 
     if(m46e_util_is_broadcast_mac(&p_ether->h_dest[0])){
         // ブロードキャストパケットは黙って破棄
         DEBUG_LOG("drop packet so that recv packet is broadcast\n");
         m46e_inc_tunnel_v6_err_broadcast(handler->stat_info);
+        m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_BROADCAST, recv_buffer, recv_len);
         return;
     }
 
@@ -756,9 +1245,66 @@ static void tunnel_forward_ipv6_packet(
 
         p_ip6 = (struct ip6_hdr*)(recv_buffer + sizeof(struct ethhdr));
 
-        if(p_ip6->ip6_nxt == IPPROTO_IPIP){
+        // 拡張ヘッダを読み飛ばして上位層のヘッダを求める
+        nxt         = p_ip6->ip6_nxt;
+        payload     = (uint8_t*)(p_ip6 + 1);
+        payload_len = 0;
+        if(recv_len > (ssize_t)(sizeof(struct ethhdr) + sizeof(struct ip6_hdr))){
+            payload_len = min((size_t)ntohs(p_ip6->ip6_plen), recv_len - sizeof(struct ethhdr) - sizeof(struct ip6_hdr));
+        }
+        offset      = 0;
+        if(!m46e_util_ipv6_skip_exthdr(payload, payload_len, &nxt, &offset)){
+            // 拡張ヘッダが途中で切れているので破棄
+            nxt = IPPROTO_NONE;
+        }
+
+        if((nxt == IPPROTO_FRAGMENT) && (tunnel_reasm != NULL)){
+            // 外側のIPv6パケットがフラグメントされている場合は再構築する
+            m46e_inc_tunnel_v6_reasm_fragment(handler->stat_info);
+            m46e_add_tunnel_v6_reasm_timeout(handler->stat_info, m46e_reasm_expire(tunnel_reasm));
+
+            int result = M46E_REASM_ERROR;
+            if((offset + sizeof(struct ip6_frag)) <= payload_len){
+                struct ip6_frag* p_frag = (struct ip6_frag*)(payload + offset);
+                result = m46e_reasm_input(
+                    tunnel_reasm, p_ip6, p_frag,
+                    (uint8_t*)(p_frag + 1), payload_len - offset - sizeof(struct ip6_frag),
+                    &nxt, &payload, &payload_len
+                );
+            }
+
+            if(result == M46E_REASM_PENDING){
+                // 後続のフラグメント待ち
+                return;
+            }
+            else if(result == M46E_REASM_ERROR){
+                DEBUG_LOG("drop packet so that fragment is invalid or over limit.\n");
+                m46e_inc_tunnel_v6_err_reasm(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_REASM, recv_buffer, recv_len);
+                return;
+            }
+
+            // 再構築したデータのフラグメント可能部の拡張ヘッダを読み飛ばす
+            m46e_inc_tunnel_v6_reasm_success(handler->stat_info);
+            offset = 0;
+            if(!m46e_util_ipv6_skip_exthdr(payload, payload_len, &nxt, &offset)){
+                nxt = IPPROTO_NONE;
+            }
+        }
+
+        if(nxt == IPPROTO_IPIP){
+
+            p_ip4 = (struct iphdr*)(payload + offset);
 
-            p_ip4 = (struct iphdr*)(p_ip6+1);
+            // IPv4ヘッダ分のデータがあるかチェック
+            // (再構築したパケットのバッファはデータ長ちょうどの場合がある)
+            if(((payload_len - offset) < sizeof(struct iphdr)) ||
+               ((payload_len - offset) < (p_ip4->ihl * 4))){
+                DEBUG_LOG("drop packet so that inner IPv4 header is truncated.\n");
+                m46e_inc_tunnel_v6_err_nxthdr_count(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_NXTHDR, recv_buffer, recv_len);
+                return;
+            }
 
             // 送信先アドレスを保持
             v4dhostaddr      = ntohl(p_ip4->daddr);
@@ -772,6 +1318,7 @@ static void tunnel_forward_ipv6_packet(
                     // リンクローカルのマルチキャストなので黙って破棄
                     DEBUG_LOG("drop packet so that recv packet is link local multicast.\n");
                     m46e_inc_tunnel_v6_err_linklocal_multi(handler->stat_info);
+                    m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_LINKLOCAL_MULTI, recv_buffer, recv_len);
                     return;
                 }
             }
@@ -784,58 +1331,80 @@ static void tunnel_forward_ipv6_packet(
                 // TTLが1のパケットは黙って破棄(これ以上転送できない為)
                 DEBUG_LOG("drop packet so that ttl is 1.\n");
                 m46e_inc_tunnel_v6_err_ttl(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_TTL, recv_buffer, recv_len);
                 return;
             }
 
+            TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_PARSE);
+
             // etherフレームのプロトコルをIPv4に書き換え
             p_ether->h_proto = htons(ETH_P_IP);
             // etherフレームのsrcをIPv6のMACに書き換え
             memcpy(p_ether->h_source, recv_dev->hwaddr, ETH_ALEN);
             // etherフレームのdstを書き換え
             if(IN_MULTICAST(v4dhostaddr)){
-                m46e_inc_tunnel_v6_recv_multicast(handler->stat_info);
+                m46e_inc_tunnel_v6_recv_multicast(handler->stat_info, recv_len);
                 // etherフレームのdstをマルチキャストのMACに書き換え
                 ETHER_MAP_IP_MULTICAST(&v4dinaddr, p_ether->h_dest);
             }
             else{
                 // etherフレームのdstをIPv4のMACに書き換え
                 memcpy(p_ether->h_dest, send_dev->hwaddr, ETH_ALEN);
-                m46e_inc_tunnel_v6_recv_unicast(handler->stat_info);
+                m46e_inc_tunnel_v6_recv_unicast(handler->stat_info, recv_len);
             }
 
+            TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_HEADER);
+
             struct iovec iov[2];
             iov[0].iov_base = p_ether;
             iov[0].iov_len  = sizeof(struct ethhdr);
-            iov[1].iov_base = (p_ip6 + 1);
-            iov[1].iov_len  = ntohs(p_ip6->ip6_plen);
+            iov[1].iov_base = p_ip4;
+            iov[1].iov_len  = payload_len - offset;
 
             ssize_t send_len;
             if((send_len=writev(send_dev->option.tunnel.fd, iov, 2)) < 0){
                 m46e_logging(LOG_ERR, "fail to send IPv4 packet\n");
                 m46e_inc_tunnel_v6_send_v4_err(handler->stat_info);
+                m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_SEND_ERR, recv_buffer, recv_len);
             }
             else{
                 DEBUG_LOG("forward %d bytes to IPv4\n", send_len);
-                m46e_inc_tunnel_v6_send_v4_success(handler->stat_info);
+                m46e_inc_tunnel_v6_send_v4_success(handler->stat_info, send_len);
             }
+
+            TUNNEL_PROFILE_MARK(handler, prof_last, M46E_PROFILE_STAGE_WRITE);
         }
         // ICMPV6パケットの場合
-        else if(p_ip6->ip6_nxt == IPPROTO_ICMPV6){
+        else if(nxt == IPPROTO_ICMPV6){
             
-            p_icmp6 = (struct icmp6_hdr*)(p_ip6+1);
+            p_icmp6 = (struct icmp6_hdr*)(payload + offset);
 
             // ICMP6_PACKET_TOO_BIGの場合
             if(p_icmp6->icmp6_type == ICMP6_PACKET_TOO_BIG){
                 // Path MTU Discovery処理を実施
                 p_orig_hdr = (struct ip6_hdr *) (p_icmp6 + 1);
-                // socketでstub側に通知する
-                m46e_command_t command;
-                command.code = M46E_PACKET_TOO_BIG;
-                command.req.too_big.dst_addr = p_orig_hdr->ip6_dst;
-                command.req.too_big.mtu      = ntohl(p_icmp6->icmp6_mtu);
-                int ret = m46e_command_send_request(handler, &command);
-                if(ret < 0){
-                    DEBUG_LOG("send error : %s\n", strerror(-ret));
+                ssize_t icmp6_len = payload_len - offset;
+                if(!tunnel_check_ptb_valid(handler, p_icmp6, icmp6_len)){
+                    // 自装置がカプセル化したパケットに対する通知ではないので破棄
+                    DEBUG_LOG("drop invalid icmpv6 packet too big.\n");
+                    m46e_inc_icmp_pkt_toobig_invalid(handler->stat_info);
+                    m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_PTB_INVALID, recv_buffer, recv_len);
+                }
+                else if(tunnel_check_ptb_duplicate(&p_orig_hdr->ip6_dst, ntohl(p_icmp6->icmp6_mtu))){
+                    // 同一宛先/同一MTUの通知を直前に行っているので通知しない
+                    DEBUG_LOG("suppress duplicate icmpv6 packet too big.\n");
+                    m46e_inc_icmp_pkt_toobig_suppress(handler->stat_info);
+                }
+                else{
+                    // socketでstub側に通知する
+                    m46e_command_t command;
+                    command.code = M46E_PACKET_TOO_BIG;
+                    command.req.too_big.dst_addr = p_orig_hdr->ip6_dst;
+                    command.req.too_big.mtu      = ntohl(p_icmp6->icmp6_mtu);
+                    int ret = m46e_command_send_request(handler, &command);
+                    if(ret < 0){
+                        DEBUG_LOG("send error : %s\n", strerror(-ret));
+                    }
                 }
 
                 // 統計情報取得 ICMP err(TooBig)受信
@@ -851,107 +1420,525 @@ static void tunnel_forward_ipv6_packet(
             // 次ヘッダがIPIP以外(カプセル化されていないパケット)の場合、黙って破棄。
             DEBUG_LOG("drop packet so that recv packet is not ipip.\n");
             m46e_inc_tunnel_v6_err_nxthdr_count(handler->stat_info);
+            m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_NXTHDR, recv_buffer, recv_len);
         }
     }
     else{
         // IPv6以外のパケットは、黙って破棄。
         DEBUG_LOG("Drop IPv6 Packet Ether Type : %d\n", ntohs(p_ether->h_proto));
         m46e_inc_tunnel_v6_err_other_proto(handler->stat_info);
+        m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V6_OTHER_PROTO, recv_buffer, recv_len);
     }
 
     return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief IPv4パケットフラグメント関数
+//! @brief Packet Too Big妥当性チェック関数
 //!
-//! 受信したIPv4パケットをフラグメント化して、IPv6にカプセル化して転送する。
+//! 受信したPacket Too Bigが自装置でカプセル化したパケットに対する
+//! 通知かどうかを、引用されているオリジナルパケットのヘッダでチェックする。
+//! ・オリジナルパケットのIPv6ヘッダが全て含まれていること
+//! ・オリジナルパケットの次ヘッダがIPIPであること
+//! ・オリジナルパケットの送信元が自planeのM46E prefixであること
+//! ・MTU長がトンネルのMTU長、およびオリジナルパケット長より小さいこと
 //!
-//! @param [in]     handler     M46Eハンドラ
-//! @param [in]     send_dev    パケットを転送するデバイス
-//! @param [in]     p_ether     受信したIPv4パケットを元に構築したEtherヘッダ
-//! @param [in]     p_ip6       受信したIPv4パケットを元に構築したIPv6ヘッダ
-//! @param [in]     p_ip4       受信したIPv4パケット
-//! @param [in]     pmtu_size   IPv6送信先のPath MTU長
+//! @param [in]  handler    M46Eハンドラ
+//! @param [in]  p_icmp6    受信したICMPv6ヘッダ
+//! @param [in]  icmp6_len  受信したICMPv6メッセージ長
 //!
-//! @return なし
+//! @retval true   妥当
+//! @retval false  不正
 ///////////////////////////////////////////////////////////////////////////////
-static void tunnel_send_fragment_packet(
+static bool tunnel_check_ptb_valid(
     struct m46e_handler_t*  handler,
-    m46e_device_t*          send_dev,
-    struct ethhdr*           p_ether,
-    struct ip6_hdr*          p_ip6,
-    struct iphdr*            p_ip4,
-    const int                pmtu_size
+    const struct icmp6_hdr*  p_icmp6,
+    const ssize_t            icmp6_len
 )
 {
     // ローカル変数宣言
-    struct iovec iov[4];
+    const struct ip6_hdr*  p_orig_hdr;
+    uint32_t               mtu;
+    bool                   result;
 
-    // 引数チェック
-    if((send_dev == NULL) || (handler == NULL)){
-        return;
+    // 引用部分の長さチェック
+    if(icmp6_len < (ssize_t)(sizeof(struct icmp6_hdr) + sizeof(struct ip6_hdr))){
+        DEBUG_LOG("packet too big is too short. len = %d\n", icmp6_len);
+        return false;
     }
 
-    // Etherヘッダ
-    iov[0].iov_base = p_ether;
-    iov[0].iov_len  = sizeof(struct ethhdr);
-    // IPv6ヘッダ
-    iov[1].iov_base = p_ip6;
-    iov[1].iov_len  = sizeof(struct ip6_hdr);
-    // IPv4ヘッダ
-    iov[2].iov_base = p_ip4;
-    iov[2].iov_len  = p_ip4->ihl * 4;
+    p_orig_hdr = (const struct ip6_hdr*)(p_icmp6 + 1);
+    mtu        = ntohl(p_icmp6->icmp6_mtu);
 
-    // 元のIPv4パケットのMFビットを取得
-    uint16_t frag_mf = ntohs(p_ip4->frag_off) & IP_MF;
+    // 次ヘッダチェック
+    if(p_orig_hdr->ip6_nxt != IPPROTO_IPIP){
+        DEBUG_LOG("original packet is not ipip. nxt = %d\n", p_orig_hdr->ip6_nxt);
+        return false;
+    }
 
-    // フラグメントパケットのペイロードは8byte単位にすると決まっているので
-    // (pmtu-IPv6ヘッダ-IPv4ヘッダ)を8で割り切れる最大数を計算する
-    int max_payload_len = ((pmtu_size - iov[1].iov_len - iov[2].iov_len) & 0xfffffff8);
+    // 送信元プレフィックスチェック
+    switch(handler->conf->general->tunnel_mode){
+    case M46E_TUNNEL_MODE_NORMAL:
+        result = IS_EQUAL_M46E_PREFIX(&p_orig_hdr->ip6_src, &handler->unicast_prefix);
+        break;
+    case M46E_TUNNEL_MODE_AS:
+        result = IS_EQUAL_M46E_AS_PREFIX(&p_orig_hdr->ip6_src, &handler->unicast_prefix);
+        break;
+    case M46E_TUNNEL_MODE_PR:
+        // ユニキャストは送信元用prefix、マルチキャストはユニキャストprefixで送信している
+        result = IS_EQUAL_M46E_PR_PREFIX(&p_orig_hdr->ip6_src, &handler->src_addr_unicast_prefix)
+              || IS_EQUAL_M46E_PREFIX(&p_orig_hdr->ip6_src, &handler->unicast_prefix);
+        break;
+    default:
+        result = false;
+        break;
+    }
+    if(!result){
+        DEBUG_LOG("original packet source is not own prefix.\n");
+        return false;
+    }
 
-    // IPv4ペイロードのサイズと先頭ポインタを設定
-    int      remain_data_len = ntohs(p_ip4->tot_len) - iov[2].iov_len;
-    char*    data_ptr        = ((char*)iov[2].iov_base) + iov[2].iov_len;
-    uint16_t payload_offset  = 0;
+    // MTU長チェック
+    // (トンネルのMTU長以上、またはオリジナルパケット長以上の値は通知されることがない)
+    if((mtu == 0) || (mtu >= handler->conf->tunnel->ipv6.mtu) ||
+       (mtu >= (ntohs(p_orig_hdr->ip6_plen) + sizeof(struct ip6_hdr)))){
+        DEBUG_LOG("packet too big mtu is not plausible. mtu = %u\n", mtu);
+        return false;
+    }
 
-    while(remain_data_len > 0){
-        // 送信するペイロードのlength計算
-        int data_len = min(max_payload_len, remain_data_len);
+    return true;
+}
 
-        // IPv4ペイロードの先頭アドレスを設定
-        iov[3].iov_base = data_ptr + payload_offset;
-        iov[3].iov_len  = data_len;
+///////////////////////////////////////////////////////////////////////////////
+//! @brief Packet Too Big重複チェック関数
+//!
+//! 同一の送信先/MTU長のPacket Too Bigを抑止時間内に通知済みかどうかをチェックする。
+//! 通知済みでない場合は、抑止テーブルの該当エントリを今回の情報で更新する。
+//!
+//! @param [in]  dst_addr  オリジナルパケットの送信先アドレス
+//! @param [in]  mtu       ICMPメッセージ内のMTU長
+//!
+//! @retval true   重複している(通知不要)
+//! @retval false  重複していない(通知要)
+///////////////////////////////////////////////////////////////////////////////
+static bool tunnel_check_ptb_duplicate(const struct in6_addr* dst_addr, const int mtu)
+{
+    // ローカル変数宣言
+    struct tunnel_ptb_cache_entry* entry;
+    struct timespec                now;
+    uint32_t                       hash;
+    long                           elapsed;
+
+    // 送信先アドレスからエントリを決定
+    hash = dst_addr->s6_addr32[0] ^ dst_addr->s6_addr32[1]
+         ^ dst_addr->s6_addr32[2] ^ dst_addr->s6_addr32[3];
+    hash ^= (hash >> 16);
+    hash ^= (hash >> 8);
+    entry = &tunnel_ptb_cache[hash & (TUNNEL_PTB_CACHE_SIZE - 1)];
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if((entry->mtu == mtu) && IN6_ARE_ADDR_EQUAL(&entry->dst_addr, dst_addr)){
+        elapsed = (now.tv_sec  - entry->recv_time.tv_sec) * 1000
+                + (now.tv_nsec - entry->recv_time.tv_nsec) / 1000000;
+        if(elapsed < TUNNEL_PTB_COALESCE_MSEC){
+            return true;
+        }
+    }
 
-        // IPv4ヘッダを書き換え
-        // (フラグメントビットの設定とパケットサイズ、チェックサムの変更)
-        p_ip4->tot_len = htons(iov[2].iov_len + iov[3].iov_len);
+    // エントリを更新
+    entry->dst_addr  = *dst_addr;
+    entry->mtu       = mtu;
+    entry->recv_time = now;
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経過時間算出関数
+//!
+//! 2つの時刻の差をミリ秒単位で算出する。
+//!
+//! @param [in]  from  開始時刻
+//! @param [in]  now   現在時刻
+//!
+//! @return 経過時間(ミリ秒)
+///////////////////////////////////////////////////////////////////////////////
+static inline long tunnel_elapsed_msec(const struct timespec* from, const struct timespec* now)
+{
+    return (now->tv_sec  - from->tv_sec) * 1000
+         + (now->tv_nsec - from->tv_nsec) / 1000000;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief フラグメントフローキャッシュエントリ取得関数
+//!
+//! IPv4ヘッダの(送信元, 送信先, プロトコル, Identification)から
+//! M46E-ASモードのフラグメントフローキャッシュのエントリを決定する。
+//!
+//! @param [in]  p_ip4  IPv4ヘッダ
+//!
+//! @return 該当するキャッシュエントリ
+///////////////////////////////////////////////////////////////////////////////
+static struct tunnel_as_frag_entry* tunnel_as_frag_entry_get(const struct iphdr* p_ip4)
+{
+    // ローカル変数宣言
+    uint32_t hash;
+
+    hash = p_ip4->saddr ^ p_ip4->daddr ^ ((uint32_t)p_ip4->id << 8) ^ p_ip4->protocol;
+    hash *= 2654435761u;
+
+    return &tunnel_as_frag_cache[(hash >> 16) & (TUNNEL_AS_FRAG_CACHE_SIZE - 1)];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief フラグメントフローキャッシュ登録関数
+//!
+//! 先頭フラグメントから取得したポート番号をフラグメントフローキャッシュに登録する。
+//! (同じエントリを使用している古いフローは上書きする)
+//!
+//! @param [in]  p_ip4  先頭フラグメントのIPv4ヘッダ
+//! @param [in]  sport  送信元ポート番号(ネットワークバイトオーダー)
+//! @param [in]  dport  送信先ポート番号(ネットワークバイトオーダー)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_as_frag_register(const struct iphdr* p_ip4, const uint16_t sport, const uint16_t dport)
+{
+    // ローカル変数宣言
+    struct tunnel_as_frag_entry* entry;
+
+    entry = tunnel_as_frag_entry_get(p_ip4);
+
+    entry->saddr    = p_ip4->saddr;
+    entry->daddr    = p_ip4->daddr;
+    entry->id       = p_ip4->id;
+    entry->protocol = p_ip4->protocol;
+    entry->sport    = sport;
+    entry->dport    = dport;
+    entry->valid    = true;
+    clock_gettime(CLOCK_MONOTONIC, &entry->recv_time);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief フラグメントフローキャッシュ検索関数
+//!
+//! 後続フラグメントのIPv4ヘッダに該当するポート番号をフラグメントフローキャッシュから取得する。
+//! 保持時間を超過したエントリは無効とする。
+//!
+//! @param [in]  p_ip4  後続フラグメントのIPv4ヘッダ
+//! @param [out] sport  送信元ポート番号格納先
+//! @param [out] dport  送信先ポート番号格納先
+//!
+//! @retval true   キャッシュヒット
+//! @retval false  キャッシュミス
+///////////////////////////////////////////////////////////////////////////////
+static bool tunnel_as_frag_lookup(const struct iphdr* p_ip4, uint16_t* sport, uint16_t* dport)
+{
+    // ローカル変数宣言
+    struct tunnel_as_frag_entry* entry;
+    struct timespec              now;
+
+    entry = tunnel_as_frag_entry_get(p_ip4);
+
+    if(!entry->valid ||
+       (entry->saddr != p_ip4->saddr) || (entry->daddr != p_ip4->daddr) ||
+       (entry->id != p_ip4->id) || (entry->protocol != p_ip4->protocol)){
+        return false;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(tunnel_elapsed_msec(&entry->recv_time, &now) >= TUNNEL_AS_FRAG_CACHE_MSEC){
+        entry->valid = false;
+        return false;
+    }
+
+    *sport = entry->sport;
+    *dport = entry->dport;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 先頭フラグメント待ちフラグメント期限切れ処理関数
+//!
+//! 保持時間内に先頭フラグメントが到着しなかったフラグメントを破棄する。
+//!
+//! @param [in]  handler  M46Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_as_frag_hold_expire(struct m46e_handler_t* handler)
+{
+    // ローカル変数宣言
+    struct timespec now;
+    int             i;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for(i = 0; i < TUNNEL_AS_FRAG_HOLD_NUM; i++){
+        struct tunnel_as_frag_hold* hold = &tunnel_as_frag_hold[i];
+        if(hold->buffer == NULL){
+            continue;
+        }
+        if(tunnel_elapsed_msec(&hold->recv_time, &now) < TUNNEL_AS_FRAG_HOLD_MSEC){
+            continue;
+        }
+
+        DEBUG_LOG("drop packet so that first fragment did not arrive.\n");
+        m46e_inc_tunnel_v4_err_as_fragment(handler->stat_info);
+        m46e_statistics_trace_drop(handler->stat_info, M46E_DROP_V4_AS_FRAGMENT, hold->buffer, hold->len);
+        free(hold->buffer);
+        hold->buffer = NULL;
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 先頭フラグメント待ちフラグメント保持関数
+//!
+//! 先頭フラグメントより先に到着したフラグメントを複製して保持する。
+//!
+//! @param [in]  handler      M46Eハンドラ
+//! @param [in]  recv_buffer  受信パケットデータ
+//! @param [in]  recv_len     受信パケット長
+//!
+//! @retval true   保持した
+//! @retval false  保持領域が無い(呼び出し元で破棄する)
+///////////////////////////////////////////////////////////////////////////////
+static bool tunnel_as_frag_hold_add(struct m46e_handler_t* handler, const char* recv_buffer, const ssize_t recv_len)
+{
+    // ローカル変数宣言
+    struct tunnel_as_frag_hold* hold;
+    int                         i;
+
+    // 期限切れのフラグメントを先に破棄して空きを作る
+    tunnel_as_frag_hold_expire(handler);
+
+    hold = NULL;
+    for(i = 0; i < TUNNEL_AS_FRAG_HOLD_NUM; i++){
+        if(tunnel_as_frag_hold[i].buffer == NULL){
+            hold = &tunnel_as_frag_hold[i];
+            break;
+        }
+    }
+    if(hold == NULL){
+        return false;
+    }
+
+    hold->buffer = malloc(recv_len);
+    if(hold->buffer == NULL){
+        return false;
+    }
+    memcpy(hold->buffer, recv_buffer, recv_len);
+    hold->len = recv_len;
+    clock_gettime(CLOCK_MONOTONIC, &hold->recv_time);
+
+    DEBUG_LOG("hold fragment until first fragment arrives.\n");
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 先頭フラグメント待ちフラグメント送信関数
+//!
+//! 先頭フラグメントの転送後に、同じパケットの保持していたフラグメントを
+//! カプセル化して転送する。
+//!
+//! @param [in]  handler   M46Eハンドラ
+//! @param [in]  p_ip4     先頭フラグメントのIPv4ヘッダ
+//! @param [in]  recv_dev  パケットを受信したデバイス
+//! @param [in]  send_dev  パケットを転送するデバイス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_as_frag_hold_flush(
+    struct m46e_handler_t*  handler,
+    const struct iphdr*      p_ip4,
+    m46e_device_t*          recv_dev,
+    m46e_device_t*          send_dev
+)
+{
+    // ローカル変数宣言
+    uint32_t saddr;
+    uint32_t daddr;
+    uint16_t id;
+    uint8_t  protocol;
+    int      i;
+
+    // 転送処理でヘッダが書き換わる前にキーを退避
+    saddr    = p_ip4->saddr;
+    daddr    = p_ip4->daddr;
+    id       = p_ip4->id;
+    protocol = p_ip4->protocol;
+
+    tunnel_as_frag_hold_expire(handler);
+
+    for(i = 0; i < TUNNEL_AS_FRAG_HOLD_NUM; i++){
+        struct tunnel_as_frag_hold* hold = &tunnel_as_frag_hold[i];
+        if(hold->buffer == NULL){
+            continue;
+        }
+
+        struct iphdr* p_hold_ip4 = (struct iphdr*)(hold->buffer + sizeof(struct ethhdr));
+        if((p_hold_ip4->saddr != saddr) || (p_hold_ip4->daddr != daddr) ||
+           (p_hold_ip4->id != id) || (p_hold_ip4->protocol != protocol)){
+            continue;
+        }
+
+        // 保持領域から外してから転送する
+        char*   buffer = hold->buffer;
+        ssize_t len    = hold->len;
+        hold->buffer   = NULL;
+
+        DEBUG_LOG("forward held fragment.\n");
+        tunnel_encap_ipv4_packet(handler, buffer, len, recv_dev, send_dev);
+        free(buffer);
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 先頭フラグメント待ちフラグメント解放関数
+//!
+//! 保持しているフラグメントを全て解放する。
+//! スレッドの終了時に呼ばれる。
+//!
+//! @param [in] arg       未使用
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_as_frag_hold_cleanup(void* arg)
+{
+    // ローカル変数宣言
+    int i;
+
+    for(i = 0; i < TUNNEL_AS_FRAG_HOLD_NUM; i++){
+        free(tunnel_as_frag_hold[i].buffer);
+        tunnel_as_frag_hold[i].buffer = NULL;
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4パケットフラグメント関数
+//!
+//! 受信したIPv4パケットをフラグメント化して、IPv6にカプセル化して転送する。<br/>
+//! 全フラグメントをフラグメントバッチに組み立ててから書き込み、統計情報をまとめて計上する。<br/>
+//! 統計情報は全フラグメントの書き込みに成功した場合のみ成功として計上する。
+//!
+//! @param [in]     handler     M46Eハンドラ
+//! @param [in]     send_dev    パケットを転送するデバイス
+//! @param [in]     p_ether     受信したIPv4パケットを元に構築したEtherヘッダ
+//! @param [in]     p_ip6       受信したIPv4パケットを元に構築したIPv6ヘッダ
+//! @param [in]     p_ip4       受信したIPv4パケット
+//! @param [in]     pmtu_size   IPv6送信先のPath MTU長
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_send_fragment_packet(
+    struct m46e_handler_t*  handler,
+    m46e_device_t*          send_dev,
+    struct ethhdr*           p_ether,
+    struct ip6_hdr*          p_ip6,
+    struct iphdr*            p_ip4,
+    const int                pmtu_size
+)
+{
+    // ローカル変数宣言
+    tunnel_frag_batch_t batch;
+
+    // 引数チェック
+    if((send_dev == NULL) || (handler == NULL)){
+        return;
+    }
+
+    int ip4_hdr_len = p_ip4->ihl * 4;
+
+    // 元のIPv4パケットのMFビットを取得
+    uint16_t frag_mf = ntohs(p_ip4->frag_off) & IP_MF;
+
+    // フラグメントパケットのペイロードは8byte単位にすると決まっているので
+    // (pmtu-IPv6ヘッダ-IPv4ヘッダ)を8で割り切れる最大数を計算する
+    int max_payload_len = ((pmtu_size - (int)sizeof(struct ip6_hdr) - ip4_hdr_len) & 0xfffffff8);
+
+    // IPv4ペイロードのサイズと先頭ポインタを設定
+    int      remain_data_len = ntohs(p_ip4->tot_len) - ip4_hdr_len;
+    char*    data_ptr        = ((char*)p_ip4) + ip4_hdr_len;
+    uint16_t payload_offset  = 0;
+
+    // 送信前に分割数を確認し、バッチに収まらない場合は1個も送信しない
+    if((max_payload_len <= 0) ||
+       (((remain_data_len + max_payload_len - 1) / max_payload_len) > TUNNEL_FRAG_BATCH_MAX)){
+        m46e_logging(LOG_ERR, "fail to fragment IPv6 packet (pmtu=%d, len=%d)\n", pmtu_size, ntohs(p_ip4->tot_len));
+        m46e_inc_tunnel_v4_send_fragment_err(handler->stat_info);
+        return;
+    }
+
+    // 後続データがあるフラグメントのパケットサイズは全て同じなので先に求めておく
+    uint16_t full_tot_len    = htons(ip4_hdr_len + max_payload_len);
+
+    // 後続データがあるフラグメントは共通のIPv6ヘッダを使用する
+    batch.ip6_full          = *p_ip6;
+    batch.ip6_full.ip6_plen = full_tot_len;
+    batch.num               = 0;
+
+    while(remain_data_len > 0){
+        // 送信するペイロードのlength計算
+        int             data_len = min(max_payload_len, remain_data_len);
+        struct iovec*   iov      = batch.iov[batch.num];
+        struct iphdr*   frag_ip4 = (struct iphdr*)batch.hdr[batch.num];
+        uint16_t        tot_len;
+        uint16_t        frag_off;
+
+        // IPv4ヘッダを書き換え
+        // (フラグメントビットの設定とパケットサイズ、チェックサムの変更)
         if(data_len < remain_data_len){
             // 後続データがある場合は、MFビットを立てる
-            p_ip4->frag_off = htons(IP_MF  | (payload_offset >> 3));
+            tot_len  = full_tot_len;
+            frag_off = htons(IP_MF  | (payload_offset >> 3));
         }
         else{
             // 後続データがない場合は、元のパケットのMFビットを継承
-            p_ip4->frag_off = htons(frag_mf | (payload_offset >> 3));
+            tot_len  = htons(ip4_hdr_len + data_len);
+            frag_off = htons(frag_mf | (payload_offset >> 3));
         }
-        p_ip4->check = 0;
-        // チェックサムの再計算
-        p_ip4->check = m46e_util_checksum((unsigned short*)p_ip4, iov[2].iov_len);
 
-        // IPv6ヘッダのペイロード長を変更
-        p_ip6->ip6_plen = p_ip4->tot_len;
-
-        // 分割したパケットを送信
-        ssize_t send_len;
-        if((send_len=writev(send_dev->option.tunnel.fd, iov, 4)) < 0){
-            m46e_logging(LOG_ERR, "fail to send IPv6 packet(fragment) :");
-            m46e_inc_tunnel_v4_send_fragment_err(handler->stat_info);
-            return;
+        // IPv4ヘッダの書き換えはtot_lenとfrag_offのみなので、
+        // チェックサムはヘッダ全体を再計算せずに変更したワードの差分で更新する
+        memcpy(frag_ip4, p_ip4, ip4_hdr_len);
+        frag_ip4->check    = m46e_util_checksum_update(p_ip4->check, p_ip4->tot_len, tot_len);
+        frag_ip4->check    = m46e_util_checksum_update(frag_ip4->check, p_ip4->frag_off, frag_off);
+        frag_ip4->tot_len  = tot_len;
+        frag_ip4->frag_off = frag_off;
+
+        // Etherヘッダ
+        iov[0].iov_base = p_ether;
+        iov[0].iov_len  = sizeof(struct ethhdr);
+        // IPv6ヘッダ
+        if(tot_len == full_tot_len){
+            iov[1].iov_base = &batch.ip6_full;
         }
         else{
-            DEBUG_LOG("forward %d bytes to IPv6(fragment)\n", send_len);
-            m46e_inc_tunnel_v4_send_fragment_success(handler->stat_info);
+            // 最後のフラグメントは受信パケットのIPv6ヘッダを書き換えて使用する
+            p_ip6->ip6_plen = tot_len;
+            iov[1].iov_base = p_ip6;
         }
+        iov[1].iov_len  = sizeof(struct ip6_hdr);
+        // IPv4ヘッダ
+        iov[2].iov_base = frag_ip4;
+        iov[2].iov_len  = ip4_hdr_len;
+        // IPv4ペイロード
+        iov[3].iov_base = data_ptr + payload_offset;
+        iov[3].iov_len  = data_len;
+
+        batch.len[batch.num] = sizeof(struct ethhdr) + sizeof(struct ip6_hdr) + ip4_hdr_len + data_len;
+        batch.num++;
 
         // 残りペイロードを減算
         remain_data_len -= data_len;
@@ -960,6 +1947,171 @@ static void tunnel_send_fragment_packet(
         payload_offset += data_len;
     }
 
+    // 分割したパケットを書き込み、統計情報をまとめて計上
+    tunnel_write_frag_batch(handler, send_dev, &batch);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6パケット外側フラグメント関数
+//!
+//! 受信したIPv4パケットをIPv6にカプセル化し、IPv6 Fragmentヘッダを付与して
+//! 外側のIPv6パケットをフラグメント化して転送する。(RFC2473)<br/>
+//! 内側のIPv4パケットは書き換えないため、フラグメント毎の処理は
+//! 固定長のIPv6 Fragmentヘッダの生成のみとなる。
+//!
+//! @param [in]     handler     M46Eハンドラ
+//! @param [in]     send_dev    パケットを転送するデバイス
+//! @param [in]     p_ether     受信したIPv4パケットを元に構築したEtherヘッダ
+//! @param [in]     p_ip6       受信したIPv4パケットを元に構築したIPv6ヘッダ
+//! @param [in]     p_ip4       受信したIPv4パケット
+//! @param [in]     pmtu_size   IPv6送信先のPath MTU長
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_send_outer_fragment_packet(
+    struct m46e_handler_t*  handler,
+    m46e_device_t*          send_dev,
+    struct ethhdr*           p_ether,
+    struct ip6_hdr*          p_ip6,
+    struct iphdr*            p_ip4,
+    const int                pmtu_size
+)
+{
+    // ローカル変数宣言
+    tunnel_frag_batch_t batch;
+
+    // 引数チェック
+    if((send_dev == NULL) || (handler == NULL)){
+        return;
+    }
+
+    // フラグメントのデータ部は8byte単位にすると決まっているので
+    // (pmtu-IPv6ヘッダ-Fragmentヘッダ)を8で割り切れる最大数を計算する
+    int max_payload_len = ((pmtu_size - (int)sizeof(struct ip6_hdr) - (int)sizeof(struct ip6_frag)) & 0xfffffff8);
+
+    // 内側のIPv4パケット全体をフラグメント対象とする
+    int      remain_data_len = ntohs(p_ip4->tot_len);
+    char*    data_ptr        = (char*)p_ip4;
+    uint16_t payload_offset  = 0;
+
+    // 送信前に分割数を確認し、バッチに収まらない場合は1個も送信しない
+    if((max_payload_len <= 0) ||
+       (((remain_data_len + max_payload_len - 1) / max_payload_len) > TUNNEL_FRAG_BATCH_MAX)){
+        m46e_logging(LOG_ERR, "fail to fragment IPv6 packet (pmtu=%d, len=%d)\n", pmtu_size, remain_data_len);
+        m46e_inc_tunnel_v4_send_fragment_err(handler->stat_info);
+        return;
+    }
+
+    // 後続データがあるフラグメントのペイロード長は全て同じなので先に求めておく
+    uint16_t full_plen = htons(sizeof(struct ip6_frag) + max_payload_len);
+    uint32_t ident     = htonl(tunnel_frag_ident++);
+
+    // 後続データがあるフラグメントは共通のIPv6ヘッダを使用する
+    p_ip6->ip6_nxt          = IPPROTO_FRAGMENT;
+    batch.ip6_full          = *p_ip6;
+    batch.ip6_full.ip6_plen = full_plen;
+    batch.num               = 0;
+
+    while(remain_data_len > 0){
+        // 送信するデータのlength計算
+        int              data_len = min(max_payload_len, remain_data_len);
+        struct iovec*    iov      = batch.iov[batch.num];
+        struct ip6_frag* frag     = (struct ip6_frag*)batch.hdr[batch.num];
+
+        // Fragmentヘッダを設定
+        frag->ip6f_nxt      = IPPROTO_IPIP;
+        frag->ip6f_reserved = 0;
+        frag->ip6f_ident    = ident;
+        if(data_len < remain_data_len){
+            // 後続データがある場合は、Mフラグを立てる
+            frag->ip6f_offlg = htons(payload_offset) | IP6F_MORE_FRAG;
+        }
+        else{
+            frag->ip6f_offlg = htons(payload_offset);
+        }
+
+        // Etherヘッダ
+        iov[0].iov_base = p_ether;
+        iov[0].iov_len  = sizeof(struct ethhdr);
+        // IPv6ヘッダ
+        if(data_len < remain_data_len){
+            iov[1].iov_base = &batch.ip6_full;
+        }
+        else{
+            // 最後のフラグメントは受信パケットのIPv6ヘッダを書き換えて使用する
+            p_ip6->ip6_plen = htons(sizeof(struct ip6_frag) + data_len);
+            iov[1].iov_base = p_ip6;
+        }
+        iov[1].iov_len  = sizeof(struct ip6_hdr);
+        // Fragmentヘッダ
+        iov[2].iov_base = frag;
+        iov[2].iov_len  = sizeof(struct ip6_frag);
+        // IPv4パケットの分割データ
+        iov[3].iov_base = data_ptr + payload_offset;
+        iov[3].iov_len  = data_len;
+
+        batch.len[batch.num] = sizeof(struct ethhdr) + sizeof(struct ip6_hdr) + sizeof(struct ip6_frag) + data_len;
+        batch.num++;
+
+        // 残りデータを減算
+        remain_data_len -= data_len;
+
+        // データのオフセットを加算
+        payload_offset += data_len;
+    }
+
+    // 分割したパケットを書き込み、統計情報をまとめて計上
+    tunnel_write_frag_batch(handler, send_dev, &batch);
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief フラグメントバッチ 書き込み関数
+//!
+//! バッチに格納したフラグメントを先頭から順に1個ずつwritevで書き込む。<br/>
+//! TAPデバイスは1回の書き込みで1フレームしか受け付けないため、一括送信はしない。
+//! 書き込みに失敗した時点で残りのフラグメントは破棄するが、
+//! 書き込み済みのフラグメントは取り消せない(送信済みとなる)。<br/>
+//! まとめておこなうのは統計情報の計上のみで、一部のフラグメントだけでは
+//! 再構築できないので、全フラグメントの書き込みに成功した場合のみ成功として計上する。
+//!
+//! @param [in]     handler     M46Eハンドラ
+//! @param [in]     send_dev    パケットを転送するデバイス
+//! @param [in]     batch       フラグメントバッチ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_write_frag_batch(
+    struct m46e_handler_t*  handler,
+    m46e_device_t*          send_dev,
+    tunnel_frag_batch_t*    batch
+)
+{
+    // ローカル変数宣言
+    int i;
+
+    for(i = 0; i < batch->num; i++){
+        ssize_t send_len = writev(send_dev->option.tunnel.fd, batch->iov[i], TUNNEL_FRAG_IOV_NUM);
+        if(send_len != (ssize_t)batch->len[i]){
+            if(send_len < 0){
+                m46e_logging(LOG_ERR, "fail to send IPv6 packet(fragment) %d/%d : %s\n", i, batch->num, strerror(errno));
+            }
+            else{
+                m46e_logging(LOG_ERR, "fail to send IPv6 packet(fragment) %d/%d : short write %zd\n", i, batch->num, send_len);
+            }
+            m46e_inc_tunnel_v4_send_fragment_err(handler->stat_info);
+            return;
+        }
+    }
+
+    for(i = 0; i < batch->num; i++){
+        DEBUG_LOG("forward %zu bytes to IPv6(fragment)\n", batch->len[i]);
+        m46e_inc_tunnel_v4_send_fragment_success(handler->stat_info, batch->len[i]);
+    }
+
     return;
 }
 
@@ -981,14 +2133,18 @@ static void tunnel_send_fragment_packet(
 //! @endcode
 //!
 //!
-//! @param [in]  handler       M46Eハンドラ
-//! @param [in]  original_ip4  Fragment Needed送信のトリガとなったIPv4パケット
-//! @param [in]  next_mtu      Nexthop MTUの値(IPv6 PMTUからIPv6ヘッダ長を引いた値)
+//! @param [in]  handler         M46Eハンドラ
+//! @param [in]  recv_dev        パケットを受信したデバイス
+//! @param [in]  original_ether  Fragment Needed送信のトリガとなったフレームのEtherヘッダ
+//! @param [in]  original_ip4    Fragment Needed送信のトリガとなったIPv4パケット
+//! @param [in]  next_mtu        Nexthop MTUの値(IPv6 PMTUからIPv6ヘッダ長を引いた値)
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
 static void tunnel_send_frag_need_error(
     struct m46e_handler_t* handler,
+    m46e_device_t*         recv_dev,
+    const struct ethhdr*    original_ether,
     struct iphdr*           original_ip4,
     const uint16_t          next_mtu
 )
@@ -1005,9 +2161,10 @@ static void tunnel_send_frag_need_error(
         return;
     }
 
-    int fd = socket(PF_INET, SOCK_RAW, IPPROTO_ICMP);
-    if (fd < 0) {
-        m46e_logging(LOG_WARNING, "fail to send Fragment Needed packet : %s\n", strerror(errno));
+    // 送信レート制限
+    if(!tunnel_frag_need_rate_check(original_ip4->saddr)){
+        DEBUG_LOG("suppress Fragment Needed packet by rate limit\n");
+        m46e_inc_icmp_frag_needed_suppress(handler->stat_info);
         return;
     }
 
@@ -1027,6 +2184,21 @@ static void tunnel_send_frag_need_error(
     iov[1].iov_len  = (original_ip4->ihl*4) + 8;
     icmp_header.checksum = m46e_util_checksumv(iov, 2);
 
+    if(handler->conf->general->icmp_inject){
+        // 受信したIPv4トンネルデバイスに直接書き込む
+        tunnel_inject_icmp_error(handler, recv_dev, original_ether, original_ip4, iov);
+        return;
+    }
+
+    // 送信用ソケットは初回送信時にオープンして使い回す
+    if(tunnel_frag_need_fd < 0){
+        tunnel_frag_need_fd = socket(PF_INET, SOCK_RAW, IPPROTO_ICMP);
+        if(tunnel_frag_need_fd < 0){
+            m46e_logging(LOG_WARNING, "fail to send Fragment Needed packet : %s\n", strerror(errno));
+            return;
+        }
+    }
+
     // 送信先アドレス設定
     struct sockaddr_in sin;
     memset(&sin, 0, sizeof(struct sockaddr_in));
@@ -1046,7 +2218,7 @@ static void tunnel_send_frag_need_error(
 
     // パケット送信
     ssize_t send_len;
-    if((send_len=sendmsg(fd, &msg, 0)) < 0){
+    if((send_len=sendmsg(tunnel_frag_need_fd, &msg, 0)) < 0){
         m46e_logging(LOG_ERR, "fail to send Fragment Needed packet : %s\n", strerror(errno));
         m46e_inc_icmp_frag_needed_send_err(handler->stat_info);
     }
@@ -1054,11 +2226,169 @@ static void tunnel_send_frag_need_error(
         DEBUG_LOG("sent Fragment Needed packet\n");
         m46e_inc_icmp_frag_needed_send_success(handler->stat_info);
     }
-    close(fd);
 
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ICMPエラーフレーム書き込み関数
+//!
+//! ICMPエラーメッセージにIPv4ヘッダとEtherヘッダを付加したフレームを組み立てて、
+//! トリガとなったパケットを受信したIPv4トンネルデバイスに書き込む。<br/>
+//! 送信元アドレスはトリガとなったパケットの送信先アドレスとする。
+//! (Stub側ネットワーク空間のカーネルは自アドレスを送信元とするパケットを
+//!  受信時に破棄するため)
+//!
+//! @param [in]  handler         M46Eハンドラ
+//! @param [in]  recv_dev        パケットを受信したデバイス
+//! @param [in]  original_ether  ICMPエラー送信のトリガとなったフレームのEtherヘッダ
+//! @param [in]  original_ip4    ICMPエラー送信のトリガとなったIPv4パケット
+//! @param [in]  icmp_iov        チェックサム計算済みのICMPメッセージ(ICMPヘッダ/元パケットの2要素)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_inject_icmp_error(
+    struct m46e_handler_t*  handler,
+    m46e_device_t*          recv_dev,
+    const struct ethhdr*     original_ether,
+    const struct iphdr*      original_ip4,
+    struct iovec*            icmp_iov
+)
+{
+    // ローカル変数宣言
+    struct ethhdr  ether_header;
+    struct iphdr   ip4_header;
+    struct iovec   iov[TUNNEL_FRAG_IOV_NUM];
+    size_t         frame_len;
+    ssize_t        send_len;
+
+    // Etherヘッダ設定(受信したフレームの送信元/送信先を入れ替える)
+    memcpy(ether_header.h_dest,   original_ether->h_source, ETH_ALEN);
+    memcpy(ether_header.h_source, original_ether->h_dest,   ETH_ALEN);
+    ether_header.h_proto = htons(ETH_P_IP);
+
+    // IPv4ヘッダ設定
+    memset(&ip4_header, 0, sizeof(struct iphdr));
+    ip4_header.version  = 4;
+    ip4_header.ihl      = sizeof(struct iphdr) / 4;
+    ip4_header.tos      = IPTOS_PREC_INTERNETCONTROL;
+    ip4_header.tot_len  = htons(sizeof(struct iphdr) + icmp_iov[0].iov_len + icmp_iov[1].iov_len);
+    ip4_header.ttl      = IPDEFTTL;
+    ip4_header.protocol = IPPROTO_ICMP;
+    ip4_header.saddr    = original_ip4->daddr;
+    ip4_header.daddr    = original_ip4->saddr;
+    ip4_header.check    = m46e_util_checksum((unsigned short*)&ip4_header, sizeof(struct iphdr));
+
+    // フラグメント送信と同じEther/IP/ヘッダ/ペイロードの構成で1フレームとして書き込む
+    iov[0].iov_base = &ether_header;
+    iov[0].iov_len  = sizeof(struct ethhdr);
+    iov[1].iov_base = &ip4_header;
+    iov[1].iov_len  = sizeof(struct iphdr);
+    iov[2]          = icmp_iov[0];
+    iov[3]          = icmp_iov[1];
+    frame_len       = sizeof(struct ethhdr) + ntohs(ip4_header.tot_len);
+
+    send_len = writev(recv_dev->option.tunnel.fd, iov, TUNNEL_FRAG_IOV_NUM);
+    if(send_len != (ssize_t)frame_len){
+        if(send_len < 0){
+            m46e_logging(LOG_ERR, "fail to inject Fragment Needed packet : %s\n", strerror(errno));
+        }
+        else{
+            m46e_logging(LOG_ERR, "fail to inject Fragment Needed packet : short write %zd\n", send_len);
+        }
+        m46e_inc_icmp_frag_needed_send_err(handler->stat_info);
+    }
+    else{
+        DEBUG_LOG("injected Fragment Needed packet\n");
+        m46e_inc_icmp_frag_needed_send_success(handler->stat_info);
+    }
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief トークンバケット補充関数
+//!
+//! 前回補充時刻からの経過時間に応じてトークンを補充する。
+//!
+//! @param [in,out] bucket  トークンバケット
+//! @param [in]     rate    1秒あたりの補充トークン数
+//! @param [in]     burst   最大トークン数
+//! @param [in]     now     現在時刻
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tunnel_token_bucket_refill(
+    struct tunnel_token_bucket* bucket,
+    const long                  rate,
+    const long                  burst,
+    const struct timespec*      now
+)
+{
+    // ローカル変数宣言
+    long elapsed;
+
+    if((now->tv_sec - bucket->update_time.tv_sec) >= (burst / rate + 1)){
+        // 満タンになるだけの時間が経過している場合
+        bucket->tokens = burst * TUNNEL_TOKEN_UNIT;
+    }
+    else{
+        // 経過時間(マイクロ秒)に応じて補充
+        elapsed = (now->tv_sec  - bucket->update_time.tv_sec) * 1000000
+                + (now->tv_nsec - bucket->update_time.tv_nsec) / 1000;
+        bucket->tokens = min(bucket->tokens + elapsed * rate, burst * TUNNEL_TOKEN_UNIT);
+    }
+    bucket->update_time = *now;
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief Fragment Needed送信レート判定関数
+//!
+//! 送信先アドレス毎と全体のトークンバケットで送信可否を判定し、
+//! 送信可の場合は双方のトークンを1つずつ消費する。
+//!
+//! @param [in]  saddr  Fragment Needed送信のトリガとなったパケットの送信元アドレス
+//!
+//! @retval true   送信可
+//! @retval false  送信不可(レート超過)
+///////////////////////////////////////////////////////////////////////////////
+static bool tunnel_frag_need_rate_check(const uint32_t saddr)
+{
+    // ローカル変数宣言
+    struct tunnel_frag_need_source* entry;
+    struct timespec                 now;
+    uint32_t                        hash;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // 送信元アドレスからエントリを決定
+    hash  = saddr * 2654435761u;
+    entry = &tunnel_frag_need_source[(hash >> 16) & (TUNNEL_FRAG_NEED_SOURCE_SIZE - 1)];
+
+    if(!entry->valid || (entry->saddr != saddr)){
+        // 新規の送信先は満タンのバケットから開始(衝突した古いエントリは上書き)
+        entry->saddr              = saddr;
+        entry->valid              = true;
+        entry->bucket.tokens      = TUNNEL_FRAG_NEED_BURST_SOURCE * TUNNEL_TOKEN_UNIT;
+        entry->bucket.update_time = now;
+    }
+    else{
+        tunnel_token_bucket_refill(&entry->bucket, TUNNEL_FRAG_NEED_RATE_SOURCE, TUNNEL_FRAG_NEED_BURST_SOURCE, &now);
+    }
+    tunnel_token_bucket_refill(&tunnel_frag_need_global, TUNNEL_FRAG_NEED_RATE_GLOBAL, TUNNEL_FRAG_NEED_BURST_GLOBAL, &now);
+
+    if((entry->bucket.tokens < TUNNEL_TOKEN_UNIT) || (tunnel_frag_need_global.tokens < TUNNEL_TOKEN_UNIT)){
+        return false;
+    }
+
+    entry->bucket.tokens           -= TUNNEL_TOKEN_UNIT;
+    tunnel_frag_need_global.tokens -= TUNNEL_TOKEN_UNIT;
+
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ICMPエラーパケット送信可否判定
 //!
@@ -1100,3 +2430,58 @@ static bool tunnel_check_icmp_error_send(const struct iphdr* p_ip4)
 
     return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 処理時間計測開始関数
+//!
+//! 設定したパケット間隔(latency_sample_rate)毎に処理時間の計測を開始する。
+//! 計測対象外のパケットでは時刻を取得しない。
+//!
+//! @param [in]     handler       M46Eハンドラ
+//! @param [in,out] sample_count  前回計測からのパケット数
+//! @param [out]    start         計測開始時刻
+//!
+//! @retval true   計測対象
+//! @retval false  計測対象外
+///////////////////////////////////////////////////////////////////////////////
+static inline bool tunnel_latency_start(struct m46e_handler_t* handler, int* sample_count, struct timespec* start)
+{
+    // ローカル変数宣言
+    int sample_rate = handler->conf->general->latency_sample_rate;
+
+    if((sample_rate <= 0) || (++(*sample_count) < sample_rate)){
+        return false;
+    }
+
+    *sample_count = 0;
+    clock_gettime(CLOCK_MONOTONIC, start);
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 処理時間計測終了関数
+//!
+//! 計測開始からの経過時間を自スレッドの処理時間ヒストグラムに記録する。
+//!
+//! @param [in]     handler       M46Eハンドラ
+//! @param [in]     start         計測開始時刻
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static inline void tunnel_latency_end(struct m46e_handler_t* handler, const struct timespec* start)
+{
+    // ローカル変数宣言
+    struct timespec end;
+    int64_t         nsec;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    nsec = (int64_t)(end.tv_sec - start->tv_sec) * 1000000000 + (end.tv_nsec - start->tv_nsec);
+    if(nsec < 0){
+        nsec = 0;
+    }
+    m46e_add_latency(handler->stat_info, nsec);
+
+    return;
+}
@@ -3,6 +3,8 @@
 /* 機能概要   : 共通関数 ソースファイル                                       */
 /* 修正履歴   : 2011.12.20 T.Maeda 新規作成                                   */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent チェックサム計算のSIMD化                     */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -18,6 +20,9 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "m46eapp_util.h"
 
@@ -204,6 +209,245 @@ bool m46e_util_is_broadcast_mac(const unsigned char* mac_addr)
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// チェックサム計算
+//
+// 1の補数和は2^16≡1 (mod 0xffff)なので、16bitより広い単位で加算してから
+// 16bitに畳み込んでも16bit単位で加算した場合と同じ値になる。
+// 加算処理はCPUの対応命令に合わせてm46e_util_checksum_init()で選択する。
+// (未初期化の場合は64bitの汎用処理を使用する)
+////////////////////////////////////////////////////////////////////////////////
+
+//! SIMD処理で32bitの部分和があふれないように畳み込むまでの最大ループ数
+#define UTIL_CSUM_SIMD_LOOP_MAX  0x8000
+
+//! 加算処理の型(戻り値は16bit単位の和と同じ剰余を持つ64bit値)
+typedef uint64_t (*util_csum_add_func)(const unsigned char* buf, size_t len);
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+static uint64_t util_csum_add_scalar(const unsigned char* buf, size_t len);
+#if defined(__x86_64__) || defined(__i386__)
+static uint64_t util_csum_add_sse2(const unsigned char* buf, size_t len);
+static uint64_t util_csum_add_avx2(const unsigned char* buf, size_t len);
+#endif
+
+//! 使用する加算処理
+static util_csum_add_func util_csum_add = util_csum_add_scalar;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム計算初期化関数
+//!
+//! CPUの対応命令(cpuid)を判定し、チェックサムの加算処理を選択する。
+//! スレッド起動前の起動処理で1度だけ呼び出すこと。
+//!
+//! @param なし
+//!
+//! @return 選択した加算処理の名前
+///////////////////////////////////////////////////////////////////////////////
+const char* m46e_util_checksum_init(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2")){
+        util_csum_add = util_csum_add_avx2;
+        return "avx2";
+    }
+    if(__builtin_cpu_supports("sse2")){
+        util_csum_add = util_csum_add_sse2;
+        return "sse2";
+    }
+#endif
+    util_csum_add = util_csum_add_scalar;
+
+    return "scalar64";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム加算処理選択関数
+//!
+//! 名前で指定した加算処理を強制的に選択する。(性能測定/試験用)<br/>
+//! CPUが対応していない加算処理は選択しない。
+//! スレッド起動前に呼び出すこと。
+//!
+//! @param [in]  name  加算処理の名前("scalar64"/"sse2"/"avx2")
+//!
+//! @retval true   選択成功
+//! @retval false  選択失敗(未知の名前、またはCPU非対応)
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_util_checksum_select(const char* name)
+{
+    // 引数チェック
+    if(name == NULL){
+        return false;
+    }
+
+    if(strcmp(name, "scalar64") == 0){
+        util_csum_add = util_csum_add_scalar;
+        return true;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if((strcmp(name, "avx2") == 0) && __builtin_cpu_supports("avx2")){
+        util_csum_add = util_csum_add_avx2;
+        return true;
+    }
+    if((strcmp(name, "sse2") == 0) && __builtin_cpu_supports("sse2")){
+        util_csum_add = util_csum_add_sse2;
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム畳み込み関数
+//!
+//! 64bitの和を16bitに畳み込み、1の補数を返す。
+//!
+//! @param [in]  sum  加算処理の結果
+//!
+//! @return チェックサム値
+///////////////////////////////////////////////////////////////////////////////
+static inline unsigned short util_csum_fold(uint64_t sum)
+{
+    sum  = (sum & 0xffffffff) + (sum >> 32);
+    sum  = (sum & 0xffffffff) + (sum >> 32);
+    sum  = (sum & 0xffff) + (sum >> 16);
+    sum  = (sum & 0xffff) + (sum >> 16);
+
+    return ~sum;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム加算関数(64bit汎用)
+//!
+//! 8byte単位で読み込み、32bit毎に64bitの和へ加算する。
+//! 奇数長の末尾1byteは従来どおり下位byteとして加算する。
+//!
+//! @param [in]  buf  加算するデータの先頭アドレス
+//! @param [in]  len  加算するデータのサイズ
+//!
+//! @return 加算結果
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t util_csum_add_scalar(const unsigned char* buf, size_t len)
+{
+    uint64_t sum = 0;
+    uint64_t val64;
+    uint32_t val32;
+    uint16_t val16;
+
+    while(len >= 8){
+        memcpy(&val64, buf, sizeof(val64));
+        sum += (val64 & 0xffffffff) + (val64 >> 32);
+        buf += 8;
+        len -= 8;
+    }
+    if(len >= 4){
+        memcpy(&val32, buf, sizeof(val32));
+        sum += val32;
+        buf += 4;
+        len -= 4;
+    }
+    if(len >= 2){
+        memcpy(&val16, buf, sizeof(val16));
+        sum += val16;
+        buf += 2;
+        len -= 2;
+    }
+    if(len){
+        sum += *buf;
+    }
+
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム加算関数(SSE2)
+//!
+//! 16byte単位で16bitワードを32bitに拡張して加算する。
+//! 16byte未満の残りは64bit汎用処理で加算する。
+//!
+//! @param [in]  buf  加算するデータの先頭アドレス
+//! @param [in]  len  加算するデータのサイズ
+//!
+//! @return 加算結果
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("sse2")))
+static uint64_t util_csum_add_sse2(const unsigned char* buf, size_t len)
+{
+    uint64_t sum  = 0;
+    __m128i  zero = _mm_setzero_si128();
+    uint32_t part[4];
+
+    while(len >= 16){
+        __m128i acc  = _mm_setzero_si128();
+        int     loop = 0;
+
+        // 32bitレーンに1ループあたり最大0x1fffe加算されるので、あふれる前に畳み込む
+        while((len >= 16) && (loop < UTIL_CSUM_SIMD_LOOP_MAX)){
+            __m128i val = _mm_loadu_si128((const __m128i*)buf);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(val, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(val, zero));
+            buf += 16;
+            len -= 16;
+            loop++;
+        }
+
+        _mm_storeu_si128((__m128i*)part, acc);
+        sum += (uint64_t)part[0] + part[1] + part[2] + part[3];
+    }
+
+    return sum + util_csum_add_scalar(buf, len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム加算関数(AVX2)
+//!
+//! 32byte単位で16bitワードを32bitに拡張して加算する。
+//! 32byte未満の残りは64bit汎用処理で加算する。
+//!
+//! @param [in]  buf  加算するデータの先頭アドレス
+//! @param [in]  len  加算するデータのサイズ
+//!
+//! @return 加算結果
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static uint64_t util_csum_add_avx2(const unsigned char* buf, size_t len)
+{
+    uint64_t sum  = 0;
+    __m256i  zero = _mm256_setzero_si256();
+    uint32_t part[8];
+
+    while(len >= 32){
+        __m256i acc  = _mm256_setzero_si256();
+        int     loop = 0;
+
+        // 32bitレーンに1ループあたり最大0x1fffe加算されるので、あふれる前に畳み込む
+        while((len >= 32) && (loop < UTIL_CSUM_SIMD_LOOP_MAX)){
+            __m256i val = _mm256_loadu_si256((const __m256i*)buf);
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(val, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(val, zero));
+            buf += 32;
+            len -= 32;
+            loop++;
+        }
+
+        _mm256_storeu_si256((__m256i*)part, acc);
+        for(int i = 0; i < 8; i++){
+            sum += part[i];
+        }
+    }
+
+    return sum + util_csum_add_scalar(buf, len);
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief チェックサム計算関数
 //!
@@ -216,26 +460,18 @@ bool m46e_util_is_broadcast_mac(const unsigned char* mac_addr)
 ///////////////////////////////////////////////////////////////////////////////
 unsigned short m46e_util_checksum(unsigned short *buf, int size)
 {
-    unsigned long sum = 0;
-
-    while (size > 1) {
-        sum += *buf++;
-        size -= 2;
+    if(size <= 0){
+        return util_csum_fold(0);
     }
-    if (size){
-        sum += *(u_int8_t *)buf;
-    }
-
-    sum  = (sum & 0xffff) + (sum >> 16);	/* add overflow counts */
-    sum  = (sum & 0xffff) + (sum >> 16);	/* once again */
 
-    return ~sum;
+    return util_csum_fold(util_csum_add((const unsigned char*)buf, size));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief チェックサム計算関数(複数ブロック対応)
 //!
 //! 引数で指定されたコードとサイズからチェックサム値を計算して返す。
+//! (各ブロックは従来どおり独立に16bit単位で加算する)
 //!
 //! @param [in]  vec      チェックサムを計算するコード配列の先頭アドレス
 //! @param [in]  vec_size チェックサムを計算するコード配列の要素数
@@ -244,24 +480,65 @@ unsigned short m46e_util_checksum(unsigned short *buf, int size)
 ///////////////////////////////////////////////////////////////////////////////
 unsigned short m46e_util_checksumv(struct iovec* vec, int vec_size)
 {
-    int i;
-    unsigned long sum = 0;
+    int      i;
+    uint64_t sum = 0;
 
     for(i=0; i<vec_size; i++){
-        unsigned short* buf  = (unsigned short*)vec[i].iov_base;
-        int             size = vec[i].iov_len;
+        sum += util_csum_add((const unsigned char*)vec[i].iov_base, vec[i].iov_len);
+    }
 
-        while (size > 1) {
-            sum += *buf++;
-            size -= 2;
-        }
-        if (size){
-            sum += *(u_int8_t *)buf;
+    return util_csum_fold(sum);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6拡張ヘッダ読み飛ばし関数
+//!
+//! IPv6ヘッダに続く拡張ヘッダ(Hop-by-Hop Options、Routing、
+//! Destination Options、Authentication)を読み飛ばし、
+//! それ以外のヘッダ(上位層プロトコルまたはFragmentヘッダ)の位置を返す。
+//!
+//! @param [in]     data    IPv6ヘッダの直後のデータ
+//! @param [in]     len     データの長さ
+//! @param [in,out] nxt     [in]先頭のヘッダ種別、[out]読み飛ばし後のヘッダ種別
+//! @param [out]    offset  読み飛ばし後のヘッダのデータ先頭からのオフセット
+//!
+//! @retval true   正常終了
+//! @retval false  拡張ヘッダがデータ長を超えている
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_util_ipv6_skip_exthdr(const uint8_t* data, const size_t len, uint8_t* nxt, size_t* offset)
+{
+    // ローカル変数宣言
+    size_t pos = 0;
+
+    while(1){
+        size_t hdr_len;
+
+        switch(*nxt){
+        case IPPROTO_HOPOPTS:
+        case IPPROTO_ROUTING:
+        case IPPROTO_DSTOPTS:
+            if((pos + 2) > len){
+                return false;
+            }
+            hdr_len = (data[pos + 1] + 1) * 8;
+            break;
+        case IPPROTO_AH:
+            if((pos + 2) > len){
+                return false;
+            }
+            hdr_len = (data[pos + 1] + 2) * 4;
+            break;
+        default:
+            // 拡張ヘッダ以外なので終了
+            *offset = pos;
+            return true;
         }
-    }
 
-    sum  = (sum & 0xffff) + (sum >> 16);	/* add overflow counts */
-    sum  = (sum & 0xffff) + (sum >> 16);	/* once again */
+        if((pos + hdr_len) > len){
+            return false;
+        }
 
-    return ~sum;
+        *nxt = data[pos];
+        pos += hdr_len;
+    }
 }
@@ -3,6 +3,9 @@
 /* 機能概要   : 共通関数 ヘッダファイル                                       */
 /* 修正履歴   : 2011.12.20 T.Maeda 新規作成                                   */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent フラグメント時のチェックサム差分更新         */
+/*              2026.10.18 agent チェックサム計算のSIMD化                     */
+/*              2026.10.18 agent 外側IPv6フラグメント再構築追加               */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2011-2016                */
 /******************************************************************************/
@@ -10,6 +13,7 @@
 #define __M46EAPP_UTIL_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/uio.h>
 
 struct in_addr;
@@ -31,7 +35,34 @@ bool m46e_util_get_ipv4_addr(const char* dev, struct in_addr* addr);
 bool m46e_util_get_ipv4_mask(const char* dev, struct in_addr* mask);
 bool m46e_util_get_ipv6_addr(const char* dev, struct in6_addr* addr);
 bool m46e_util_is_broadcast_mac(const unsigned char* mac_addr);
+const char* m46e_util_checksum_init(void);
+bool m46e_util_checksum_select(const char* name);
 unsigned short m46e_util_checksum(unsigned short *buf, int size);
 unsigned short m46e_util_checksumv(struct iovec vec[], int vec_size);
+bool m46e_util_ipv6_skip_exthdr(const uint8_t* data, const size_t len, uint8_t* nxt, size_t* offset);
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief チェックサム差分更新関数
+//!
+//! 16bitワードの変更に合わせてチェックサム値を差分で更新する。(RFC1624 式3)<br/>
+//! HC' = ~(~HC + ~m + m')
+//! (ワードはチェックサム計算時と同じバイトオーダで指定すること)
+//!
+//! @param [in]  check    更新前のチェックサム値
+//! @param [in]  old_val  変更前のワード値
+//! @param [in]  new_val  変更後のワード値
+//!
+//! @return 更新後のチェックサム値
+///////////////////////////////////////////////////////////////////////////////
+static inline unsigned short m46e_util_checksum_update(unsigned short check, unsigned short old_val, unsigned short new_val)
+{
+    unsigned long sum;
+
+    sum  = (unsigned short)~check + (unsigned short)~old_val + new_val;
+    sum  = (sum & 0xffff) + (sum >> 16);	/* add overflow counts */
+    sum  = (sum & 0xffff) + (sum >> 16);	/* once again */
+
+    return ~sum;
+}
 
 #endif // __M46EAPP_UTIL_H__
@@ -8,6 +8,9 @@
 /*              2013.11.18 H.Koganemaru Usage表示修正                         */
 /*              2014.01.21 M.Iwatsubo M46E-PR外部連携機能追加                 */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2012-2016                */
 /******************************************************************************/
@@ -40,6 +43,8 @@ static const struct option options[] = {
     {"name",  required_argument, 0, 'n'},
     {"help",  no_argument,       0, 'h'},
     {"usage", no_argument,       0, 'h'},
+    {"watch", required_argument, 0, 'w'},
+    {"json",  no_argument,       0, 'j'},
     {0, 0, 0, 0}
 };
 
@@ -76,6 +81,8 @@ static const struct command_arg command_args[] = {
     {"show",    "pr",     M46E_SHOW_PR_ENTRY},
     {"load",    "pr",     M46E_LOAD_PR_COMMAND},
     {"show",     "route", M46E_SHOW_ROUTE},
+    {"show",     "prof",  M46E_SHOW_PROFILE},
+    {"show",     "drops", M46E_SHOW_DROPS},
     {NULL,       NULL,    M46E_COMMAND_MAX}
 };
 
@@ -108,7 +115,8 @@ static void usage(void)
 "                    set pmtumd | set pmtutm | set tunmtu | set devmtu |\n"
 "                    add device | del device | add pr     | del pr     |\n"
 "                    delall pr  | enable pr  | disable pr | show pr    |\n"
-"                    load pr    | shutdown   | restart }\n"
+"                    load pr    | show prof  | show drops | shutdown   |\n"
+"                    restart }\n"
 
 "where  OPTIONS :=\n"
 "       exec inet  : 'command opt1 opt2...'\n"
@@ -125,12 +133,14 @@ static void usage(void)
 "       del pr     :  ipv4_network_address/prefix_len\n"
 "       enable pr  :  ipv4_network_address/prefix_len\n"
 "       disable pr :  ipv4_network_address/prefix_len\n"
-"       load pr    :  file_name"
+"       load pr    :  file_name\n"
+"       show stat  :  [ --watch interval [ --json ] ]"
 "\n"
 "// m46ectl command explanations // \n"
 "  exec shell : Execute shell into the specified PLANE_NAME\n"
 "  exec inet  : Execute command at stub network side specified PLANE_NAME\n"
 "  show stat  : Show the statistics information in specified PLANE_NAME\n"
+"               (with --watch, keep the connection and print the deltas every interval seconds)\n"
 "  show conf  : Show the configuration in specified PLANE_NAME\n"
 "  show pmtu  : Show the Path MTU Discovery table in specified PLANE_NAME\n"
 "  set debug  : Set the debug log printing mode specified PLANE_NAME\n"
@@ -149,6 +159,8 @@ static void usage(void)
 "  disable pr : Disable the M46E-PR Entry at M46E-PR Table specified PLANE_NAME\n"
 "  show pr    : Show the M46E-PR Table specified PLANE_NAME\n"
 "  load pr    : Load M46E-PR Command file specified PLANE_NAME\n"
+"  show prof  : Show the per-stage cycle profile of packet forwarding in specified PLANE_NAME\n"
+"  show drops : Show the recently dropped packets in specified PLANE_NAME\n"
 "  shutdown   : Shutting down the application specified PLANE_NAME\n"
 "  restart    : Restart the application specified PLANE_NAME\n"
 "\n"
@@ -504,7 +516,50 @@ static void usage_show_conf(void)
 static void usage_show_stat(void)
 {
     fprintf(stderr,
-"Usage: m46ectl -n PLANE_NAME show stat\n "
+"Usage: m46ectl -n PLANE_NAME show stat [ --watch interval [ --json ] ]\n "
+"\n"
+"       interval : 1-3600 (seconds)\n"
+"       --json   : print the deltas of all counters as one JSON object per line\n"
+"\n"
+    );
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @ステージ別サイクル計測結果表示コマンド凡例表示関数
+//!
+//! ステージ別サイクル計測結果表示コマンド実行時の引数が不正だった場合などに
+//! 凡例を表示する。
+//!
+//! @param なし
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage_show_prof(void)
+{
+    fprintf(stderr,
+"Usage: m46ectl -n PLANE_NAME show prof\n "
+"\n"
+    );
+
+    return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @破棄パケット記録表示コマンド凡例表示関数
+//!
+//! 破棄パケット記録表示コマンド実行時の引数が不正だった場合などに
+//! 凡例を表示する。
+//!
+//! @param なし
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage_show_drops(void)
+{
+    fprintf(stderr,
+"Usage: m46ectl -n PLANE_NAME show drops\n "
 "\n"
     );
 
@@ -544,6 +599,8 @@ static bool is_exit(const char read_char);
 int main(int argc, char* argv[])
 {
     char* name         = NULL;
+    char* watch        = NULL;
+    bool  json         = false;
     int   option_index = 0;
 
     // 引数チェック
@@ -563,6 +620,14 @@ int main(int argc, char* argv[])
             exit(EXIT_SUCCESS);
             break;
 
+        case 'w':
+            watch = optarg;
+            break;
+
+        case 'j':
+            json = true;
+            break;
+
         default:
             usage();
             exit(EINVAL);
@@ -820,10 +885,44 @@ int main(int argc, char* argv[])
 
     // 統計情報表示
     if (command.code == M46E_SHOW_STATISTIC) {
-        if (argc != SHOW_STAT_OPE_ARGS)  {
+        // --watch/--jsonはgetoptで解析済みなので、それ以外の引数の数をチェック
+        if ((argc - optind) != SHOW_STAT_OPE_NUM)  {
             usage_show_stat();
             exit(EINVAL);
         }
+
+        if (watch != NULL) {
+            result = m46e_command_stat_watch_option(watch, json, &command);
+            if (!result) {
+                usage_show_stat();
+                exit(EINVAL);
+            }
+        }
+        else if (json) {
+            usage_show_stat();
+            exit(EINVAL);
+        }
+    }
+    else if ((watch != NULL) || json) {
+        // --watch/--jsonは統計情報表示でのみ指定可能
+        usage();
+        exit(EINVAL);
+    }
+
+    // ステージ別サイクル計測結果表示
+    if (command.code == M46E_SHOW_PROFILE) {
+        if (argc != SHOW_PROF_OPE_ARGS)  {
+            usage_show_prof();
+            exit(EINVAL);
+        }
+    }
+
+    // 破棄パケット記録表示
+    if (command.code == M46E_SHOW_DROPS) {
+        if (argc != SHOW_DROPS_OPE_ARGS)  {
+            usage_show_drops();
+            exit(EINVAL);
+        }
     }
 
     // Path MTU Discovery Table表示
@@ -884,7 +983,8 @@ int main(int argc, char* argv[])
 
     int ret;
     int pty;
-    char buf[256];
+    // 統計情報の差分通知は1回分を1レコードで受信するので、その最大長とする
+    char buf[M46E_STAT_WATCH_RECORD_MAX];
 
     ret = m46e_socket_send_cred(fd, command.code, &command.req, sizeof(command.req));
     if(ret <= 0){
@@ -932,6 +1032,8 @@ int main(int argc, char* argv[])
     case M46E_SHOW_PR_ENTRY:
     case M46E_LOAD_PR_COMMAND:
     case M46E_SHOW_ROUTE:
+    case M46E_SHOW_PROFILE:
+    case M46E_SHOW_DROPS:
 
         // 出力結果がソケット経由で送信されてくるので、そのまま標準出力に書き込む
         while(1){
@@ -5,6 +5,7 @@
 /*              2013.09.12 H.Koganemaru 動的定義変更機能追加                  */
 /*              2013.10.03 Y.Shibata  M46E-PR拡張機能                         */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2013-2016                */
 /******************************************************************************/
@@ -1024,6 +1025,42 @@ bool m46e_command_pmtutm_set_option(int num, char* opt[], struct m46e_command_t*
 
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報差分通知オプション設定処理関数
+//!
+//! 統計情報表示の差分通知間隔と出力形式を設定する。
+//!
+//! @param [in]  interval   差分通知間隔(秒)の文字列
+//! @param [in]  json       JSON形式で通知するかどうか
+//! @param [out] command    コマンド構造体
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_command_stat_watch_option(const char* interval, const bool json, struct m46e_command_t* command)
+{
+
+    // 内部変数
+    bool    result = false;
+
+    // 引数チェック
+    if ((interval == NULL) || (command == NULL)){
+        _D_(printf("m46e_command_stat_watch_option Parameter Check NG.\n");)
+        return false;
+    }
+
+    // オプション解析
+    result = parse_int(interval, &command->req.show_stat.interval,
+                           OPT_STAT_WATCH_INTERVAL_MIN, OPT_STAT_WATCH_INTERVAL_MAX);
+    if (!result) {
+        return result;
+    }
+    command->req.show_stat.json = json;
+
+    return result;
+
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 強制フラグメントモード設定コマンドオプション設定処理関数
 //!
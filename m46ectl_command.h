@@ -6,6 +6,10 @@
 /*              2013.10.03 Y.Shibata  M46E-PR拡張機能                         */
 /*              2014.01.21 M.Iwatsubo M46E-PR外部連携機能                     */
 /*              2016.04.15 H.Koganemaru 名称変更に伴う修正                    */
+/*              2026.10.18 agent プレフィックス毎PMTU保持追加                 */
+/*              2026.10.18 agent ステージ毎サイクル計測追加                   */
+/*              2026.10.18 agent 廃棄理由トレース追加                         */
+/*              2026.10.18 agent 統計情報差分通知追加                         */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2013-2016                */
 /******************************************************************************/
@@ -47,7 +51,7 @@
 #define OPT_PMTUD_MODE_MIN 0
 
 //! PMTUモードの最大値
-#define OPT_PMTUD_MODE_MAX 2
+#define OPT_PMTUD_MODE_MAX 3
 
 //! PMTUタイマの最小値
 #define OPT_PMTUD_EXPIRE_TIME_MIN 301
@@ -55,6 +59,12 @@
 //! PMTUタイマの最大値
 #define OPT_PMTUD_EXPIRE_TIME_MAX 65535
 
+//! 統計情報差分通知間隔の最小値
+#define OPT_STAT_WATCH_INTERVAL_MIN 1
+
+//! 統計情報差分通知間隔の最大値
+#define OPT_STAT_WATCH_INTERVAL_MAX 3600
+
 //! トンネルデバイスMTU長の最小値
 #define OPT_TUNNEL_MTU_MIN 1280
 
@@ -124,8 +134,14 @@
 //! Config情報表示コマンド引数
 #define SHOW_CONF_OPE_ARGS 5
 
-//! 統計情報表示コマンド引数
-#define SHOW_STAT_OPE_ARGS 5
+//! 統計情報表示コマンド引数(--watch/--jsonを除いたコマンド名以降の数)
+#define SHOW_STAT_OPE_NUM 2
+
+//! ステージ別サイクル計測結果表示コマンド引数
+#define SHOW_PROF_OPE_ARGS 5
+
+//! 破棄パケット記録表示コマンド引数
+#define SHOW_DROPS_OPE_ARGS 5
 
 //! Path MTU Discovery Table表示コマンド引数
 #define SHOW_PMTU_OPE_ARGS 5
@@ -163,6 +179,7 @@ bool m46e_command_dbglog_set_option(int num, char* opt[], struct m46e_command_t*
 bool m46e_command_pmtumd_set_option(int num, char* opt[], struct m46e_command_t* command);
 bool m46e_command_pmtutm_set_option(int num, char* opt[], struct m46e_command_t* command);
 bool m46e_command_ffrag_set_option(int num, char* opt[], struct m46e_command_t* command);
+bool m46e_command_stat_watch_option(const char* interval, const bool json, struct m46e_command_t* command);
 bool m46e_command_defgw_set_option(int num, char* opt[], struct m46e_command_t* command);
 bool m46e_command_tunmtu_set_option(int num, char* opt[], struct m46e_command_t* command);
 bool m46e_command_devmtu_set_option(int num, char* opt[], struct m46e_command_t* command);